@@ -38,3 +38,46 @@ function(build_modules)
         add_custom_target(${build_modules_TARGET} DEPENDS ${depends})
     endif()
 endfunction()
+
+# Build a mechanism catalogue, a shared library that can be loaded at run time,
+# for each mechanism. The catalogue of mech is ${mech}${MECH_SUFFIX}.so in
+# DEST_DIR, and provides the mechanism ${mech}${MECH_SUFFIX} to the multicore
+# backends. The target TARGET depends on all the catalogues.
+#
+# An executable that loads catalogues has to export its symbols, i.e. have the
+# ENABLE_EXPORTS property, so that the catalogues use its memory arena.
+function(build_catalogues)
+    cmake_parse_arguments(build_catalogues "" "TARGET;SOURCE_DIR;DEST_DIR;MECH_SUFFIX" "MODCC_FLAGS" ${ARGN})
+
+    foreach(mech ${build_catalogues_UNPARSED_ARGUMENTS})
+        set(name "${mech}${build_catalogues_MECH_SUFFIX}")
+        set(mod "${build_catalogues_SOURCE_DIR}/${mech}.mod")
+        set(cpp "${CMAKE_CURRENT_BINARY_DIR}/${name}_catalogue.cpp")
+
+        set(depends "${mod}")
+        if(NOT use_external_modcc)
+            list(APPEND depends modcc)
+        endif()
+
+        add_custom_command(
+            OUTPUT "${cpp}"
+            DEPENDS ${depends}
+            WORKING_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}"
+            COMMAND ${modcc} ${build_catalogues_MODCC_FLAGS} -t cpu --catalogue -m "${name}" -o "${cpp}" ${mod}
+        )
+        set_source_files_properties("${cpp}" PROPERTIES GENERATED TRUE)
+
+        add_library(${name}_catalogue MODULE "${cpp}")
+        set_target_properties(${name}_catalogue
+            PROPERTIES
+            PREFIX ""
+            OUTPUT_NAME "${name}"
+            LIBRARY_OUTPUT_DIRECTORY "${build_catalogues_DEST_DIR}"
+        )
+        list(APPEND all_catalogues ${name}_catalogue)
+    endforeach()
+
+    if (build_catalogues_TARGET)
+        add_custom_target(${build_catalogues_TARGET} DEPENDS ${all_catalogues})
+    endif()
+endfunction()
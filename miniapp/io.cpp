@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstdlib>
 #include <exception>
 #include <fstream>
 #include <istream>
@@ -123,10 +124,14 @@ cl_options read_options(int argc, char** argv, bool allow_write) {
         false,      // all_to_all
         false,      // ring
         1,          // group_size
+        false,      // depth_first
         false,      // probe_soma_only
         0.0,        // probe_ratio
         "trace_",   // trace_prefix
         util::nothing,  // trace_max_gid
+        false,      // dry_run
+        "",         // mechanism_path
+        0.,         // spike_time_quantum
 
         // spike_output_parameters:
         false,      // spike output
@@ -140,6 +145,12 @@ cl_options read_options(int argc, char** argv, bool allow_write) {
     cl_options options;
     std::string save_file = "";
 
+    // The mechanism path defaults to the environment, like PATH.
+    std::string env_mechanism_path;
+    if (auto env = std::getenv("NMC_MECHANISM_PATH")) {
+        env_mechanism_path = env;
+    }
+
     // Parse command line arguments.
     try {
         CustomCmdLine cmd("nest mc miniapp harness", "0.1");
@@ -177,6 +188,8 @@ cl_options read_options(int argc, char** argv, bool allow_write) {
         TCLAP::ValueArg<uint32_t> group_size_arg(
             "g", "group-size", "number of cells per cell group",
             false, defopts.compartments_per_segment, "integer", cmd);
+        TCLAP::SwitchArg depth_first_arg(
+            "N", "depth-first", "number the compartments of each cell depth first", cmd, false);
         TCLAP::ValueArg<double> probe_ratio_arg(
             "p", "probe-ratio", "proportion between 0 and 1 of cells to probe",
             false, defopts.probe_ratio, "proportion", cmd);
@@ -188,6 +201,16 @@ cl_options read_options(int argc, char** argv, bool allow_write) {
         TCLAP::ValueArg<util::optional<unsigned>> trace_max_gid_arg(
             "T", "trace-max-gid", "only trace probes on cells up to and including <gid>",
             false, defopts.trace_max_gid, "gid", cmd);
+        TCLAP::SwitchArg dry_run_arg(
+            "D", "dry-run", "construct the model and report its memory use, without running it", cmd, false);
+        TCLAP::ValueArg<std::string> mechanism_path_arg(
+            "L", "mechanism-path",
+            "load the mechanism catalogues in the colon separated directories <path>, by default $NMC_MECHANISM_PATH",
+            false, env_mechanism_path, "path", cmd);
+        TCLAP::ValueArg<double> spike_time_quantum_arg(
+            "Q", "spike-time-quantum",
+            "exchange spike times quantized to multiples of <time> ms, if spikes are packed",
+            false, defopts.spike_time_quantum, "time", cmd);
         TCLAP::SwitchArg spike_output_arg(
             "f","spike_file_output","save spikes to file", cmd, false);
 
@@ -195,6 +218,7 @@ cl_options read_options(int argc, char** argv, bool allow_write) {
         cmd.parse(argc, argv);
 
         options = defopts;
+        options.mechanism_path = env_mechanism_path;
 
         std::string ifile_name = ifile_arg.getValue();
         if (ifile_name != "") {
@@ -215,10 +239,14 @@ cl_options read_options(int argc, char** argv, bool allow_write) {
                     update_option(options.all_to_all, fopts, "all_to_all");
                     update_option(options.ring, fopts, "ring");
                     update_option(options.group_size, fopts, "group_size");
+                    update_option(options.depth_first, fopts, "depth_first");
                     update_option(options.probe_ratio, fopts, "probe_ratio");
                     update_option(options.probe_soma_only, fopts, "probe_soma_only");
                     update_option(options.trace_prefix, fopts, "trace_prefix");
                     update_option(options.trace_max_gid, fopts, "trace_max_gid");
+                    update_option(options.dry_run, fopts, "dry_run");
+                    update_option(options.mechanism_path, fopts, "mechanism_path");
+                    update_option(options.spike_time_quantum, fopts, "spike_time_quantum");
 
                     // Parameters for spike output
                     update_option(options.spike_file_output, fopts, "spike_file_output");
@@ -250,16 +278,24 @@ cl_options read_options(int argc, char** argv, bool allow_write) {
         update_option(options.all_to_all, all_to_all_arg);
         update_option(options.ring, ring_arg);
         update_option(options.group_size, group_size_arg);
+        update_option(options.depth_first, depth_first_arg);
         update_option(options.probe_ratio, probe_ratio_arg);
         update_option(options.probe_soma_only, probe_soma_only_arg);
         update_option(options.trace_prefix, trace_prefix_arg);
         update_option(options.trace_max_gid, trace_max_gid_arg);
+        update_option(options.dry_run, dry_run_arg);
+        update_option(options.mechanism_path, mechanism_path_arg);
+        update_option(options.spike_time_quantum, spike_time_quantum_arg);
         update_option(options.spike_file_output, spike_output_arg);
 
         if (options.all_to_all && options.ring) {
             throw usage_error("can specify at most one of --ring and --all-to-all");
         }
 
+        if (options.spike_time_quantum<0) {
+            throw usage_error("the spike time quantum can not be negative");
+        }
+
         if (options.group_size<1) {
             throw usage_error("minimum of one cell per group");
         }
@@ -286,6 +322,7 @@ cl_options read_options(int argc, char** argv, bool allow_write) {
                 fopts["all_to_all"] = options.all_to_all;
                 fopts["ring"] = options.ring;
                 fopts["group_size"] = options.group_size;
+                fopts["depth_first"] = options.depth_first;
                 fopts["probe_ratio"] = options.probe_ratio;
                 fopts["probe_soma_only"] = options.probe_soma_only;
                 fopts["trace_prefix"] = options.trace_prefix;
@@ -295,6 +332,9 @@ cl_options read_options(int argc, char** argv, bool allow_write) {
                 else {
                     fopts["trace_max_gid"] = nullptr;
                 }
+                fopts["dry_run"] = options.dry_run;
+                fopts["mechanism_path"] = options.mechanism_path;
+                fopts["spike_time_quantum"] = options.spike_time_quantum;
                 fid << std::setw(3) << fopts << "\n";
 
             }
@@ -320,6 +360,7 @@ std::ostream& operator<<(std::ostream& o, const cl_options& options) {
     o << "  all to all network   : " << (options.all_to_all ? "yes" : "no") << "\n";
     o << "  ring network         : " << (options.ring ? "yes" : "no") << "\n";
     o << "  group size           : " << options.group_size << "\n";
+    o << "  depth first numbering: " << (options.depth_first ? "yes" : "no") << "\n";
     o << "  probe ratio          : " << options.probe_ratio << "\n";
     o << "  probe soma only      : " << (options.probe_soma_only ? "yes" : "no") << "\n";
     o << "  trace prefix         : " << options.trace_prefix << "\n";
@@ -328,6 +369,9 @@ std::ostream& operator<<(std::ostream& o, const cl_options& options) {
        o << *options.trace_max_gid;
     }
     o << "\n";
+    o << "  dry run              : " << (options.dry_run ? "yes" : "no") << "\n";
+    o << "  mechanism path       : " << options.mechanism_path << "\n";
+    o << "  spike time quantum   : " << options.spike_time_quantum << "\n";
 
     return o;
 }
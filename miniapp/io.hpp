@@ -23,11 +23,22 @@ struct cl_options {
     bool all_to_all;
     bool ring;
     uint32_t group_size;
+    bool depth_first;
     bool probe_soma_only;
     double probe_ratio;
     std::string trace_prefix;
     util::optional<unsigned> trace_max_gid;
 
+    // construct the model and report its memory use, without running it
+    bool dry_run;
+
+    // colon separated directories of mechanism catalogues to load at startup
+    std::string mechanism_path;
+
+    // quantum in ms of the spike times exchanged between ranks, zero for the
+    // exact times
+    double spike_time_quantum;
+
     // Parameters for spike output
     bool spike_file_output;
     bool single_file_per_rank;
@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <cmath>
 #include <exception>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <numeric>
 #include <vector>
 
 #include <json/json.hpp>
@@ -14,6 +17,8 @@
 #include <cell.hpp>
 #include <fvm_multicell.hpp>
 #include <io/exporter_spike_file.hpp>
+#include <load_balance.hpp>
+#include <memory_usage.hpp>
 #include <model.hpp>
 #include <profiling/profiler.hpp>
 #include <threading/threading.hpp>
@@ -21,6 +26,7 @@
 #include <util/ioutil.hpp>
 #include <util/nop.hpp>
 #include <util/optional.hpp>
+#include <util/span.hpp>
 
 #include "io.hpp"
 #include "miniapp_recipes.hpp"
@@ -40,7 +46,8 @@ using file_export_type = io::exporter_spike_file<model_type::time_type, global_p
 void banner();
 std::unique_ptr<recipe> make_recipe(const io::cl_options&, const probe_distribution&);
 std::unique_ptr<sample_trace_type> make_trace(cell_member_type probe_id, probe_spec probe);
-std::pair<cell_gid_type, cell_gid_type> distribute_cells(cell_size_type ncells);
+void report_load_balance(const std::vector<double>& predicted, const std::vector<double>& measured);
+void report_memory_usage(const memory_usage& local);
 using communicator_type = communication::communicator<model_type::time_type, communication::global_policy>;
 using spike_type = typename communicator_type::spike_type;
 
@@ -61,24 +68,41 @@ int main(int argc, char** argv) {
                   << std::ceil(options.tfinal / options.dt) << " steps of "
                   << options.dt << " ms" << std::endl;
 
+#ifndef WITH_CUDA
+        // add the mechanisms in the catalogues in the mechanism path to the
+        // backend, before the cells that use them are built
+        if (!options.mechanism_path.empty()) {
+            auto start = threading::timer::tic();
+            auto names = multicore::load_catalogues(options.mechanism_path);
+            auto load_time = threading::timer::toc(start);
+            std::cout << ":: loaded " << names.size() << " mechanisms from "
+                      << options.mechanism_path << " in "
+                      << load_time*1e3 << " ms" << std::endl;
+        }
+#endif
+
         // determine what to attach probes to
         probe_distribution pdist;
         pdist.proportion = options.probe_ratio;
         pdist.all_segments = !options.probe_soma_only;
 
         auto recipe = make_recipe(options, pdist);
-        auto cell_range = distribute_cells(recipe->num_cells());
 
-        std::vector<cell_gid_type> group_divisions;
-        for (auto i = cell_range.first; i<cell_range.second; i+=options.group_size) {
-            group_divisions.push_back(i);
-        }
-        group_divisions.push_back(cell_range.second);
+        // distribute cells over domains and cell groups of equal estimated cost
+        auto balance = balance_cells<global_policy>(*recipe, options.group_size);
+        auto cell_range = balance.cell_range;
+        const auto& group_divisions = balance.group_divisions;
 
         EXPECTS(group_divisions.front() == cell_range.first);
         EXPECTS(group_divisions.back() == cell_range.second);
 
-        model_type m(*recipe, util::partition_view(group_divisions));
+        cell_group_options group_options;
+        group_options.depth_first_numbering = options.depth_first;
+        model_type m(*recipe, util::partition_view(group_divisions), group_options);
+        if (options.spike_time_quantum>0 && !m.set_spike_time_quantum(options.spike_time_quantum)) {
+            std::cout << "warning: spike times are exchanged exactly, "
+                      << "because spikes are not packed (WITH_PACKED_SPIKES)\n";
+        }
 
         auto register_exporter = [] (const io::cl_options& options) {
             return
@@ -89,6 +113,12 @@ int main(int argc, char** argv) {
 
         // File output depends on the input arguments
         std::unique_ptr<file_export_type> file_exporter;
+#ifdef WITH_SPARSE_EXCHANGE
+        // Ranks only receive the spikes with targets on the rank, so no rank
+        // has the global spike list: spikes are written by the rank that
+        // generated them.
+        options.single_file_per_rank = true;
+#endif
         if (options.spike_file_output) {
             if (options.single_file_per_rank) {
                 file_exporter = register_exporter(options);
@@ -126,6 +156,11 @@ int main(int argc, char** argv) {
             m.attach_sampler(probe.id, make_trace_sampler(traces.back().get(), sample_dt));
         }
 
+        if (options.dry_run) {
+            report_memory_usage(m.memory_usage());
+            return 0;
+        }
+
         // dummy run of the model for one step to ensure that profiling is consistent
         m.run(options.dt, options.dt);
 
@@ -144,6 +179,14 @@ int main(int argc, char** argv) {
         util::profiler_output(0.001, m.num_cells()*num_steps);
         std::cout << "there were " << m.num_spikes() << " spikes\n";
 
+        auto overlap = m.overlap();
+        std::cout << "exchange " << overlap.exchange_time << " s, "
+                  << "update " << overlap.update_time << " s, "
+                  << "wall " << overlap.wall_time << " s: "
+                  << "overlap efficiency " << overlap.efficiency() << "\n";
+
+        report_load_balance(balance.group_costs, m.group_times());
+
         // save traces
         for (const auto& trace: traces) {
             write_trace_json(*trace.get(), options.trace_prefix);
@@ -162,18 +205,73 @@ int main(int argc, char** argv) {
     return 0;
 }
 
-std::pair<cell_gid_type, cell_gid_type> distribute_cells(cell_size_type num_cells) {
-    // Crude load balancing:
-    // divide [0, num_cells) into num_domains non-overlapping, contiguous blocks
-    // of size as close to equal as possible.
+// Compare the estimated cost of each cell group with the time spent
+// advancing it. The estimates are scaled to the total measured time, and the
+// imbalance is the ratio of the maximum to the mean group time.
+void report_load_balance(const std::vector<double>& predicted, const std::vector<double>& measured) {
+    auto n = predicted.size();
+    if (n==0 || n!=measured.size()) {
+        return;
+    }
 
-    auto num_domains = communication::global_policy::size();
-    auto domain_id = communication::global_policy::id();
+    auto total_predicted = std::accumulate(predicted.begin(), predicted.end(), 0.);
+    auto total_measured = std::accumulate(measured.begin(), measured.end(), 0.);
+    if (total_predicted<=0 || total_measured<=0) {
+        return;
+    }
+    auto scale = total_measured/total_predicted;
 
-    cell_gid_type cell_from = (cell_gid_type)(num_cells*(domain_id/(double)num_domains));
-    cell_gid_type cell_to = (cell_gid_type)(num_cells*((domain_id+1)/(double)num_domains));
+    auto imbalance = [n](const std::vector<double>& v) {
+        auto total = std::accumulate(v.begin(), v.end(), 0.);
+        return *std::max_element(v.begin(), v.end())*n/total;
+    };
+
+    double error = 0;
+    for (auto i: util::make_span(0, n)) {
+        error += std::abs(predicted[i]*scale-measured[i]);
+    }
+
+    // only print the per-group breakdown for small numbers of groups
+    const std::size_t max_groups_printed = 32;
+    std::cout << "load balance: " << n << " cell groups\n";
+    if (n<=max_groups_printed) {
+        std::cout << "  group  predicted (s)  measured (s)\n";
+        for (auto i: util::make_span(0, n)) {
+            std::cout << "  " << std::setw(5) << i
+                      << std::setw(15) << predicted[i]*scale
+                      << std::setw(14) << measured[i] << "\n";
+        }
+    }
+    std::cout << "  predicted imbalance " << imbalance(predicted)
+              << ", measured imbalance " << imbalance(measured)
+              << ", relative error " << error/total_measured << "\n";
+}
 
-    return {cell_from, cell_to};
+// Print the memory used by the model on the rank that uses the most, and
+// over all ranks, by component.
+void report_memory_usage(const memory_usage& local) {
+    auto reduce = [&local](std::size_t (*op)(std::size_t)) {
+        memory_usage m;
+        m.state = op(local.state);
+        m.matrix = op(local.matrix);
+        m.mechanisms = op(local.mechanisms);
+        m.ions = op(local.ions);
+        m.event_queues = op(local.event_queues);
+        m.samplers = op(local.samplers);
+        m.connections = op(local.connections);
+        return m;
+    };
+    auto max = reduce(global_policy::max<std::size_t>);
+    auto sum = reduce(global_policy::sum<std::size_t>);
+
+    // the maximum of the totals is not the total of the maxima
+    auto max_total = global_policy::max(local.total());
+
+    std::cout << "memory usage: maximum per rank of " << global_policy::size() << " ranks\n";
+    std::cout << max;
+    std::cout << "  (largest rank total " << max_total << " B)\n";
+    std::cout << "memory usage: all ranks\n";
+    std::cout << sum;
 }
 
 void banner() {
@@ -34,14 +34,23 @@ CPrinter::CPrinter(Module &m, bool o)
 
     //////////////////////////////////////////////
     //////////////////////////////////////////////
-    text_.add_line("#pragma once");
-    text_.add_line();
+    // a catalogue is a source file that is compiled into a shared library,
+    // not a header
+    auto catalogue = Options::instance().catalogue;
+    if(!catalogue) {
+        text_.add_line("#pragma once");
+        text_.add_line();
+    }
     text_.add_line("#include <cmath>");
     text_.add_line("#include <limits>");
     text_.add_line();
     text_.add_line("#include <mechanism.hpp>");
     text_.add_line("#include <algorithms.hpp>");
     text_.add_line("#include <util/pprintf.hpp>");
+    if(catalogue) {
+        text_.add_line("#include <backends/fvm_multicore.hpp>");
+        text_.add_line("#include <mechanism_catalogue.hpp>");
+    }
     text_.add_line();
 
     //////////////////////////////////////////////
@@ -173,11 +182,35 @@ CPrinter::CPrinter(Module &m, bool o)
     for(auto& ion: m.neuron_block().ions) {
         text_.add_line("s += ion_" + ion.name + ".memory();");
     }
+    auto tables = tabulated_procedures();
+    if(tables.size()) {
+        text_.add_line("s += table_memory();");
+    }
     text_.add_line("return s;");
     text_.decrease_indentation();
     text_.add_line("}");
     text_.add_line();
 
+    if(tables.size()) {
+        text_.add_line("std::size_t table_memory() const override {");
+        text_.increase_indentation();
+        text_.add_line("auto s = std::size_t{0};");
+        for(auto proc: tables) {
+            text_.add_line("s += table_" + proc->name() + "_.capacity()*sizeof(value_type);");
+        }
+        text_.add_line("return s;");
+        text_.decrease_indentation();
+        text_.add_line("}");
+        text_.add_line();
+
+        text_.add_line("value_type table_error() const override {");
+        text_.increase_indentation();
+        text_.add_line("return table_error_;");
+        text_.decrease_indentation();
+        text_.add_line("}");
+        text_.add_line();
+    }
+
     text_.add_line("void set_params(value_type t_, value_type dt_) override {");
     text_.increase_indentation();
     text_.add_line("t = t_;");
@@ -193,6 +226,24 @@ CPrinter::CPrinter(Module &m, bool o)
     text_.add_line("}");
     text_.add_line();
 
+    if(m.kind() == moduleKind::density) {
+        text_.add_line("bool set_overwrite_current(bool overwrite) override {");
+        text_.increase_indentation();
+        text_.add_line("overwrite_current_ = overwrite;");
+        text_.add_line("return true;");
+        text_.decrease_indentation();
+        text_.add_line("}");
+        text_.add_line();
+
+        text_.add_line("bool set_index_runs(const std::vector<size_type>& divisions) override {");
+        text_.increase_indentation();
+        text_.add_line("index_runs_ = divisions;");
+        text_.add_line("return true;");
+        text_.decrease_indentation();
+        text_.add_line("}");
+        text_.add_line();
+    }
+
     std::string kind_str = m.kind() == moduleKind::density
                             ? "mechanismKind::density"
                             : "mechanismKind::point";
@@ -331,6 +382,9 @@ CPrinter::CPrinter(Module &m, bool o)
             }
         }
     }
+    for(auto proc: tables) {
+        print_table_builder(proc);
+    }
 
     //////////////////////////////////////////////
     //////////////////////////////////////////////
@@ -360,6 +414,18 @@ CPrinter::CPrinter(Module &m, bool o)
         }
     }
 
+    if(m.kind() == moduleKind::density) {
+        text_.add_line("bool overwrite_current_ = false;");
+        text_.add_line("std::vector<size_type> index_runs_;");
+    }
+
+    for(auto proc: tables) {
+        text_.add_line("std::vector<value_type> table_" + proc->name() + "_;");
+    }
+    if(tables.size()) {
+        text_.add_line("value_type table_error_ = 0;");
+    }
+
     text_.add_line();
     text_.add_line("using base::vec_v_;");
     text_.add_line("using base::vec_i_;");
@@ -371,6 +437,12 @@ CPrinter::CPrinter(Module &m, bool o)
     text_.add_line();
 
     text_.add_line("}}}} // namespaces");
+
+    if(catalogue) {
+        text_.add_line();
+        text_.add_line("NMC_MULTICORE_CATALOGUE(" + module_name + ", "
+            "nest::mc::mechanisms::" + module_name + "::" + class_name + ")");
+    }
 }
 
 
@@ -401,7 +473,7 @@ void CPrinter::visit(LocalVariable *e) {
 }
 
 void CPrinter::visit(NumberExpression *e) {
-    text_ << " " << e->value();
+    text_ << " " << to_literal(e->value());
 }
 
 void CPrinter::visit(IdentifierExpression *e) {
@@ -409,6 +481,12 @@ void CPrinter::visit(IdentifierExpression *e) {
 }
 
 void CPrinter::visit(VariableExpression *e) {
+    // the outputs of a procedure evaluated into a table are written to out_
+    auto it = std::find(table_outputs_.begin(), table_outputs_.end(), e->name());
+    if(it != table_outputs_.end()) {
+        text_ << "out_[" << it-table_outputs_.begin() << "]";
+        return;
+    }
     text_ << e->name();
     if(e->is_range()) {
         text_ << "[i_]";
@@ -545,12 +623,154 @@ void CPrinter::visit(ProcedureExpression *e) {
 
     // print body
     increase_indentation();
+    if(e->table()) {
+        print_table_lookup(e);
+    }
     e->body()->accept(this);
 
     // close the function body
     decrease_indentation();
     text_.add_line("}");
     text_.add_line();
+
+    if(e->kind() == procedureKind::net_receive) {
+        print_net_receive_batch(e);
+    }
+}
+
+// Print the interpolation of the outputs of a procedure with a TABLE
+// statement, which is used in place of the body of the procedure when the
+// table has been built and the argument is in the range of the table.
+// The table stores the outputs for each value of the argument contiguously.
+void CPrinter::print_table_lookup(ProcedureExpression *e) {
+    auto table = e->table();
+    auto const& outputs = table->outputs();
+    auto m = std::to_string(outputs.size());
+    auto n = std::to_string(table->n());
+    auto x = e->args().front()->is_argument()->name();
+
+    text_.add_line("if(table_" + e->name() + "_.size()) {");
+    increase_indentation();
+    text_.add_line("value_type tx_ = (" + x + "-(" + to_literal(table->from()) + "))*"
+        + to_literal(table->n()/(table->to()-table->from())) + ";");
+    text_.add_line("if(tx_>=0 && tx_<=" + n + ") {");
+    increase_indentation();
+    text_.add_line("int tj_ = tx_<" + n + "? int(tx_): " + std::to_string(table->n()-1) + ";");
+    text_.add_line("value_type tw_ = tx_-tj_;");
+    text_.add_line("const value_type* tp_ = table_" + e->name() + "_.data() + " + m + "*tj_;");
+    for(auto i=0u; i<outputs.size(); ++i) {
+        auto lo = "tp_[" + std::to_string(i) + "]";
+        auto hi = "tp_[" + std::to_string(i+outputs.size()) + "]";
+        text_.add_line(outputs[i] + "[i_] = " + lo + "+tw_*(" + hi + "-" + lo + ");");
+    }
+    text_.add_line("return;");
+    decrease_indentation();
+    text_.add_line("}");
+    decrease_indentation();
+    text_.add_line("}");
+}
+
+// Print the functions that build the table of a procedure with a TABLE
+// statement, and measure the error of interpolating from it.
+// The body of the procedure is evaluated with its outputs written to out_,
+// which is possible because the procedure only assigns to locals and to the
+// outputs of the table, and only reads its argument and the parameters that
+// the table depends on.
+void CPrinter::print_table_builder(ProcedureExpression *e) {
+    auto table = e->table();
+    auto const& outputs = table->outputs();
+    auto name = e->name();
+    auto eval = "eval_table_" + name;
+    auto x = e->args().front()->is_argument()->name();
+
+    text_.add_line("void " + eval + "(value_type " + x + ", value_type* out_) const {");
+    increase_indentation();
+    table_outputs_ = outputs;
+    e->body()->accept(this);
+    table_outputs_.clear();
+    decrease_indentation();
+    text_.add_line("}");
+    text_.add_line();
+
+    text_.add_line("void make_table_" + name + "() {");
+    increase_indentation();
+    text_.add_line("const int n_ = " + std::to_string(table->n()) + ";");
+    text_.add_line("const int m_ = " + std::to_string(outputs.size()) + ";");
+    text_.add_line("const value_type from_ = " + to_literal(table->from()) + ";");
+    text_.add_line("const value_type dx_ = "
+        + to_literal((table->to()-table->from())/table->n()) + ";");
+    text_.add_line();
+    text_.add_line("table_" + name + "_.clear();");
+    text_.add_line("if(!size()) return;");
+    text_.add_line();
+    text_.add_line("std::vector<value_type> table_((n_+1)*m_), exact_(n_*m_);");
+    text_.add_line("std::vector<value_type> lo_(m_), hi_(m_);");
+    text_.add_line("for(int j_=0; j_<=n_; ++j_) {");
+    increase_indentation();
+    text_.add_line("value_type x_ = from_+j_*dx_;");
+    text_.add_line("value_type* t_ = table_.data()+j_*m_;");
+    text_.add_line(eval + "(x_, t_);");
+    text_.add_line("for(int c_=0; c_<m_; ++c_) {");
+    increase_indentation();
+    text_.add_line("if(!std::isfinite(t_[c_])) {");
+    increase_indentation();
+    text_.add_line("// a removable singularity, e.g. 0/0 in x/(exp(x)-1) at x=0,");
+    text_.add_line("// is replaced with the mean of the values on either side");
+    text_.add_line(eval + "(x_-dx_*value_type(1e-3), lo_.data());");
+    text_.add_line(eval + "(x_+dx_*value_type(1e-3), hi_.data());");
+    text_.add_line("t_[c_] = (lo_[c_]+hi_[c_])/2;");
+    decrease_indentation();
+    text_.add_line("}");
+    decrease_indentation();
+    text_.add_line("}");
+    decrease_indentation();
+    text_.add_line("}");
+    text_.add_line("for(int j_=0; j_<n_; ++j_) {");
+    increase_indentation();
+    text_.add_line(eval + "(from_+(j_+value_type(0.5))*dx_, exact_.data()+j_*m_);");
+    decrease_indentation();
+    text_.add_line("}");
+    text_.add_line();
+    text_.add_line("// the largest error of linear interpolation at the midpoints of the");
+    text_.add_line("// intervals, relative to the largest magnitude of each output");
+    text_.add_line("std::vector<value_type> scale_(m_, 0);");
+    text_.add_line("for(int k_=0; k_<n_*m_; ++k_) {");
+    increase_indentation();
+    text_.add_line("scale_[k_%m_] = std::max(scale_[k_%m_], std::abs(exact_[k_]));");
+    decrease_indentation();
+    text_.add_line("}");
+    text_.add_line("for(int k_=0; k_<n_*m_; ++k_) {");
+    increase_indentation();
+    text_.add_line("value_type interp_ = (table_[k_]+table_[k_+m_])/2;");
+    text_.add_line("value_type err_ = std::abs(interp_-exact_[k_]);");
+    text_.add_line("value_type sc_ = scale_[k_%m_];");
+    text_.add_line("table_error_ = std::max(table_error_, sc_>0? err_/sc_: err_);");
+    decrease_indentation();
+    text_.add_line("}");
+    text_.add_line("table_" + name + "_ = std::move(table_);");
+    decrease_indentation();
+    text_.add_line("}");
+    text_.add_line();
+}
+
+// Print a version of net_receive that delivers a batch of events in one loop,
+// which avoids a virtual call per event.
+void CPrinter::print_net_receive_batch(ProcedureExpression *e) {
+    text_.add_line("void net_receive_batch(const size_type* event_index_, "
+                   "const value_type* event_weight_, size_type n_) override {");
+    increase_indentation();
+    text_.add_line("for(size_type k_=0; k_<n_; ++k_) {");
+    increase_indentation();
+    text_.add_line("int i_ = event_index_[k_];");
+    for(auto& arg : e->args()) {
+        text_.add_line("value_type " + arg->is_argument()->name() + " = event_weight_[k_];");
+    }
+    e->body()->accept(this);
+    decrease_indentation();
+    text_.add_line("}");
+    decrease_indentation();
+    text_.add_line("}");
+    text_.add_line();
 }
 
 void CPrinter::visit(APIMethod *e) {
@@ -565,41 +785,41 @@ void CPrinter::visit(APIMethod *e) {
             e->location());
     }
 
-    // only print the body if it has contents
-    if(e->is_api_method()->body()->statements().size()) {
+    // the tables depend on parameters that may have changed since the
+    // mechanism was last initialized
+    auto tables = tabulated_procedures();
+    if(e->name()=="nrn_init" && tables.size()) {
         increase_indentation();
-
-        // create local indexed views
-        for(auto &symbol : e->scope()->locals()) {
-            auto var = symbol.second->is_local_variable();
-            if(var->is_indexed()) {
-                auto const& name = var->name();
-                auto const& index_name = var->external_variable()->index_name();
-                text_.add_gutter();
-                if(var->is_read()) text_ << "const ";
-                text_ << "indexed_view_type " + index_name;
-                auto channel = var->external_variable()->ion_channel();
-                if(channel==ionKind::none) {
-                    text_ << "(" + index_name + "_, node_index_);\n";
-                }
-                else {
-                    auto iname = ion_store(channel);
-                    text_ << "(" << iname << "." << name << ", "
-                          << ion_store(channel) << ".index);\n";
-                }
-            }
+        text_.add_line("table_error_ = 0;");
+        for(auto proc: tables) {
+            text_.add_line("make_table_" + proc->name() + "();");
         }
+        decrease_indentation();
+    }
 
-        // get loop dimensions
-        text_.add_line("int n_ = node_index_.size();");
+    // only print the body if it has contents
+    if(e->is_api_method()->body()->statements().size()) {
+        increase_indentation();
 
-        // hand off printing of loops to optimized or unoptimized backend
-        if(optimize_) {
-            print_APIMethod_optimized(e);
+        if(can_access_directly(e)) {
+            // direct access over the runs of consecutive CVs, if the
+            // node index has been partitioned into runs
+            text_.add_line("if(index_runs_.size()) {");
+            increase_indentation();
+            print_APIMethod_direct(e);
+            decrease_indentation();
+            text_.add_line("}");
+            text_.add_line("else {");
+            increase_indentation();
+            print_APIMethod_indexed(e);
+            decrease_indentation();
+            text_.add_line("}");
         }
         else {
-            print_APIMethod_unoptimized(e);
+            print_APIMethod_indexed(e);
         }
+
+        decrease_indentation();
     }
 
     // close up the loop body
@@ -607,12 +827,137 @@ void CPrinter::visit(APIMethod *e) {
     text_.add_line();
 }
 
+// print the loops over the instances, accessing external variables through
+// indexed views
+void CPrinter::print_APIMethod_indexed(APIMethod* e) {
+    // create local indexed views
+    for(auto &symbol : e->scope()->locals()) {
+        auto var = symbol.second->is_local_variable();
+        if(var->is_indexed()) {
+            auto const& name = var->name();
+            auto const& index_name = var->external_variable()->index_name();
+            text_.add_gutter();
+            if(var->is_read()) text_ << "const ";
+            text_ << "indexed_view_type " + index_name;
+            auto channel = var->external_variable()->ion_channel();
+            if(channel==ionKind::none) {
+                text_ << "(" + index_name + "_, node_index_);\n";
+            }
+            else {
+                auto iname = ion_store(channel);
+                text_ << "(" << iname << "." << name << ", "
+                      << ion_store(channel) << ".index);\n";
+            }
+        }
+    }
+
+    // get loop dimensions
+    text_.add_line("int n_ = node_index_.size();");
+
+    print_APIMethod_loops(e);
+}
+
+// Print a loop over each run of instances on consecutive CVs, accessing the
+// external variables through pointers offset to the start of the run, so
+// that the loops can be vectorized without gathers and scatters.
+// The instances of an ion are numbered in the order of their CVs, so the
+// instances of an ion in a run are also consecutive.
+void CPrinter::print_APIMethod_direct(APIMethod* e) {
+    text_.add_line("for(size_type r_=0; r_+1<index_runs_.size(); ++r_) {");
+    increase_indentation();
+    text_.add_line("int begin_ = index_runs_[r_];");
+    text_.add_line("int end_ = index_runs_[r_+1];");
+    for(auto &symbol : e->scope()->locals()) {
+        auto var = symbol.second->is_local_variable();
+        if(var->is_indexed()) {
+            auto const& name = var->name();
+            auto const& index_name = var->external_variable()->index_name();
+            text_.add_gutter();
+            if(var->is_read()) text_ << "const ";
+            text_ << "value_type* " << index_name << " = ";
+            auto channel = var->external_variable()->ion_channel();
+            if(channel==ionKind::none) {
+                text_ << index_name << "_.data() + node_index_[begin_] - begin_;\n";
+            }
+            else {
+                auto iname = ion_store(channel);
+                text_ << iname << "." << name << ".data() + "
+                      << iname << ".index[begin_] - begin_;\n";
+            }
+        }
+    }
+
+    direct_access_ = true;
+    print_APIMethod_loops(e);
+    direct_access_ = false;
+
+    decrease_indentation();
+    text_.add_line("}");
+}
+
+// print the loops, with a loop that writes the current and one that adds
+// it for mechanisms that can overwrite the current
+void CPrinter::print_APIMethod_loops(APIMethod* e) {
+    if(can_overwrite_current(e)) {
+        text_.add_line("if(overwrite_current_) {");
+        increase_indentation();
+        overwrite_current_ = true;
+        print_APIMethod_loop(e);
+        overwrite_current_ = false;
+        decrease_indentation();
+        text_.add_line("}");
+        text_.add_line("else {");
+        increase_indentation();
+        print_APIMethod_loop(e);
+        decrease_indentation();
+        text_.add_line("}");
+    }
+    else {
+        print_APIMethod_loop(e);
+    }
+}
+
+// hand off printing of loops to optimized or unoptimized backend
+void CPrinter::print_APIMethod_loop(APIMethod* e) {
+    if(optimize_) {
+        print_APIMethod_optimized(e);
+    }
+    else {
+        print_APIMethod_unoptimized(e);
+    }
+}
+
+// print the update of the external variable of an output, e.g. a current
+void CPrinter::print_output_update(LocalVariable* var) {
+    auto ext = var->external_variable();
+    text_.add_gutter();
+    ext->accept(this);
+    if(overwrite_current_ && !ext->is_ion()) {
+        text_ << (ext->op() == tok::plus ? " = " : " = -");
+    }
+    else {
+        text_ << (ext->op() == tok::plus ? " += " : " -= ");
+    }
+    var->accept(this);
+    text_.end_line(";");
+}
+
 void CPrinter::print_APIMethod_unoptimized(APIMethod* e) {
     // there can not be more than 1 instance of a density channel per grid point,
     // so we can assert that aliasing will not occur.
     if(optimize_) text_.add_line("#pragma ivdep");
 
-    text_.add_line("for(int i_=0; i_<n_; ++i_) {");
+    if(direct_access_) {
+        // the instances of a run are on distinct consecutive CVs, and the
+        // mechanism and ion arrays do not overlap, so the iterations are
+        // independent: this spares the compiler from checking for aliasing
+        // at run time, which it gives up on for loops over many arrays
+        text_.add_line("#pragma GCC ivdep");
+        text_.add_line("for(int i_=begin_; i_<end_; ++i_) {");
+    }
+    else {
+        text_.add_line("for(int i_=0; i_<n_; ++i_) {");
+    }
     text_.increase_indentation();
 
     // loads from external indexed arrays
@@ -635,22 +980,12 @@ void CPrinter::print_APIMethod_unoptimized(APIMethod* e) {
     for(auto &symbol : e->scope()->locals()) {
         auto var = symbol.second->is_local_variable();
         if(is_output(var)) {
-            auto ext = var->external_variable();
-            text_.add_gutter();
-            ext->accept(this);
-            text_ << (ext->op() == tok::plus ? " += " : " -= ");
-            var->accept(this);
-            text_.end_line(";");
+            print_output_update(var);
         }
     }
 
     text_.decrease_indentation();
     text_.add_line("}");
-
-    //text_.add_line("STOP_PROFILE");
-    decrease_indentation();
-
-    return;
 }
 
 void CPrinter::print_APIMethod_optimized(APIMethod* e) {
@@ -730,12 +1065,7 @@ void CPrinter::print_APIMethod_optimized(APIMethod* e) {
     text_.increase_indentation();
 
     for(auto out: aliased_variables) {
-        text_.add_gutter();
-        auto ext = out->external_variable();
-        ext->accept(this);
-        text_ << (ext->op() == tok::plus ? " += " : " -= ");
-        out->accept(this);
-        text_.end_line(";");
+        print_output_update(out);
     }
 
     text_.decrease_indentation();
@@ -771,22 +1101,15 @@ void CPrinter::print_APIMethod_optimized(APIMethod* e) {
     text_.increase_indentation();
 
     for(auto out: aliased_variables) {
-        text_.add_gutter();
-        auto ext = out->external_variable();
-        ext->accept(this);
-        text_ << (ext->op() == tok::plus ? " += " : " -= ");
-        out->accept(this);
-        text_.end_line(";");
+        print_output_update(out);
     }
 
     text_.decrease_indentation();
     text_.add_line("}"); // end block tail loop
 
     //text_.add_line("STOP_PROFILE");
-    decrease_indentation();
 
     aliased_output_ = false;
-    return;
 }
 
 void CPrinter::visit(CallExpression *e) {
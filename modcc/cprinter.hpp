@@ -49,14 +49,25 @@ public:
     }
 private:
 
+    void print_APIMethod_indexed(APIMethod* e);
+    void print_APIMethod_direct(APIMethod* e);
+    void print_APIMethod_loops(APIMethod* e);
+    void print_APIMethod_loop(APIMethod* e);
     void print_APIMethod_optimized(APIMethod* e);
     void print_APIMethod_unoptimized(APIMethod* e);
+    void print_output_update(LocalVariable* var);
+    void print_net_receive_batch(ProcedureExpression* e);
+    void print_table_lookup(ProcedureExpression* e);
+    void print_table_builder(ProcedureExpression* e);
 
     Module *module_ = nullptr;
     tok parent_op_ = tok::eq;
     TextBuffer text_;
     bool optimize_ = false;
     bool aliased_output_ = false;
+    bool overwrite_current_ = false;
+    bool direct_access_ = false;
+    std::vector<std::string> table_outputs_;
 
     bool is_input(Symbol *s) {
         if(auto l = s->is_local_variable() ) {
@@ -114,5 +125,36 @@ private:
     bool is_point_process() {
         return module_->kind() == moduleKind::point;
     }
+
+    // the procedures with a TABLE statement
+    std::vector<ProcedureExpression*> tabulated_procedures() {
+        std::vector<ProcedureExpression*> procs;
+        for(auto& symbol : module_->symbols()) {
+            auto proc = symbol.second->is_procedure();
+            if(proc && proc->kind()==procedureKind::normal && proc->table()) {
+                procs.push_back(proc);
+            }
+        }
+        return procs;
+    }
+
+    // Density mechanisms can write their contribution to the membrane
+    // current in nrn_current, instead of adding it, if they are defined on
+    // every CV.
+    bool can_overwrite_current(APIMethod* e) {
+        return !is_point_process() && e->name()=="nrn_current";
+    }
+
+    // Density mechanisms can access the CV state directly over runs of
+    // consecutive CVs, instead of through the node index.
+    bool can_access_directly(APIMethod* e) {
+        if(is_point_process()) return false;
+        for(auto &symbol : e->scope()->locals()) {
+            if(symbol.second->is_local_variable()->is_indexed()) {
+                return true;
+            }
+        }
+        return false;
+    }
 };
 
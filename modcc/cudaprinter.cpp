@@ -512,7 +512,7 @@ void CUDAPrinter::visit(LocalDeclaration *e) {
 }
 
 void CUDAPrinter::visit(NumberExpression *e) {
-    text_ << " " << e->value();
+    text_ << " " << to_literal(e->value());
 }
 
 void CUDAPrinter::visit(IdentifierExpression *e) {
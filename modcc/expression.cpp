@@ -736,6 +736,39 @@ expression_ptr ConductanceExpression::clone() const {
     return expression_ptr{s};
 }
 
+/*******************************************************************************
+  TableExpression
+*******************************************************************************/
+
+std::string TableExpression::to_string() const {
+    auto list = [] (std::vector<std::string> const& names) {
+        std::string s;
+        for(auto& name : names) {
+            s += (s.empty() ? "" : ", ") + yellow(name);
+        }
+        return s;
+    };
+    return blue("table") + "(" + list(outputs_) + "; "
+        + blue("depend") + " " + list(depends_) + "; "
+        + green(std::to_string((double)from_)) + " "
+        + green(std::to_string((double)to_)) + " "
+        + green(std::to_string(n_)) + ")";
+}
+
+void TableExpression::semantic(scope_ptr scp) {
+    scope_ = scp;
+    // The parser moves the TABLE statement of a PROCEDURE out of its body, and
+    // semantic analysis of the table is performed by the Module. Any TABLE
+    // statement that is still in a block is in the wrong place.
+    error("a TABLE statement can only be used in the body of a PROCEDURE,"
+          " which can have at most one");
+}
+
+expression_ptr TableExpression::clone() const {
+    return make_expression<TableExpression>(
+        location_, outputs_, depends_, from_, to_, n_);
+}
+
 /*******************************************************************************
   BlockExpression
 *******************************************************************************/
@@ -837,6 +870,9 @@ void SolveExpression::accept(Visitor *v) {
 void ConductanceExpression::accept(Visitor *v) {
     v->visit(this);
 }
+void TableExpression::accept(Visitor *v) {
+    v->visit(this);
+}
 void DerivativeExpression::accept(Visitor *v) {
     v->visit(this);
 }
@@ -53,6 +53,7 @@ class PowBinaryExpression;
 class ConditionalExpression;
 class SolveExpression;
 class ConductanceExpression;
+class TableExpression;
 class Symbol;
 class LocalVariable;
 
@@ -101,13 +102,15 @@ std::string to_string(symbolKind k);
 
 /// methods for time stepping state
 enum class solverMethod {
-    cnexp, // the only method we have at the moment
+    cnexp,  // exact integration of linear ODEs in DERIVATIVE blocks
+    sparse, // backward Euler for KINETIC blocks
     none
 };
 
 static std::string to_string(solverMethod m) {
     switch(m) {
         case solverMethod::cnexp : return std::string("cnexp");
+        case solverMethod::sparse: return std::string("sparse");
         case solverMethod::none  : return std::string("none");
     }
     return std::string("<error : undefined solverMethod>");
@@ -179,6 +182,7 @@ public:
     virtual SolveExpression*       is_solve_statement()   {return nullptr;}
     virtual Symbol*                is_symbol()            {return nullptr;}
     virtual ConductanceExpression* is_conductance_statement() {return nullptr;}
+    virtual TableExpression*       is_table_statement()   {return nullptr;}
 
     virtual bool is_lvalue() const {return false;}
     virtual bool is_global_lvalue() const {return false;}
@@ -724,6 +728,67 @@ private:
     ionKind ion_channel_;
 };
 
+// a TABLE statement
+//      TABLE minf, mtau DEPEND celsius FROM -100 TO 100 WITH 200
+// requests that the outputs of the PROCEDURE in which it appears are
+// interpolated from a table of their values at n+1 evenly spaced values of
+// the argument of the procedure in [from, to]. The table is recomputed when
+// the mechanism is initialized, so it can depend on the listed parameters.
+class TableExpression : public Expression {
+public:
+    TableExpression(
+            Location loc,
+            std::vector<std::string> outputs,
+            std::vector<std::string> depends,
+            long double from,
+            long double to,
+            int n)
+    :   Expression(loc),
+        outputs_(std::move(outputs)), depends_(std::move(depends)),
+        from_(from), to_(to), n_(n)
+    {}
+
+    std::string to_string() const override;
+
+    std::vector<std::string> const& outputs() const {
+        return outputs_;
+    }
+
+    std::vector<std::string> const& depends() const {
+        return depends_;
+    }
+
+    long double from() const {
+        return from_;
+    }
+
+    long double to() const {
+        return to_;
+    }
+
+    /// the number of intervals in the table
+    int n() const {
+        return n_;
+    }
+
+    TableExpression* is_table_statement() override {
+        return this;
+    }
+
+    expression_ptr clone() const override;
+
+    void semantic(scope_ptr scp) override;
+    void accept(Visitor *v) override;
+
+    ~TableExpression() {}
+private:
+    std::vector<std::string> outputs_;
+    std::vector<std::string> depends_;
+    long double from_;
+    long double to_;
+    int n_;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // recursive if statement
 // requires a BlockExpression that is a simple wrapper around a std::list
@@ -1013,11 +1078,20 @@ public:
     /// from a special block, e.g. BREAKPOINT, INITIAL, NET_RECEIVE, etc
     procedureKind kind() const {return kind_;}
 
+    /// the TABLE statement of the procedure, or nullptr if it has none
+    TableExpression* table() {
+        return table_ ? table_->is_table_statement() : nullptr;
+    }
+    void table(expression_ptr&& t) {
+        table_ = std::move(t);
+    }
+
 protected:
     Symbol* symbol_;
 
     std::vector<expression_ptr> args_;
     expression_ptr body_;
+    expression_ptr table_;
     procedureKind kind_ = procedureKind::normal;
 };
 
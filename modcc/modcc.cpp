@@ -1,6 +1,7 @@
 #include <chrono>
 #include <iostream>
 #include <fstream>
+#include <map>
 
 #include <tclap/CmdLine.h>
 
@@ -36,6 +37,8 @@ int main(int argc, char **argv) {
         TCLAP::SwitchArg analysis_arg("A","analyse","toggle analysis mode", cmd, false);
         // optimization mode
         TCLAP::SwitchArg opt_arg("O","optimize","turn optimizations on", cmd, false);
+        // generate a mechanism catalogue that can be loaded at run time
+        TCLAP::SwitchArg catalogue_arg("C","catalogue","generate a loadable mechanism catalogue", cmd, false);
         // Set module name explicitly
         TCLAP::ValueArg<std::string>
             module_arg("m", "module", "module name to use", false, "", "module");
@@ -54,6 +57,7 @@ int main(int argc, char **argv) {
         Options::instance().verbose = verbose_arg.getValue();
         Options::instance().optimize = opt_arg.getValue();
         Options::instance().analysis = analysis_arg.getValue();
+        Options::instance().catalogue = catalogue_arg.getValue();
         auto targstr = target_arg.getValue();
         if(targstr == "cpu") {
             Options::instance().target = targetKind::cpu;
@@ -65,6 +69,10 @@ int main(int argc, char **argv) {
             std::cerr << red("error") << " target must be one in {cpu, gpu}\n";
             return 1;
         }
+        if(Options::instance().catalogue && Options::instance().target!=targetKind::cpu) {
+            std::cerr << red("error") << " catalogues can only be generated for the cpu target\n";
+            return 1;
+        }
     }
     // catch any exceptions in command line handling
     catch(TCLAP::ArgException &e) {
@@ -126,6 +134,26 @@ int main(int argc, char **argv) {
             }
         }
 
+        ////////////////////////////////////////////////////////////
+        // simplify
+        ////////////////////////////////////////////////////////////
+        // record the flops before simplification for the analysis
+        std::map<std::string, FlopAccumulator> flops_before;
+        if(Options::instance().analysis) {
+            for(auto &symbol : m.symbols()) {
+                if(auto proc = symbol.second->is_procedure()) {
+                    auto flops = make_unique<FlopVisitor>();
+                    proc->accept(flops.get());
+                    flops_before[symbol.first] = flops->flops;
+                }
+            }
+        }
+
+        if(Options::instance().verbose) std::cout << green("[") + "simplify" + green("]") << std::endl;
+        // divisions by constants are only replaced with multiplications
+        // with -O, because the results can differ by one ulp
+        m.simplify(Options::instance().optimize);
+
         ////////////////////////////////////////////////////////////
         // generate output
         ////////////////////////////////////////////////////////////
@@ -168,11 +196,19 @@ int main(int argc, char **argv) {
         if(Options::instance().analysis) {
             std::cout << green("performance analysis") << std::endl;
             for(auto &symbol : m.symbols()) {
-                if(auto method = symbol.second->is_api_method()) {
+                auto method = symbol.second->is_procedure();
+                if(method && (method->is_api_method()
+                    || method->kind()==procedureKind::normal))
+                {
                     std::cout << white("-------------------------\n");
-                    std::cout << yellow("method " + method->name()) << "\n";
+                    std::cout << yellow(
+                        (method->is_api_method()? "method ": "procedure ")
+                        + method->name()) << "\n";
                     std::cout << white("-------------------------\n");
 
+                    std::cout << white("FLOPS before simplification") << std::endl;
+                    std::cout << flops_before[symbol.first] << std::endl << std::endl;
+
                     auto flops = make_unique<FlopVisitor>();
                     method->accept(flops.get());
                     std::cout << white("FLOPS") << std::endl;
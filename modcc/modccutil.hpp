@@ -1,8 +1,11 @@
 #pragma once
 
 #include <exception>
+#include <iomanip>
+#include <limits>
 #include <memory>
 #include <sstream>
+#include <string>
 #include <vector>
 #include <initializer_list>
 
@@ -70,6 +73,19 @@ std::string to_string(T val) {
     return str.str();
 }
 
+// Print a floating point literal with the default precision when that reads
+// back as the same double, and with enough digits to do so otherwise.
+inline std::string to_literal(long double val) {
+    std::stringstream str;
+    str << val;
+    auto d = static_cast<double>(val);
+    if(std::stod(str.str())!=d) {
+        str.str("");
+        str << std::setprecision(std::numeric_limits<double>::max_digits10) << d;
+    }
+    return str.str();
+}
+
 //'\e[1;31m' # Red
 //'\e[1;32m' # Green
 //'\e[1;33m' # Yellow
@@ -10,6 +10,8 @@
 #include "functioninliner.hpp"
 #include "module.hpp"
 #include "parser.hpp"
+#include "simplifier.hpp"
+#include "sparsesolver.hpp"
 
 Module::Module(std::string const& fname)
 : fname_(fname)
@@ -250,6 +252,19 @@ bool Module::semantic() {
         return false;
     }
 
+    // check the procedures with TABLE statements, now that function calls in
+    // them have been inlined
+    bool tables_ok = true;
+    for(auto& e : symbols_) {
+        auto proc = e.second->is_procedure();
+        if(proc && proc->table()) {
+            tables_ok = semantic_table(proc) && tables_ok;
+        }
+    }
+    if(!tables_ok) {
+        return false;
+    }
+
     // All API methods are generated from statements in one of the special procedures
     // defined in NMODL, e.g. the nrn_init() API call is based on the INITIAL block.
     // When creating an API method, the first task is to look up the source procedure,
@@ -389,100 +404,124 @@ bool Module::semantic() {
             // will hold the AST for the nrn_state function.
             auto& body = api_state->body()->statements();
 
-            auto has_provided_integration_method =
-                solve_expression->method() == solverMethod::cnexp;
-
-            // loop over the statements in the SOLVE block from the mod file
-            // put each statement into the new APIMethod, performing
-            // transformations if necessary.
-            for(auto& e : *(dblock->body())) {
-                if(auto ass = e->is_assignment()) {
-                    auto lhs = ass->lhs();
-                    auto rhs = ass->rhs();
-                    if(auto deriv = lhs->is_derivative()) {
-                        // Check that a METHOD was provided in the original SOLVE
-                        // statment. We have to do this because it is possible
-                        // to call SOLVE without a METHOD, in which case there should
-                        // be no derivative expressions in the DERIVATIVE block.
-                        if(!has_provided_integration_method) {
-                            error("The DERIVATIVE block has a derivative expression"
-                                  " but no METHOD was specified in the SOLVE statement",
-                                  deriv->location());
-                            return false;
-                        }
+            if(dblock->kind() == procedureKind::kinetic) {
+                // KINETIC blocks are solved implicitly, which requires
+                // METHOD sparse
+                if(solve_expression->method() != solverMethod::sparse) {
+                    error("KINETIC blocks must be solved with METHOD sparse",
+                          solve_expression->location());
+                    return false;
+                }
 
-                        auto sym  = deriv->symbol();
-                        auto name = deriv->name();
-
-                        auto gating_vars = is_gating(rhs, name);
-                        if(gating_vars.first && gating_vars.second) {
-                            auto const& inf = gating_vars.second->spelling();
-                            auto const& rate = gating_vars.first->spelling();
-                            auto e_string = name + "=" + inf
-                                            + "+(" + name + "-" + inf + ")*exp(-dt/"
-                                            + rate + ")";
-                            auto stmt_update = Parser(e_string).parse_line_expression();
-                            body.emplace_back(std::move(stmt_update));
-                            continue;
-                        }
-                        else {
-                            // create visitor for linear analysis
-                            auto v = make_unique<ExpressionClassifierVisitor>(sym);
-                            rhs->accept(v.get());
-
-                            // quit if ODE is not linear
-                            if( v->classify() != expressionClassification::linear ) {
-                                error("unable to integrate nonlinear state ODEs",
-                                      rhs->location());
+                auto v = make_unique<SparseSolverVisitor>();
+                dblock->accept(v.get());
+                if(v->has_error()) {
+                    error(v->error_message(), v->error_location());
+                    return false;
+                }
+                body.splice(body.end(), v->statements());
+            }
+            else if(solve_expression->method() == solverMethod::sparse) {
+                error("METHOD sparse can only be used to solve KINETIC blocks",
+                      solve_expression->location());
+                return false;
+            }
+            else {
+                auto has_provided_integration_method =
+                    solve_expression->method() == solverMethod::cnexp;
+
+                // loop over the statements in the SOLVE block from the mod file
+                // put each statement into the new APIMethod, performing
+                // transformations if necessary.
+                for(auto& e : *(dblock->body())) {
+                    if(auto ass = e->is_assignment()) {
+                        auto lhs = ass->lhs();
+                        auto rhs = ass->rhs();
+                        if(auto deriv = lhs->is_derivative()) {
+                            // Check that a METHOD was provided in the original SOLVE
+                            // statment. We have to do this because it is possible
+                            // to call SOLVE without a METHOD, in which case there should
+                            // be no derivative expressions in the DERIVATIVE block.
+                            if(!has_provided_integration_method) {
+                                error("The DERIVATIVE block has a derivative expression"
+                                      " but no METHOD was specified in the SOLVE statement",
+                                      deriv->location());
                                 return false;
                             }
 
-                            // the linear differential equation is of the form
-                            //      s' = a*s + b
-                            // integration by separation of variables gives the following
-                            // update function to integrate s for one time step dt
-                            //      s = -b/a + (s+b/a)*exp(a*dt)
-                            // we are going to build this update function by
-                            //  1. generating statements that define a_=a and ba_=b/a
-                            //  2. generating statements that update the solution
-
-                            // statement : a_ = a
-                            auto stmt_a  =
-                                binary_expression(Location(),
-                                                  tok::eq,
-                                                  id("a_"),
-                                                  v->linear_coefficient()->clone());
-
-                            // expression : b/a
-                            auto expr_ba =
-                                binary_expression(Location(),
-                                                  tok::divide,
-                                                  v->constant_term()->clone(),
-                                                  id("a_"));
-                            // statement  : ba_ = b/a
-                            auto stmt_ba = binary_expression(Location(), tok::eq, id("ba_"), std::move(expr_ba));
-
-                            // the update function
-                            auto e_string = name + "  = -ba_ + "
-                                            "(" + name + " + ba_)*exp(a_*dt)";
-                            auto stmt_update = Parser(e_string).parse_line_expression();
-
-                            // add declaration of local variables
-                            body.emplace_back(Parser("LOCAL a_").parse_local());
-                            body.emplace_back(Parser("LOCAL ba_").parse_local());
-                            // add integration statements
-                            body.emplace_back(std::move(stmt_a));
-                            body.emplace_back(std::move(stmt_ba));
-                            body.emplace_back(std::move(stmt_update));
+                            auto sym  = deriv->symbol();
+                            auto name = deriv->name();
+
+                            auto gating_vars = is_gating(rhs, name);
+                            if(gating_vars.first && gating_vars.second) {
+                                auto const& inf = gating_vars.second->spelling();
+                                auto const& rate = gating_vars.first->spelling();
+                                auto e_string = name + "=" + inf
+                                                + "+(" + name + "-" + inf + ")*exp(-dt/"
+                                                + rate + ")";
+                                auto stmt_update = Parser(e_string).parse_line_expression();
+                                body.emplace_back(std::move(stmt_update));
+                                continue;
+                            }
+                            else {
+                                // create visitor for linear analysis
+                                auto v = make_unique<ExpressionClassifierVisitor>(sym);
+                                rhs->accept(v.get());
+
+                                // quit if ODE is not linear
+                                if( v->classify() != expressionClassification::linear ) {
+                                    error("unable to integrate nonlinear state ODEs",
+                                          rhs->location());
+                                    return false;
+                                }
+
+                                // the linear differential equation is of the form
+                                //      s' = a*s + b
+                                // integration by separation of variables gives the following
+                                // update function to integrate s for one time step dt
+                                //      s = -b/a + (s+b/a)*exp(a*dt)
+                                // we are going to build this update function by
+                                //  1. generating statements that define a_=a and ba_=b/a
+                                //  2. generating statements that update the solution
+
+                                // statement : a_ = a
+                                auto stmt_a  =
+                                    binary_expression(Location(),
+                                                      tok::eq,
+                                                      id("a_"),
+                                                      v->linear_coefficient()->clone());
+
+                                // expression : b/a
+                                auto expr_ba =
+                                    binary_expression(Location(),
+                                                      tok::divide,
+                                                      v->constant_term()->clone(),
+                                                      id("a_"));
+                                // statement  : ba_ = b/a
+                                auto stmt_ba = binary_expression(Location(), tok::eq, id("ba_"), std::move(expr_ba));
+
+                                // the update function
+                                auto e_string = name + "  = -ba_ + "
+                                                "(" + name + " + ba_)*exp(a_*dt)";
+                                auto stmt_update = Parser(e_string).parse_line_expression();
+
+                                // add declaration of local variables
+                                body.emplace_back(Parser("LOCAL a_").parse_local());
+                                body.emplace_back(Parser("LOCAL ba_").parse_local());
+                                // add integration statements
+                                body.emplace_back(std::move(stmt_a));
+                                body.emplace_back(std::move(stmt_ba));
+                                body.emplace_back(std::move(stmt_update));
+                                continue;
+                            }
+                        }
+                        else {
+                            body.push_back(e->clone());
                             continue;
                         }
                     }
-                    else {
-                        body.push_back(e->clone());
-                        continue;
-                    }
+                    body.push_back(e->clone());
                 }
-                body.push_back(e->clone());
             }
         }
 
@@ -577,6 +616,137 @@ bool Module::semantic() {
     return status() == lexerStatus::happy;
 }
 
+// Append the identifiers in e to ids, with a flag that is true if the
+// identifier is assigned to, and the calls in e to calls.
+static void find_identifiers(
+    Expression* e, bool is_lhs,
+    std::vector<std::pair<IdentifierExpression*, bool>>& ids,
+    std::vector<CallExpression*>& calls)
+{
+    if(auto id = e->is_identifier()) {
+        ids.emplace_back(id, is_lhs);
+    }
+    else if(auto a = e->is_assignment()) {
+        find_identifiers(a->lhs(), true, ids, calls);
+        find_identifiers(a->rhs(), false, ids, calls);
+    }
+    else if(auto b = e->is_binary()) {
+        find_identifiers(b->lhs(), false, ids, calls);
+        find_identifiers(b->rhs(), false, ids, calls);
+    }
+    else if(auto u = e->is_unary()) {
+        find_identifiers(u->expression(), false, ids, calls);
+    }
+    else if(e->is_function_call() || e->is_procedure_call()) {
+        auto c = e->is_function_call() ? e->is_function_call() : e->is_procedure_call();
+        calls.push_back(c);
+        for(auto& arg : c->args()) {
+            find_identifiers(arg.get(), false, ids, calls);
+        }
+    }
+    else if(auto f = e->is_if()) {
+        find_identifiers(f->condition(), false, ids, calls);
+        find_identifiers(f->true_branch(), false, ids, calls);
+        if(f->false_branch()) {
+            find_identifiers(f->false_branch(), false, ids, calls);
+        }
+    }
+    else if(auto block = e->is_block()) {
+        for(auto& stmt : block->statements()) {
+            find_identifiers(stmt.get(), false, ids, calls);
+        }
+    }
+}
+
+// A procedure can be tabulated if its outputs are a function of its only
+// argument, e.g. the voltage, and of the DEPEND parameters, which are the
+// same for every instance of the mechanism.
+bool Module::semantic_table(ProcedureExpression* proc) {
+    auto table = proc->table();
+    auto loc = table->location();
+    bool ok = true;
+
+    if(proc->args().size()!=1) {
+        error(pprintf("a PROCEDURE with a TABLE must have one argument,"
+                      " but '%' has %", yellow(proc->name()), proc->args().size()),
+              loc);
+        ok = false;
+    }
+
+    auto& outputs = table->outputs();
+    auto& depends = table->depends();
+    auto is_output = [&outputs] (std::string const& name) {
+        return std::find(outputs.begin(), outputs.end(), name) != outputs.end();
+    };
+    auto is_depend = [&depends] (std::string const& name) {
+        return std::find(depends.begin(), depends.end(), name) != depends.end();
+    };
+
+    for(auto& name : outputs) {
+        auto sym = proc->scope()->find(name);
+        auto var = sym ? sym->is_variable() : nullptr;
+        if(!var || !var->is_range() || var->is_state() || var->is_ion()) {
+            error(pprintf("TABLE variable '%' must be an ASSIGNED variable",
+                          yellow(name)), loc);
+            ok = false;
+        }
+    }
+    for(auto& name : depends) {
+        auto sym = proc->scope()->find(name);
+        auto var = sym ? sym->is_variable() : nullptr;
+        if(!var || !var->is_scalar()) {
+            error(pprintf("DEPEND variable '%' must be a PARAMETER that is not"
+                          " a RANGE variable", yellow(name)), loc);
+            ok = false;
+        }
+    }
+
+    std::vector<std::pair<IdentifierExpression*, bool>> ids;
+    std::vector<CallExpression*> calls;
+    find_identifiers(proc->body(), false, ids, calls);
+
+    for(auto c : calls) {
+        error(pprintf("the PROCEDURE '%' has a TABLE, so it can't call '%'",
+                      yellow(proc->name()), yellow(c->name())), c->location());
+        ok = false;
+    }
+
+    std::set<std::string> assigned;
+    for(auto& id : ids) {
+        auto var = id.first->symbol()->is_variable();
+        if(!var) continue; // local variables and the argument
+        auto const& name = var->name();
+        if(is_output(name)) {
+            if(id.second) assigned.insert(name);
+        }
+        else if(id.second) {
+            error(pprintf("the PROCEDURE '%' has a TABLE, so it can only assign"
+                          " to LOCAL and TABLE variables, not '%'",
+                          yellow(proc->name()), yellow(name)), id.first->location());
+            ok = false;
+        }
+        else if(var->is_range() || var->is_state()) {
+            error(pprintf("the PROCEDURE '%' has a TABLE, so it can't read '%',"
+                          " which differs between instances",
+                          yellow(proc->name()), yellow(name)), id.first->location());
+            ok = false;
+        }
+        else if(!is_depend(name)) {
+            error(pprintf("the TABLE of '%' must list '%' as a DEPEND variable",
+                          yellow(proc->name()), yellow(name)), id.first->location());
+            ok = false;
+        }
+    }
+    for(auto& name : outputs) {
+        if(ok && !assigned.count(name)) {
+            warning(pprintf("TABLE variable '%' is not assigned in '%'",
+                            yellow(name), yellow(proc->name())), loc);
+        }
+    }
+
+    return ok;
+}
+
 /// populate the symbol table with class scope variables
 void Module::add_variables_to_symbols() {
     // add reserved symbols (not v, because for some reason it has to be added
@@ -822,3 +992,28 @@ bool Module::optimize() {
 
     return true;
 }
+
+bool Module::simplify(bool strength_reduction) {
+    for(auto &symbol : symbols_) {
+        auto proc = symbol.second->is_procedure();
+        if(proc == nullptr) continue;
+
+        // the derivative, kinetic and other blocks have been lowered into
+        // procedures and APIMethods by semantic analysis
+        auto pkind = proc->kind();
+        if(pkind != procedureKind::normal && pkind != procedureKind::api
+            && pkind != procedureKind::net_receive)
+        {
+            continue;
+        }
+
+        // strength reduction first, so that x/10 and x*0.1 are recognised
+        // as the same subexpression
+        if(strength_reduction) {
+            reduce_strength(proc->body());
+        }
+        eliminate_common_subexpressions(proc->body());
+    }
+
+    return true;
+}
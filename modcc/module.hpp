@@ -87,6 +87,9 @@ public :
     void add_variables_to_symbols();
     bool semantic();
     bool optimize();
+    // reduce the number of operations in procedures and API methods;
+    // strength reduction changes results by up to one ulp, so it is optional
+    bool simplify(bool strength_reduction=false);
 private :
     moduleKind kind_;
     std::string title_;
@@ -97,6 +100,9 @@ private :
     bool generate_current_api();
     bool generate_state_api();
 
+    // check that a procedure with a TABLE statement can be tabulated
+    bool semantic_table(ProcedureExpression* proc);
+
     // error handling
     std::string error_string_;
     lexerStatus status_ = lexerStatus::happy;
@@ -12,6 +12,7 @@ struct Options {
     bool verbose = true;
     bool optimize = false;
     bool analysis = false;
+    bool catalogue = false;
     targetKind target = targetKind::cpu;
 
     void print() {
@@ -33,6 +34,8 @@ struct Options {
                   << std::string(61-11-3,' ') << cyan("|") << "\n";
         std::cout << cyan("| analysis ") << (analysis ? "yes" : "no ")
                   << std::string(61-11-3,' ') << cyan("|") << "\n";
+        std::cout << cyan("| catalog  ") << (catalogue ? "yes" : "no ")
+                  << std::string(61-11-3,' ') << cyan("|") << "\n";
         std::cout << cyan("." + std::string(60, '-') + ".") << std::endl;
     }
 
@@ -767,10 +767,28 @@ symbol_ptr Parser::parse_procedure() {
     expression_ptr body = parse_block(false);
     if(body==nullptr) return nullptr;
 
+    // move the TABLE statement, if there is one, out of the body of a
+    // PROCEDURE, where it would otherwise be reported as an error
+    expression_ptr table;
+    if(kind == procedureKind::normal) {
+        auto& stmts = body->is_block()->statements();
+        for(auto it=stmts.begin(); it!=stmts.end(); ++it) {
+            if((*it)->is_table_statement()) {
+                table = std::move(*it);
+                stmts.erase(it);
+                break;
+            }
+        }
+    }
+
     auto proto = p->is_prototype();
     if(kind != procedureKind::net_receive) {
-        return make_symbol<ProcedureExpression>
+        auto proc = make_symbol<ProcedureExpression>
             (proto->location(), proto->name(), std::move(proto->args()), std::move(body), kind);
+        if(table) {
+            proc->is_procedure()->table(std::move(table));
+        }
+        return proc;
     }
     else {
         return make_symbol<NetReceiveExpression>
@@ -811,6 +829,8 @@ expression_ptr Parser::parse_statement() {
             break;
         case tok::conductance :
             return parse_conductance();
+        case tok::table :
+            return parse_table();
         case tok::solve :
             return parse_solve();
         case tok::local :
@@ -1312,8 +1332,16 @@ expression_ptr Parser::parse_solve() {
     }
     else {
         get_token(); // consume the METHOD keyword
-        if(token_.type != tok::cnexp) goto solve_statement_error;
-        method = solverMethod::cnexp;
+        switch(token_.type) {
+            case tok::cnexp :
+                method = solverMethod::cnexp;
+                break;
+            case tok::sparse :
+                method = solverMethod::sparse;
+                break;
+            default :
+                goto solve_statement_error;
+        }
 
         get_token(); // consume the method description
     }
@@ -1329,7 +1357,9 @@ solve_statement_error:
            "  SOLVE x METHOD cnexp\n"
            "    or\n"
            "  SOLVE x\n"
-           "where 'x' is the name of a DERIVATIVE block", loc);
+           "where 'x' is the name of a DERIVATIVE block, or\n"
+           "  SOLVE x METHOD sparse\n"
+           "where 'x' is the name of a KINETIC block", loc);
     return nullptr;
 }
 
@@ -1383,6 +1413,83 @@ conductance_statement_error:
     return nullptr;
 }
 
+/// parse a TABLE statement
+/// a TABLE statement specifies the variables assigned by a PROCEDURE that
+/// are interpolated from a table, the parameters on which the table depends,
+/// and the range and number of intervals of the table
+///     TABLE x, y DEPEND a, b FROM lo TO hi WITH n
+///     TABLE x, y FROM lo TO hi WITH n
+expression_ptr Parser::parse_table() {
+    Location loc = location_; // table location for expression
+    std::vector<std::string> outputs;
+    std::vector<std::string> depends;
+    long double from, to;
+    int n;
+
+    // parse a comma separated list of identifiers
+    auto parse_names = [this] (std::vector<std::string>& names) {
+        while(true) {
+            if(token_.type != tok::identifier) return false;
+            names.push_back(token_.spelling);
+            get_token(); // consume the identifier
+            if(token_.type != tok::comma) return true;
+            get_token(); // consume ','
+        }
+    };
+
+    // parse a number, which may be negative
+    auto parse_number = [this] (long double& value) {
+        bool negative = token_.type == tok::minus;
+        if(negative) get_token(); // consume '-'
+        if(token_.type != tok::integer && token_.type != tok::real) return false;
+        value = std::stold(token_.spelling);
+        if(negative) value = -value;
+        get_token(); // consume the number
+        return true;
+    };
+
+    get_token(); // consume the TABLE keyword
+
+    if(!parse_names(outputs)) goto table_statement_error;
+
+    if(token_.type == tok::depend) {
+        get_token(); // consume the DEPEND keyword
+        if(!parse_names(depends)) goto table_statement_error;
+    }
+
+    if(token_.type != tok::from) goto table_statement_error;
+    get_token(); // consume the FROM keyword
+    if(!parse_number(from)) goto table_statement_error;
+
+    if(token_.type != tok::to) goto table_statement_error;
+    get_token(); // consume the TO keyword
+    if(!parse_number(to)) goto table_statement_error;
+
+    if(token_.type != tok::with) goto table_statement_error;
+    get_token(); // consume the WITH keyword
+    if(token_.type != tok::integer) goto table_statement_error;
+    n = std::stoi(token_.spelling);
+    get_token(); // consume the number of intervals
+
+    if(!(from < to) || n < 1) {
+        error("a TABLE must have FROM less than TO, and WITH at least 1", loc);
+        return nullptr;
+    }
+
+    return make_expression<TableExpression>(
+        loc, std::move(outputs), std::move(depends), from, to, n);
+
+table_statement_error:
+    error( "TABLE statements must have the form\n"
+           "  TABLE x, y DEPEND a, b FROM lo TO hi WITH n\n"
+           "    or\n"
+           "  TABLE x, y FROM lo TO hi WITH n\n"
+           "where 'x' and 'y' are variables assigned in the PROCEDURE,"
+           " 'a' and 'b' are the parameters on which they depend,"
+           " and the table has 'n' intervals in [lo, hi]", loc);
+    return nullptr;
+}
+
 expression_ptr Parser::parse_if() {
     Token if_token = token_;
     get_token(); // consume 'if'
@@ -0,0 +1,319 @@
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "astmanip.hpp"
+#include "expression.hpp"
+#include "simplifier.hpp"
+#include "token.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+//  strength reduction
+///////////////////////////////////////////////////////////////////////////////
+
+// the reciprocal of the divisor, if e is a division by a finite nonzero literal
+static bool reciprocal_divisor(Expression* e, long double& r) {
+    auto b = e->is_binary();
+    if(b==nullptr || b->op()!=tok::divide) return false;
+
+    auto n = b->rhs()->is_number();
+    if(n==nullptr || n->value()==0 || !std::isfinite(n->value())) return false;
+
+    r = 1/n->value();
+    return std::isfinite(r);
+}
+
+// a*(1/c), replacing a/c
+static expression_ptr reduced_division(BinaryExpression* e, long double r, scope_ptr scope) {
+    auto loc = e->location();
+    auto m = binary_expression(loc, tok::times,
+        e->lhs()->clone(), make_expression<NumberExpression>(loc, r));
+    m->semantic(scope);
+    return m;
+}
+
+static int reduce_strength(Expression* e, scope_ptr scope) {
+    int count = 0;
+    long double r;
+    if(auto b = e->is_binary()) {
+        count += reduce_strength(b->lhs(), scope);
+        count += reduce_strength(b->rhs(), scope);
+        if(reciprocal_divisor(b->lhs(), r)) {
+            b->replace_lhs(reduced_division(b->lhs()->is_binary(), r, scope));
+            ++count;
+        }
+        if(reciprocal_divisor(b->rhs(), r)) {
+            b->replace_rhs(reduced_division(b->rhs()->is_binary(), r, scope));
+            ++count;
+        }
+    }
+    else if(auto u = e->is_unary()) {
+        count += reduce_strength(u->expression(), scope);
+        if(reciprocal_divisor(u->expression(), r)) {
+            u->replace_expression(reduced_division(u->expression()->is_binary(), r, scope));
+            ++count;
+        }
+    }
+    else if(auto c = e->is_function_call()) {
+        for(auto& arg : c->args()) {
+            count += reduce_strength(arg.get(), scope);
+            if(reciprocal_divisor(arg.get(), r)) {
+                arg = reduced_division(arg->is_binary(), r, scope);
+                ++count;
+            }
+        }
+    }
+    else if(auto f = e->is_if()) {
+        count += reduce_strength(f->condition(), scope);
+        count += reduce_strength(f->true_branch(), scope);
+        if(f->false_branch()) {
+            count += reduce_strength(f->false_branch(), scope);
+        }
+    }
+    else if(auto block = e->is_block()) {
+        for(auto& stmt : block->statements()) {
+            count += reduce_strength(stmt.get(), scope);
+        }
+    }
+    return count;
+}
+
+int reduce_strength(BlockExpression* block) {
+    return reduce_strength(block, block->scope());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  common subexpression elimination
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+    // the structure of an expression that could be eliminated
+    struct subexpression {
+        Expression* expression = nullptr;
+        // the same for all expressions with the same structure
+        std::string key;
+        // the number of nodes in the expression
+        int size = 0;
+        // the variables that the value of the expression depends on
+        std::set<std::string> dependencies;
+    };
+
+    // the occurrences of a subexpression in a run of statements
+    struct candidate {
+        subexpression sub;
+        int first = 0;
+        int last = 0;
+        int count = 0;
+    };
+
+    using statement_iterator = std::list<expression_ptr>::iterator;
+}
+
+// Describe the structure of e, appending every subexpression of e that could
+// be eliminated, including e itself, to subs. Returns false if e can't be
+// part of an eliminated subexpression, e.g. if it contains a function call.
+static bool describe(Expression* e, subexpression& d, std::vector<subexpression>& subs) {
+    d.expression = e;
+    if(auto n = e->is_number()) {
+        // hexadecimal, so that the key distinguishes every value
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%La", n->value());
+        d.key = buffer;
+        d.size = 1;
+        return true;
+    }
+    if(auto id = e->is_identifier()) {
+        d.key = id->spelling();
+        d.size = 1;
+        d.dependencies.insert(id->spelling());
+        return true;
+    }
+    if(auto u = e->is_unary()) {
+        subexpression arg;
+        if(!describe(u->expression(), arg, subs)) return false;
+        d.key = "(" + token_string(u->op()) + " " + arg.key + ")";
+        d.size = arg.size+1;
+        d.dependencies = std::move(arg.dependencies);
+    }
+    else if(auto b = e->is_binary()) {
+        subexpression lhs, rhs;
+        bool valid = describe(b->lhs(), lhs, subs);
+        valid = describe(b->rhs(), rhs, subs) && valid;
+        if(!valid) return false;
+        d.key = "(" + lhs.key + " " + token_string(b->op()) + " " + rhs.key + ")";
+        d.size = lhs.size+rhs.size+1;
+        d.dependencies = std::move(lhs.dependencies);
+        d.dependencies.insert(rhs.dependencies.begin(), rhs.dependencies.end());
+    }
+    else {
+        if(auto c = e->is_function_call()) {
+            for(auto& arg : c->args()) {
+                subexpression a;
+                describe(arg.get(), a, subs);
+            }
+        }
+        return false;
+    }
+
+    // expressions of literals are left to the constant folder
+    if(!d.dependencies.empty()) {
+        subs.push_back(d);
+    }
+    return true;
+}
+
+static std::string key_of(Expression* e) {
+    subexpression d;
+    std::vector<subexpression> subs;
+    return describe(e, d, subs)? d.key: std::string();
+}
+
+// replace each subexpression of e with the given key by a copy of id
+static void replace_subexpressions(
+    Expression* e, const std::string& key, Expression* id, scope_ptr scope)
+{
+    auto replacement = [&]() {
+        auto r = id->clone();
+        r->semantic(scope);
+        return r;
+    };
+
+    if(auto b = e->is_binary()) {
+        // the lhs of an assignment is a variable, which is never eliminated
+        if(key_of(b->lhs())==key) {
+            b->replace_lhs(replacement());
+        }
+        else {
+            replace_subexpressions(b->lhs(), key, id, scope);
+        }
+        if(key_of(b->rhs())==key) {
+            b->replace_rhs(replacement());
+        }
+        else {
+            replace_subexpressions(b->rhs(), key, id, scope);
+        }
+    }
+    else if(auto u = e->is_unary()) {
+        if(key_of(u->expression())==key) {
+            u->replace_expression(replacement());
+        }
+        else {
+            replace_subexpressions(u->expression(), key, id, scope);
+        }
+    }
+    else if(auto c = e->is_function_call()) {
+        for(auto& arg : c->args()) {
+            if(key_of(arg.get())==key) {
+                arg = replacement();
+            }
+            else {
+                replace_subexpressions(arg.get(), key, id, scope);
+            }
+        }
+    }
+}
+
+// Eliminate the largest subexpression that occurs more than once in a run of
+// the statements. Returns false if there is no such subexpression.
+static bool eliminate_largest(std::list<expression_ptr>& statements, scope_ptr scope) {
+    std::vector<statement_iterator> stmts;
+    std::map<std::string, candidate> open;
+    std::vector<candidate> closed;
+
+    // close the candidates that depend on name, or all candidates if name
+    // is empty
+    auto close = [&](const std::string& name) {
+        for(auto it=open.begin(); it!=open.end();) {
+            if(name.empty() || it->second.sub.dependencies.count(name)) {
+                closed.push_back(std::move(it->second));
+                it = open.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    };
+
+    for(auto s=statements.begin(); s!=statements.end(); ++s) {
+        auto stmt = s->get();
+        if(stmt->is_local_declaration()) continue;
+
+        int k = stmts.size();
+        stmts.push_back(s);
+
+        auto a = stmt->is_assignment();
+        if(a==nullptr || !a->lhs()->is_identifier()) {
+            // procedure calls and if statements end the run
+            close("");
+            continue;
+        }
+
+        subexpression rhs;
+        std::vector<subexpression> subs;
+        describe(a->rhs(), rhs, subs);
+        for(auto& sub : subs) {
+            auto& c = open[sub.key];
+            if(c.count==0) {
+                c.sub = sub;
+                c.first = k;
+            }
+            c.last = k;
+            ++c.count;
+        }
+
+        // the value of subexpressions that depend on the variable that is
+        // assigned to changes after this statement
+        auto const& name = a->lhs()->is_identifier()->spelling();
+        close(name);
+    }
+    close("");
+
+    const candidate* best = nullptr;
+    for(auto& c : closed) {
+        if(c.count<2) continue;
+        if(best==nullptr || c.sub.size>best->sub.size
+            || (c.sub.size==best->sub.size && c.first<best->first))
+        {
+            best = &c;
+        }
+    }
+    if(best==nullptr) return false;
+
+    // assign the subexpression to a new local before its first occurrence,
+    // then replace every occurrence with the local
+    auto local = make_unique_local_assign(scope, best->sub.expression, "cse");
+    auto first = stmts[best->first];
+    statements.insert(first, std::move(local.local_decl));
+    statements.insert(first, std::move(local.assignment));
+    for(auto k=best->first; k<=best->last; ++k) {
+        replace_subexpressions(stmts[k]->get(), best->sub.key, local.id.get(), scope);
+    }
+
+    return true;
+}
+
+static int eliminate_common_subexpressions(Expression* e) {
+    int count = 0;
+    if(auto block = e->is_block()) {
+        while(eliminate_largest(block->statements(), block->scope())) {
+            ++count;
+        }
+        for(auto& stmt : block->statements()) {
+            count += eliminate_common_subexpressions(stmt.get());
+        }
+    }
+    else if(auto f = e->is_if()) {
+        count += eliminate_common_subexpressions(f->true_branch());
+        if(f->false_branch()) {
+            count += eliminate_common_subexpressions(f->false_branch());
+        }
+    }
+    return count;
+}
+
+int eliminate_common_subexpressions(BlockExpression* block) {
+    return eliminate_common_subexpressions(static_cast<Expression*>(block));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// Simplifications that reduce the number of floating point operations in the
+// statement lists of procedures and API methods. They are applied after
+// semantic analysis, when function calls have been inlined.
+
+#include "expression.hpp"
+
+// Replace each division by a finite nonzero literal with multiplication by its
+// reciprocal in the statements of the block and the blocks nested in it,
+// e.g.
+//      a = x/10
+// becomes
+//      a = x*0.1
+// Returns the number of divisions that were replaced.
+int reduce_strength(BlockExpression* block);
+
+// Eliminate subexpressions that are evaluated more than once in a straight
+// run of assignments in the block and the blocks nested in it, by assigning
+// them to a new local variable before their first use, e.g.
+//      a = exp(-(v+65)/18)
+//      b = exp(-(v+65)/20)
+// becomes
+//      LOCAL cse0_
+//      cse0_ = -(v+65)
+//      a = exp(cse0_/18)
+//      b = exp(cse0_/20)
+// A subexpression is only reused while none of the variables in it have been
+// assigned to, and calls to procedures and if statements end a run.
+// The largest common subexpression is eliminated first.
+// Returns the number of subexpressions that were eliminated.
+int eliminate_common_subexpressions(BlockExpression* block);
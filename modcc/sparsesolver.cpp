@@ -0,0 +1,180 @@
+#include <string>
+
+#include "astmanip.hpp"
+#include "modccutil.hpp"
+#include "parser.hpp"
+#include "sparsesolver.hpp"
+
+void SparseSolverVisitor::reset() {
+    statements_.clear();
+    species_.clear();
+    species_index_.clear();
+    rates_.clear();
+    num_reactions_ = 0;
+    error_message_.clear();
+    error_location_ = Location();
+}
+
+void SparseSolverVisitor::error(std::string const& msg, Location loc) {
+    // only report the first error
+    if(!has_error()) {
+        error_message_ = msg;
+        error_location_ = loc;
+    }
+}
+
+void SparseSolverVisitor::add_statement(std::string const& s) {
+    statements_.push_back(Parser(s).parse_line_expression());
+}
+
+void SparseSolverVisitor::add_local(std::string const& name) {
+    statements_.push_back(Parser("LOCAL " + name).parse_local());
+}
+
+// By default, copy statements across verbatim.
+void SparseSolverVisitor::visit(Expression* e) {
+    statements_.push_back(e->clone());
+}
+
+void SparseSolverVisitor::visit(BlockExpression* e) {
+    for(auto& s: e->statements()) {
+        s->accept(this);
+    }
+}
+
+void SparseSolverVisitor::visit(ProcedureExpression* e) {
+    reset();
+    e->body()->accept(this);
+    if(!has_error()) {
+        solve();
+    }
+}
+
+int SparseSolverVisitor::reaction_species(Expression* side) {
+    auto stoich = side->is_stoich();
+    if(!stoich || stoich->terms().size()!=1) return -1;
+
+    auto term = stoich->terms().front()->is_stoich_term();
+    auto coeff = term->coeff()->is_integer();
+    if(!coeff || coeff->integer_value()!=1) return -1;
+
+    auto id = term->ident()->is_identifier();
+    auto sym = id->symbol();
+    if(!sym || !sym->is_variable() || !sym->is_variable()->is_state()) {
+        error("'" + yellow(id->spelling()) + "' is not a STATE variable",
+              id->location());
+        return -1;
+    }
+
+    auto it = species_index_.find(id->spelling());
+    if(it!=species_index_.end()) {
+        return it->second;
+    }
+    int index = species_.size();
+    species_.push_back(id->spelling());
+    species_index_[id->spelling()] = index;
+    return index;
+}
+
+void SparseSolverVisitor::visit(ReactionExpression* e) {
+    auto loc = e->location();
+    int a = reaction_species(e->lhs().get());
+    int b = reaction_species(e->rhs().get());
+    if(has_error()) return;
+    if(a<0 || b<0) {
+        error("METHOD sparse can only solve first order reactions, with one"
+              " species on each side, e.g. ~ a <-> b (kf, kb)", loc);
+        return;
+    }
+    if(a==b) return;
+
+    // evaluate the rates here, because the variables in them may be
+    // assigned to later in the block
+    auto n = std::to_string(num_reactions_++);
+    auto kf = "kf" + n + "_";
+    auto kb = "kb" + n + "_";
+    add_local(kf);
+    add_local(kb);
+    statements_.push_back(binary_expression(loc, tok::eq,
+        make_expression<IdentifierExpression>(loc, kf), e->fwd_rate()->clone()));
+    statements_.push_back(binary_expression(loc, tok::eq,
+        make_expression<IdentifierExpression>(loc, kb), e->rev_rate()->clone()));
+
+    // a -> b at rate kf, and b -> a at rate kb
+    rates_[{a, a}].push_back(kf);
+    rates_[{b, a}].push_back(kf);
+    rates_[{b, b}].push_back(kb);
+    rates_[{a, b}].push_back(kb);
+}
+
+void SparseSolverVisitor::solve() {
+    int n = species_.size();
+
+    auto j = [](int row, int col) {
+        return "j_" + std::to_string(row) + "_" + std::to_string(col) + "_";
+    };
+
+    // the nonzero entries of the matrix, including those filled in by the
+    // elimination
+    std::set<std::pair<int, int>> nonzero;
+
+    // J = I + dt K
+    for(int row=0; row<n; ++row) {
+        for(int col=0; col<n; ++col) {
+            auto it = rates_.find({row, col});
+            if(row!=col && it==rates_.end()) continue;
+
+            std::string entry = "1";
+            if(it!=rates_.end()) {
+                std::string sum;
+                for(auto& r: it->second) {
+                    sum += (sum.empty()? "": "+") + r;
+                }
+                entry = (row==col? "1+": "-") + std::string("dt*(") + sum + ")";
+            }
+            add_local(j(row, col));
+            add_statement(j(row, col) + " = " + entry);
+            nonzero.insert({row, col});
+        }
+    }
+
+    // forward elimination, applied to the species in place
+    for(int p=0; p<n; ++p) {
+        for(int row=p+1; row<n; ++row) {
+            if(!nonzero.count({row, p})) continue;
+
+            auto f = "f_" + std::to_string(row) + "_" + std::to_string(p) + "_";
+            add_local(f);
+            add_statement(f + " = " + j(row, p) + "/" + j(p, p));
+            for(int col=p+1; col<n; ++col) {
+                if(!nonzero.count({p, col})) continue;
+
+                if(nonzero.count({row, col})) {
+                    add_statement(j(row, col) + " = " + j(row, col) + "-" + f + "*" + j(p, col));
+                }
+                else {
+                    add_local(j(row, col));
+                    add_statement(j(row, col) + " = -" + f + "*" + j(p, col));
+                    nonzero.insert({row, col});
+                }
+            }
+            add_statement(species_[row] + " = " + species_[row] + "-" + f + "*" + species_[p]);
+        }
+    }
+
+    // back substitution
+    for(int row=n-1; row>=0; --row) {
+        std::string rhs = species_[row];
+        bool has_terms = false;
+        for(int col=row+1; col<n; ++col) {
+            if(nonzero.count({row, col})) {
+                rhs += "-" + j(row, col) + "*" + species_[col];
+                has_terms = true;
+            }
+        }
+        if(has_terms) {
+            rhs = "(" + rhs + ")";
+        }
+        add_statement(species_[row] + " = " + rhs + "/" + j(row, row));
+    }
+}
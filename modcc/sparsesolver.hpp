@@ -0,0 +1,110 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "expression.hpp"
+#include "location.hpp"
+#include "visitor.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// visitor that lowers a KINETIC block solved with METHOD sparse to statements
+// that advance its species over one time step dt with the backward Euler
+// method
+//
+// The reactions must be first order, i.e. have one species with coefficient
+// one on each side, so that the system is linear:
+//      s' = -K s
+// where K is the matrix of transition rates. Each time step solves
+//      (I + dt K) s(t+dt) = s(t)
+// for every instance, by Gaussian elimination of the nonzero entries of the
+// matrix, which is unconditionally stable for stiff systems.
+//
+// e.g. the block
+//
+//  KINETIC kin {
+//      ~ c <-> o (kf, kb)
+//  }
+//
+// is lowered to
+//
+//  LOCAL kf0_, kb0_, j_0_0_, j_0_1_, j_1_0_, j_1_1_, f_1_0_
+//  kf0_ = kf
+//  kb0_ = kb
+//  j_0_0_ = 1+dt*(kf0_)
+//  j_0_1_ = -dt*(kb0_)
+//  j_1_0_ = -dt*(kf0_)
+//  j_1_1_ = 1+dt*(kb0_)
+//  f_1_0_ = j_1_0_/j_0_0_
+//  j_1_1_ = j_1_1_-f_1_0_*j_0_1_
+//  o = o-f_1_0_*c
+//  o = o/j_1_1_
+//  c = (c-j_0_1_*o)/j_0_0_
+//
+// The columns of K sum to zero, so the matrix is diagonally dominant by
+// columns, and elimination without pivoting is stable. It also conserves the
+// sum of the species, so CONSERVE statements are not required, and are
+// ignored. Other statements are copied verbatim, and the rates of each
+// reaction are evaluated where the reaction is in the block.
+///////////////////////////////////////////////////////////////////////////////
+class SparseSolverVisitor : public Visitor {
+public:
+    using stmt_list_type = std::list<expression_ptr>;
+
+    void visit(Expression *e)           override;
+    void visit(UnaryExpression *e)      override { visit((Expression*)e); }
+    void visit(BinaryExpression *e)     override { visit((Expression*)e); }
+    void visit(ConserveExpression *e)   override {}
+    void visit(ReactionExpression *e)   override;
+    void visit(BlockExpression *e)      override;
+    void visit(ProcedureExpression *e)  override;
+
+    // the lowered statements
+    stmt_list_type& statements() {
+        return statements_;
+    }
+
+    bool has_error() const {
+        return !error_message_.empty();
+    }
+    std::string const& error_message() const {
+        return error_message_;
+    }
+    Location const& error_location() const {
+        return error_location_;
+    }
+
+private:
+    stmt_list_type statements_;
+
+    // the species, in the order in which they appear in reactions
+    std::vector<std::string> species_;
+    std::map<std::string, int> species_index_;
+
+    // the rates that contribute to each nonzero entry of K: the rates out of
+    // a species on the diagonal, and the rates into a species, which are
+    // negated, off the diagonal
+    std::map<std::pair<int, int>, std::vector<std::string>> rates_;
+
+    int num_reactions_ = 0;
+
+    std::string error_message_;
+    Location error_location_;
+
+    void reset();
+    void error(std::string const& msg, Location loc);
+
+    // the index of the species of one side of a reaction, or -1 if the
+    // side is not a single species with coefficient one
+    int reaction_species(Expression* side);
+
+    // append the statements that solve the linear system
+    void solve();
+
+    void add_statement(std::string const& s);
+    void add_local(std::string const& name);
+};
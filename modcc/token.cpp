@@ -52,11 +52,17 @@ static Keyword keywords[] = {
     {"if",          tok::if_stmt},
     {"else",        tok::else_stmt},
     {"cnexp",       tok::cnexp},
+    {"sparse",      tok::sparse},
     {"exp",         tok::exp},
     {"sin",         tok::sin},
     {"cos",         tok::cos},
     {"log",         tok::log},
     {"CONDUCTANCE", tok::conductance},
+    {"TABLE",       tok::table},
+    {"DEPEND",      tok::depend},
+    {"FROM",        tok::from},
+    {"TO",          tok::to},
+    {"WITH",        tok::with},
     {nullptr,       tok::reserved},
 };
 
@@ -120,7 +126,13 @@ static TokenString token_strings[] = {
     {"cos",         tok::cos},
     {"sin",         tok::sin},
     {"cnexp",       tok::cnexp},
+    {"sparse",      tok::sparse},
     {"CONDUCTANCE", tok::conductance},
+    {"TABLE",       tok::table},
+    {"DEPEND",      tok::depend},
+    {"FROM",        tok::from},
+    {"TO",          tok::to},
+    {"WITH",        tok::with},
     {"error",       tok::reserved},
 };
 
@@ -69,10 +69,13 @@ enum class tok {
     if_stmt, else_stmt, // add _stmt to avoid clash with c++ keywords
 
     // solver methods
-    cnexp,
+    cnexp, sparse,
 
     conductance,
 
+    // lookup tables
+    table, depend, from, to, with,
+
     reserved, // placeholder for generating keyword lookup
 };
 
@@ -274,6 +274,89 @@ std::vector<typename C::value_type> make_parent_index(
 }
 
 
+/// Depth first numbering of the nodes of a tree (or forest), in which
+/// the parent of each node precedes it and each root is its own parent.
+///
+/// Returns the new index of each node. The children of a node are visited
+/// in the order of their original indexes, and the nodes of each sub-tree
+/// have a contiguous range of new indexes, starting with its root.
+template<typename C>
+std::vector<typename C::value_type> depth_first_numbering(const C& parent_index)
+{
+    using value_type = typename C::value_type;
+    static_assert(
+        std::is_integral<value_type>::value,
+        "integral type required"
+    );
+
+    auto n = parent_index.size();
+
+    // the children of each node, in order
+    std::vector<value_type> child_divs(n+1, 0);
+    for (std::size_t i=0; i<n; ++i) {
+        auto p = parent_index[i];
+        EXPECTS(std::size_t(p)<=i);
+        if (std::size_t(p)!=i) {
+            ++child_divs[p+1];
+        }
+    }
+    std::partial_sum(child_divs.begin(), child_divs.end(), child_divs.begin());
+    std::vector<value_type> children(child_divs.back());
+    auto pos = child_divs;
+    for (std::size_t i=0; i<n; ++i) {
+        auto p = parent_index[i];
+        if (std::size_t(p)!=i) {
+            children[pos[p]++] = i;
+        }
+    }
+
+    std::vector<value_type> numbering(n);
+    std::vector<value_type> stack;
+    value_type next = 0;
+    for (std::size_t root=0; root<n; ++root) {
+        if (std::size_t(parent_index[root])!=root) {
+            continue;
+        }
+        stack.push_back(root);
+        while (!stack.empty()) {
+            auto i = stack.back();
+            stack.pop_back();
+            numbering[i] = next++;
+            // push in reverse so that the first child is visited first
+            for (auto j=child_divs[i+1]; j>child_divs[i]; --j) {
+                stack.push_back(children[j-1]);
+            }
+        }
+    }
+
+    return numbering;
+}
+
+/// Partition an index into maximal runs of consecutive values.
+///
+/// Returns the divisions of the partition: run k is the range of positions
+/// [divs[k], divs[k+1]), over which index[i] = index[divs[k]] + i - divs[k].
+template<typename C>
+std::vector<typename C::value_type> contiguous_runs(const C& index)
+{
+    using value_type = typename C::value_type;
+    static_assert(
+        std::is_integral<value_type>::value,
+        "integral type required"
+    );
+
+    std::vector<value_type> divs;
+    auto n = index.size();
+    for (std::size_t i=0; i<n; ++i) {
+        if (i==0 || index[i]!=index[i-1]+1) {
+            divs.push_back(i);
+        }
+    }
+    divs.push_back(n);
+
+    return divs;
+}
+
 template<typename Seq, typename = util::enable_if_sequence_t<Seq>>
 bool is_sorted(const Seq& seq) {
     return std::is_sorted(std::begin(seq), std::end(seq));
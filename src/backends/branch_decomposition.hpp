@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <util/debug.hpp>
+#include <util/span.hpp>
+
+namespace nest {
+namespace mc {
+namespace multicore {
+
+/// Decomposition of the tree of a cell into independent sub-trees, that can
+/// be eliminated in parallel by the Hines solver, and the remaining nodes
+/// near the root of the tree, which form a reduced system that couples the
+/// sub-trees at the branch points where they join it.
+///
+/// Each sub-tree is a maximal sub-tree with at most max_subtree_size nodes,
+/// so sub-trees are cut at branch points, as with algorithms::branches.
+/// All node indexes are indexes into the parent index of the matrix, which
+/// may hold other cells.
+template <typename Size>
+struct branch_decomposition {
+    using size_type = Size;
+
+    /// the first node (the root) and one past the last node of the cell
+    size_type first = 0;
+    size_type last = 0;
+
+    /// subtree_nodes[subtree_divisions[s]...] are the nodes of sub-tree s,
+    /// in ascending order, starting with the root of the sub-tree
+    std::vector<size_type> subtree_divisions;
+    std::vector<size_type> subtree_nodes;
+
+    /// the nodes that are in no sub-tree, in ascending order, starting with
+    /// the root of the cell
+    std::vector<size_type> reduced_nodes;
+
+    size_type num_subtrees() const {
+        return subtree_divisions.size()-1;
+    }
+};
+
+/// Decompose the cell with nodes [first, last) of the parent index.
+template <typename Size>
+branch_decomposition<Size> make_branch_decomposition(
+    const Size* parent_index, Size first, Size last, Size max_subtree_size)
+{
+    EXPECTS(first<last);
+    EXPECTS(max_subtree_size>0);
+
+    using util::make_span;
+
+    branch_decomposition<Size> dec;
+    dec.first = first;
+    dec.last = last;
+
+    auto n = last-first;
+    auto parent = [&](Size i) { return parent_index[first+i]-first; };
+
+    std::vector<Size> size(n, 1);
+    for (auto i=n-1; i>0; --i) {
+        size[parent(i)] += size[i];
+    }
+
+    // the sub-tree of each node, or npos for nodes in the reduced system:
+    // parents precede children, so the sub-tree of the parent is known
+    const Size npos = Size(-1);
+    std::vector<Size> subtree(n, npos);
+    std::vector<Size> counts;
+    for (auto i: make_span(Size(1), n)) {
+        auto p = parent(i);
+        if (subtree[p]!=npos) {
+            subtree[i] = subtree[p];
+            ++counts[subtree[i]];
+        }
+        else if (size[i]<=max_subtree_size) {
+            subtree[i] = counts.size();
+            counts.push_back(1);
+        }
+    }
+
+    dec.subtree_divisions.push_back(0);
+    for (auto c: counts) {
+        dec.subtree_divisions.push_back(dec.subtree_divisions.back()+c);
+    }
+    dec.subtree_nodes.resize(dec.subtree_divisions.back());
+
+    auto pos = dec.subtree_divisions;
+    for (auto i: make_span(Size(0), n)) {
+        if (subtree[i]==npos) {
+            dec.reduced_nodes.push_back(first+i);
+        }
+        else {
+            dec.subtree_nodes[pos[subtree[i]]++] = first+i;
+        }
+    }
+
+    return dec;
+}
+
+} // namespace multicore
+} // namespace mc
+} // namespace nest
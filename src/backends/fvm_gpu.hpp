@@ -90,7 +90,7 @@ struct backend {
         matrix_assembler() = default;
 
         matrix_assembler(
-            view d, view u, view rhs, const_iview p,
+            view d, view u, view rhs, const_iview p, const_iview cell_index,
             const_view cv_capacitance,
             const_view face_conductance,
             const_view voltage,
@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "fvm_multicore.hpp"
 
+#include <mechanism_catalogue.hpp>
+
 #include <mechanisms/multicore/hh.hpp>
 #include <mechanisms/multicore/pas.hpp>
 #include <mechanisms/multicore/expsyn.hpp>
@@ -9,6 +15,7 @@ namespace nest {
 namespace mc {
 namespace multicore {
 
+template <>
 std::map<std::string, backend::maker_type>
 backend::mech_map_ = {
     { std::string("pas"),     maker<mechanisms::pas::mechanism_pas> },
@@ -17,6 +24,53 @@ backend::mech_map_ = {
     { std::string("exp2syn"), maker<mechanisms::exp2syn::mechanism_exp2syn> }
 };
 
+template <>
+std::map<std::string, backend_f32::maker_type>
+backend_f32::mech_map_ = {
+    { std::string("pas"),     maker<mechanisms::pas::mechanism_pas> },
+    { std::string("hh"),      maker<mechanisms::hh::mechanism_hh> },
+    { std::string("expsyn"),  maker<mechanisms::expsyn::mechanism_expsyn> },
+    { std::string("exp2syn"), maker<mechanisms::exp2syn::mechanism_exp2syn> }
+};
+
+namespace {
+    template <typename Backend>
+    bool add_entry(const nmc_catalogue_entry& entry) {
+        if (Backend::name()!=entry.backend) {
+            return false;
+        }
+        Backend::add_mechanism(
+            entry.name,
+            reinterpret_cast<typename Backend::maker_type>(entry.maker));
+        return true;
+    }
+}
+
+std::vector<std::string> load_catalogue(const std::string& path) {
+    auto& catalogue = open_catalogue(path);
+
+    std::vector<std::string> names;
+    for (unsigned i=0; i<catalogue.size; ++i) {
+        auto& entry = catalogue.entries[i];
+        if (add_entry<backend>(entry) || add_entry<backend_f32>(entry)) {
+            names.push_back(entry.name);
+        }
+    }
+
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+std::vector<std::string> load_catalogues(const std::string& search_path) {
+    std::vector<std::string> names;
+    for (auto& path: find_catalogues(search_path)) {
+        auto loaded = load_catalogue(path);
+        names.insert(names.end(), loaded.begin(), loaded.end());
+    }
+    return names;
+}
+
 } // namespace multicore
 } // namespace mc
 } // namespace nest
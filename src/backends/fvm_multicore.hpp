@@ -1,26 +1,43 @@
+#pragma once
 
 #include <map>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include <common_types.hpp>
 #include <mechanism.hpp>
 #include <memory/memory.hpp>
+#include <threading/threading.hpp>
 #include <util/span.hpp>
 
+#include "branch_decomposition.hpp"
+#include "interleave.hpp"
 #include "stimulus_multicore.hpp"
 
 namespace nest {
 namespace mc {
 namespace multicore {
 
-struct backend {
+/// The multicore backend, with state of type Value.
+///
+/// The state of the cells, mechanisms and ions is stored with type Value,
+/// while the Hines matrix is always assembled and solved in double
+/// precision by the matrix_assembler, because the elimination of a
+/// long cable loses too many digits in single precision.
+template <typename Value>
+struct basic_backend {
     /// define the real and index types
-    using value_type = double;
+    using value_type = Value;
     using size_type  = nest::mc::cell_lid_type;
 
-    /// define storage types
-    using array  = memory::host_vector<value_type>;
-    using iarray = memory::host_vector<size_type>;
+    /// the type used in the assembly and solution of the matrix
+    using solver_value_type = double;
+
+    /// define storage types, which are allocated from the arena of the cell
+    /// group while it is initialized
+    using array  = memory::arena_vector<value_type>;
+    using iarray = memory::arena_vector<size_type>;
 
     using view       = typename array::view_type;
     using const_view = typename array::const_view_type;
@@ -34,6 +51,9 @@ struct backend {
     using host_view   = view;
     using host_iview  = iview;
 
+    using solver_array = memory::arena_vector<solver_value_type>;
+    using solver_view  = typename solver_array::view_type;
+
     static void hines_solve(
         view d, view u, view rhs,
         const_iview p, const_iview cell_index)
@@ -62,10 +82,11 @@ struct backend {
     }
 
     struct matrix_assembler {
-        view d;     // [μS]
-        view u;     // [μS]
-        view rhs;   // [nA]
+        solver_view d;      // [μS]
+        solver_view u;      // [μS]
+        solver_view rhs;    // [nA]
         const_iview p;
+        const_iview cell_index;
 
         const_view cv_capacitance;      // [pF]
         const_view face_conductance;    // [μS]
@@ -73,41 +94,439 @@ struct backend {
         const_view current;             // [nA]
 
         // the invariant part of the matrix diagonal
-        array invariant_d;              // [μS]
+        solver_array invariant_d;       // [μS]
+
+        /// The number of cells in each block of the interleaved layout:
+        /// the number of doubles in a SIMD register.
+#if defined(__AVX512F__)
+        static constexpr unsigned simd_width = 8;
+#elif defined(__AVX__)
+        static constexpr unsigned simd_width = 4;
+#else
+        static constexpr unsigned simd_width = 2;
+#endif
+
+        using layout_type = interleaved_layout<size_type>;
+        using decomposition_type = branch_decomposition<size_type>;
+
+        /// the smallest sub-tree size used by the branch parallel solver
+        static constexpr size_type min_subtree_size = 256;
+
+        /// the interleaved layout of the matrix with simd_width cells per block
+        static layout_type make_layout(
+            const std::vector<size_type>& parent_index,
+            const std::vector<size_type>& cell_index)
+        {
+            return make_interleaved_layout(parent_index, cell_index, simd_width);
+        }
 
         matrix_assembler() = default;
 
+        /// When value_type is double the system is assembled and solved in
+        /// the d, u and rhs views of the matrix. Otherwise the assembler
+        /// keeps its own double precision copy of the system, and only u
+        /// is written to the matrix.
         matrix_assembler(
-            view d, view u, view rhs, const_iview p,
+            view d, view u, view rhs, const_iview p, const_iview cell_index,
             const_view cv_capacitance,
             const_view face_conductance,
             const_view voltage,
             const_view current)
         :
-            d{d}, u{u}, rhs{rhs}, p{p},
+            p{p}, cell_index{cell_index},
             cv_capacitance{cv_capacitance}, face_conductance{face_conductance},
             voltage{voltage}, current{current}
         {
+            this->d = solver_storage(d, d_storage_);
+            this->u = solver_storage(u, u_storage_);
+            this->rhs = solver_storage(rhs, rhs_storage_);
+
             auto n = d.size();
-            invariant_d = array(n, 0);
+            invariant_d = solver_array(n, 0);
+            gi_ = solver_array(n);
+            diag_ = solver_array(n);
             for (auto i: util::make_span(1u, n)) {
                 auto gij = face_conductance[i];
 
                 u[i] = -gij;
+                this->u[i] = -gij;
                 invariant_d[i] += gij;
                 invariant_d[p[i]] += gij;
             }
         }
 
-        void assemble(value_type dt) {
+        // the d, u and rhs views may refer to storage owned by the assembler
+        matrix_assembler(matrix_assembler&&) = default;
+        matrix_assembler& operator=(matrix_assembler&&) = default;
+
+        void assemble(solver_value_type dt) {
+            set_dt(dt);
+
             auto n = d.size();
-            value_type factor = 1e-3/dt;
             for (auto i: util::make_span(0u, n)) {
-                auto gi = factor*cv_capacitance[i];
+                d[i] = diag_[i];
+
+                rhs[i] = gi_[i]*voltage[i] - current[i];
+            }
+        }
+
+        /// Update the terms of the assembly that depend on the time step,
+        /// if dt differs from the time step of the last assembly.
+        /// Returns true if they were updated.
+        /// dt is in double precision, like the rest of the solver, so that
+        /// single precision backends do not round the time step.
+        /// The terms of the flat layout are kept current in the interleaved
+        /// layout too, so that assemble() can still be used.
+        bool set_dt(solver_value_type dt) {
+            if (dt==dt_) {
+                return false;
+            }
+            dt_ = dt;
+
+            solver_value_type factor = 1e-3/dt;
+            for (auto i: util::make_span(0u, d.size())) {
+                gi_[i] = factor*cv_capacitance[i];
+                diag_[i] = gi_[i] + invariant_d[i];
+            }
+            if (interleaved_) {
+                for (auto k: util::make_span(0u, layout_.size())) {
+                    gi_i[k] = factor*cv_capacitance_i[k];
+                    diag_i[k] = gi_i[k] + invariant_d_i[k];
+                }
+            }
+            return true;
+        }
+
+        /// Assemble and solve the system one cell at a time, and store the
+        /// solution in x, which may alias voltage.
+        ///
+        /// Equivalent to assemble(dt), followed by hines_solve and a copy of
+        /// rhs to x, but each submatrix is still in cache when it is solved,
+        /// instead of streaming d, u, rhs and p from memory in each of the
+        /// three passes. On return rhs holds the right hand side after the
+        /// backward sweep, not the solution.
+        void assemble_and_solve(solver_value_type dt, view x) {
+            if (interleaved_) {
+                assemble_and_solve_interleaved(dt, x);
+                return;
+            }
+
+            const size_type ncells = cell_index.size()-1;
+            set_dt(dt);
+
+            for (auto m: util::make_span(0, ncells)) {
+                if (!decomposed_.empty() && decomposed_[m]!=npos) {
+                    solve_decomposed(decompositions_[decomposed_[m]], x);
+                    continue;
+                }
+
+                auto first = cell_index[m];
+                auto last = cell_index[m+1];
+
+                // assemble
+                for (auto i: util::make_span(first, last)) {
+                    d[i] = diag_[i];
+
+                    rhs[i] = gi_[i]*voltage[i] - current[i];
+                }
+
+                // backward sweep
+                for (auto i=last-1; i>first; --i) {
+                    auto scale = u[i] / d[i];
+                    d[p[i]]   -= scale * u[i];
+                    rhs[p[i]] -= scale * rhs[i];
+                }
+                x[first] = rhs[first] / d[first];
+
+                // forward sweep, writing the solution directly to x
+                for (auto i=first+1; i<last; ++i) {
+                    x[i] = (rhs[i] - u[i] * x[p[i]]) / d[i];
+                }
+            }
+        }
+
+        /// Use the interleaved layout in assemble_and_solve, which then
+        /// solves the cells of each block together, one lane per cell.
+        /// The d and rhs views are not used in the interleaved layout.
+        void interleave(const layout_type& l) {
+            EXPECTS(l.width==simd_width);
+            EXPECTS(l.slot.size()==d.size());
+
+            auto n = l.size();
+            layout_ = l;
+            d_i = solver_array(n);
+            rhs_i = solver_array(n);
+
+            // padding slots have unit diagonal and no coupling to their parents
+            u_i = solver_array(n, 0);
+            cv_capacitance_i = array(n, 0);
+            invariant_d_i = solver_array(n, 1);
+            gi_i = solver_array(n);
+            diag_i = solver_array(n);
+            cv_i = iarray(n, 0);
+            for (auto k: util::make_span(0u, n)) {
+                auto i = l.cv[k];
+                if (i!=l.npos) {
+                    u_i[k] = u[i];
+                    cv_capacitance_i[k] = cv_capacitance[i];
+                    invariant_d_i[k] = invariant_d[i];
+                    cv_i[k] = i;
+                }
+            }
+            p_i = iarray(memory::make_const_view(l.parent));
+
+            interleaved_ = true;
+            dt_ = 0;
+        }
 
-                d[i] = gi + invariant_d[i];
+        bool is_interleaved() const {
+            return interleaved_;
+        }
 
-                rhs[i] = gi*voltage[i] - current[i];
+        /// Solve each cell with at least min_size compartments with the
+        /// branch parallel solver, which eliminates the independent sub-trees
+        /// of the cell in parallel, then solves the reduced system at the
+        /// branch points where they join, then the sub-trees in parallel again.
+        /// Sub-trees have about 4 per thread of the compartments of the cell.
+        /// Returns the number of decomposed cells.
+        /// Not used in the interleaved layout.
+        size_type decompose_cells(size_type min_size) {
+            const size_type ncells = cell_index.size()-1;
+            const size_type nthreads = threading::num_threads();
+
+            decompositions_.clear();
+            decomposed_.assign(ncells, size_type(npos));
+            for (auto m: util::make_span(0, ncells)) {
+                auto first = cell_index[m];
+                auto last = cell_index[m+1];
+                if (last-first>=min_size) {
+                    auto subtree_size = std::max(size_type(min_subtree_size), (last-first)/(4*nthreads));
+                    decomposed_[m] = decompositions_.size();
+                    decompositions_.push_back(
+                        make_branch_decomposition(p.data(), first, last, subtree_size));
+                }
+            }
+            return decompositions_.size();
+        }
+
+    private:
+        static constexpr size_type npos = size_type(-1);
+
+        // the terms of the assembly that depend on the time step, for the
+        // time step dt_: the capacitance term and the diagonal
+        solver_value_type dt_ = 0;
+        solver_array gi_;       // [μS]
+        solver_array diag_;     // [μS]
+
+        // the double precision system, if value_type is not double
+        solver_array d_storage_, u_storage_, rhs_storage_;
+
+        static solver_view solver_storage(view v, solver_array&, std::true_type) {
+            return v;
+        }
+
+        static solver_view solver_storage(view v, solver_array& storage, std::false_type) {
+            storage = solver_array(v.size(), 0);
+            return storage;
+        }
+
+        static solver_view solver_storage(view v, solver_array& storage) {
+            return solver_storage(v, storage, std::is_same<value_type, solver_value_type>());
+        }
+
+        // branch decompositions of the large cells, and the index of the
+        // decomposition of each cell, or npos
+        std::vector<decomposition_type> decompositions_;
+        std::vector<size_type> decomposed_;
+
+        // the updates of each sub-tree to the diagonal and rhs of its parent
+        std::vector<solver_value_type> subtree_d_;
+        std::vector<solver_value_type> subtree_rhs_;
+
+        void solve_decomposed(const decomposition_type& dec, view x) {
+            const auto& nodes = dec.subtree_nodes;
+            const auto& divs = dec.subtree_divisions;
+            const auto& reduced = dec.reduced_nodes;
+            const int nsub = dec.num_subtrees();
+
+            auto assemble_node = [&](size_type i) {
+                d[i] = diag_[i];
+                rhs[i] = gi_[i]*voltage[i] - current[i];
+            };
+
+            for (auto i: reduced) {
+                assemble_node(i);
+            }
+
+            // assemble and eliminate each sub-tree up to its root, and save
+            // the update of the root to the reduced system
+            subtree_d_.resize(nsub);
+            subtree_rhs_.resize(nsub);
+            threading::parallel_for::apply(0, nsub,
+                [&](int s) {
+                    auto b = divs[s];
+                    auto e = divs[s+1];
+                    for (auto k=b; k<e; ++k) {
+                        assemble_node(nodes[k]);
+                    }
+                    for (auto k=e-1; k>b; --k) {
+                        auto i = nodes[k];
+                        auto scale = u[i] / d[i];
+                        d[p[i]]   -= scale * u[i];
+                        rhs[p[i]] -= scale * rhs[i];
+                    }
+                    auto r = nodes[b];
+                    auto scale = u[r] / d[r];
+                    subtree_d_[s] = scale * u[r];
+                    subtree_rhs_[s] = scale * rhs[r];
+                });
+
+            // solve the reduced system
+            for (auto s=0; s<nsub; ++s) {
+                auto j = p[nodes[divs[s]]];
+                d[j]   -= subtree_d_[s];
+                rhs[j] -= subtree_rhs_[s];
+            }
+            for (auto k=reduced.size()-1; k>0; --k) {
+                auto i = reduced[k];
+                auto scale = u[i] / d[i];
+                d[p[i]]   -= scale * u[i];
+                rhs[p[i]] -= scale * rhs[i];
+            }
+            x[dec.first] = rhs[dec.first] / d[dec.first];
+            for (auto k=1u; k<reduced.size(); ++k) {
+                auto i = reduced[k];
+                x[i] = (rhs[i] - u[i] * x[p[i]]) / d[i];
+            }
+
+            // forward sweep of the sub-trees
+            threading::parallel_for::apply(0, nsub,
+                [&](int s) {
+                    for (auto k=divs[s]; k<divs[s+1]; ++k) {
+                        auto i = nodes[k];
+                        x[i] = (rhs[i] - u[i] * x[p[i]]) / d[i];
+                    }
+                });
+        }
+
+        // interleaved storage of the matrix, and the constant terms of the
+        // assembly, indexed by slot of the interleaved layout
+        bool interleaved_ = false;
+        layout_type layout_;
+        solver_array d_i, u_i, rhs_i, invariant_d_i;
+        solver_array gi_i, diag_i;
+        array cv_capacitance_i;
+        iarray p_i;     // parent slot
+        iarray cv_i;    // compartment in slot, 0 for padding
+
+        // Eliminate a row of the interleaved layout whose lanes have their
+        // parents in the same lanes of the parent row. The rows do not
+        // overlap, and the updates are computed before they are applied,
+        // so that the lanes are updated together.
+        static void row_update(
+            const solver_value_type* d, const solver_value_type* u, const solver_value_type* rhs,
+            solver_value_type* d_parent, solver_value_type* rhs_parent)
+        {
+            constexpr auto W = simd_width;
+            solver_value_type upd_d[W], upd_rhs[W];
+            for (unsigned lane=0; lane<W; ++lane) {
+                auto scale = u[lane] / d[lane];
+                upd_d[lane] = scale * u[lane];
+                upd_rhs[lane] = scale * rhs[lane];
+            }
+            #pragma GCC ivdep
+            for (unsigned lane=0; lane<W; ++lane) {
+                d_parent[lane]   -= upd_d[lane];
+                rhs_parent[lane] -= upd_rhs[lane];
+            }
+        }
+
+        // The forward substitution of a row of the interleaved layout whose
+        // lanes have their parents in the same lanes of the parent row.
+        static void row_solve(
+            const solver_value_type* d, const solver_value_type* u, solver_value_type* rhs,
+            const solver_value_type* x_parent)
+        {
+            constexpr auto W = simd_width;
+            solver_value_type xp[W];
+            for (unsigned lane=0; lane<W; ++lane) {
+                xp[lane] = x_parent[lane];
+            }
+            #pragma GCC ivdep
+            for (unsigned lane=0; lane<W; ++lane) {
+                rhs[lane] = (rhs[lane] - u[lane] * xp[lane]) / d[lane];
+            }
+        }
+
+        void assemble_and_solve_interleaved(solver_value_type dt, view x) {
+            constexpr auto W = simd_width;
+            set_dt(dt);
+
+            auto d = d_i.data();
+            auto u = u_i.data();
+            auto rhs = rhs_i.data();
+            auto p = p_i.data();
+            auto row_parent = layout_.row_parent.data();
+
+            for (auto b: util::make_span(0u, layout_.num_blocks())) {
+                auto base = layout_.block_divisions[b];
+                auto end = layout_.block_divisions[b+1];
+                auto nrows = layout_.num_rows(b);
+
+                // assemble, gathering voltage and current from compartments
+                for (auto k: util::make_span(base, end)) {
+                    auto i = cv_i[k];
+
+                    d[k] = diag_i[k];
+
+                    rhs[k] = gi_i[k]*voltage[i] - current[i];
+                }
+
+                // backward sweep: the lanes of a row are in different cells,
+                // so their updates to their parents are independent; when the
+                // parents are in one row, the lane loop is unit stride
+                for (auto row=nrows-1; row>0; --row) {
+                    auto k0 = base+row*W;
+                    auto q0 = row_parent[k0/W];
+                    if (q0!=layout_.npos) {
+                        row_update(d+k0, u+k0, rhs+k0, d+q0, rhs+q0);
+                    }
+                    else {
+                        for (unsigned lane=0; lane<W; ++lane) {
+                            auto k = k0+lane;
+                            auto scale = u[k] / d[k];
+                            d[p[k]]   -= scale * u[k];
+                            rhs[p[k]] -= scale * rhs[k];
+                        }
+                    }
+                }
+                for (unsigned lane=0; lane<W; ++lane) {
+                    rhs[base+lane] /= d[base+lane];
+                }
+
+                // forward sweep
+                for (auto row=1u; row<nrows; ++row) {
+                    auto k0 = base+row*W;
+                    auto q0 = row_parent[k0/W];
+                    if (q0!=layout_.npos) {
+                        row_solve(d+k0, u+k0, rhs+k0, rhs+q0);
+                    }
+                    else {
+                        for (unsigned lane=0; lane<W; ++lane) {
+                            auto k = k0+lane;
+                            rhs[k] = (rhs[k] - u[k] * rhs[p[k]]) / d[k];
+                        }
+                    }
+                }
+
+                // scatter the solution: each compartment is read only in the
+                // assembly of its own block, so x can alias voltage
+                for (auto k: util::make_span(base, end)) {
+                    auto i = layout_.cv[k];
+                    if (i!=layout_.npos) {
+                        x[i] = rhs[k];
+                    }
+                }
             }
         }
     };
@@ -115,11 +534,11 @@ struct backend {
     //
     // mechanism infrastructure
     //
-    using ion = mechanisms::ion<backend>;
+    using ion = mechanisms::ion<basic_backend>;
 
-    using mechanism = mechanisms::mechanism_ptr<backend>;
+    using mechanism = mechanisms::mechanism_ptr<basic_backend>;
 
-    using stimulus = mechanisms::multicore::stimulus<backend>;
+    using stimulus = mechanisms::multicore::stimulus<basic_backend>;
 
     static mechanism make_mechanism(
         const std::string& name,
@@ -139,21 +558,49 @@ struct backend {
     }
 
     static std::string name() {
-        return "cpu";
+        return std::is_same<value_type, double>::value? "cpu": "cpu_f32";
     }
 
-private:
-
     using maker_type = mechanism (*)(view, view, array&&, iarray&&);
-    static std::map<std::string, maker_type> mech_map_;
 
     template <template <typename> class Mech>
     static mechanism maker(view vec_v, view vec_i, array&& weights, iarray&& node_indices) {
-        return mechanisms::make_mechanism<Mech<backend>>
+        return mechanisms::make_mechanism<Mech<basic_backend>>
             (vec_v, vec_i, std::move(weights), std::move(node_indices));
     }
+
+    /// Add a mechanism to the database, e.g. from a mechanism catalogue.
+    /// Replaces a mechanism with the same name.
+    static void add_mechanism(const std::string& name, maker_type m) {
+        mech_map_[name] = m;
+    }
+
+private:
+
+    static std::map<std::string, maker_type> mech_map_;
 };
 
+using backend = basic_backend<double>;
+
+/// Mixed precision backend: single precision state, double precision solve.
+using backend_f32 = basic_backend<float>;
+
+// the mechanism maps of both backends are defined in fvm_multicore.cpp
+template <>
+std::map<std::string, backend::maker_type> backend::mech_map_;
+
+template <>
+std::map<std::string, backend_f32::maker_type> backend_f32::mech_map_;
+
+/// Add the mechanisms in the catalogue at path to the database of each
+/// multicore backend with an entry for it in the catalogue.
+/// Returns the names of the mechanisms.
+std::vector<std::string> load_catalogue(const std::string& path);
+
+/// Load every catalogue found in a colon separated search path.
+/// Returns the names of the mechanisms that were loaded.
+std::vector<std::string> load_catalogues(const std::string& search_path);
+
 } // namespace multicore
 } // namespace mc
 } // namespace nest
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <util/debug.hpp>
+#include <util/span.hpp>
+
+namespace nest {
+namespace mc {
+namespace multicore {
+
+/// Layout of the matrices of a set of cells in which the cells are packed
+/// into blocks of width cells, with the compartments of the cells in a
+/// block interleaved lane by lane:
+///     slot = block_start + row*width + lane
+/// holds compartment row of the cell in lane of the block.
+///
+/// Cells are assigned to blocks in decreasing order of size, and each block
+/// is padded to the size of its largest cell.
+///
+/// When the cells of a row all have their parents in the same row, as they
+/// do in blocks of cells with the same morphology, the parent of each lane
+/// is in the same lane of that row, so that the sweeps over the lanes of the
+/// row are unit stride. Padding slots in such a row take the slot of their
+/// lane in the parent row as parent. Other padding slots, and the lanes of
+/// the last block that have no cell, are their own parent. Padding slots are
+/// not coupled to their parents, so this does not change the solution.
+///
+/// The compartments of each cell must be numbered so that the parent of a
+/// compartment precedes it, as in the parent index of a Hines matrix.
+template <typename Size>
+struct interleaved_layout {
+    using size_type = Size;
+
+    static constexpr size_type npos = size_type(-1);
+
+    /// the number of cells in each block
+    unsigned width = 0;
+
+    /// block_divisions[b] is the first slot of block b
+    std::vector<size_type> block_divisions;
+
+    /// parent[k] is the slot of the parent of slot k
+    std::vector<size_type> parent;
+
+    /// row_parent[k/width] is the first slot of the row that holds the
+    /// parents of all the lanes of the row of slot k, or npos for the first
+    /// row of a block, and for rows with parents in different rows
+    std::vector<size_type> row_parent;
+
+    /// cv[k] is the compartment in slot k, or npos if k is padding
+    std::vector<size_type> cv;
+
+    /// slot[i] is the slot of compartment i
+    std::vector<size_type> slot;
+
+    /// the number of blocks
+    size_type num_blocks() const {
+        return block_divisions.size()-1;
+    }
+
+    /// the number of rows in block b
+    size_type num_rows(size_type b) const {
+        return (block_divisions[b+1]-block_divisions[b])/width;
+    }
+
+    /// the total number of slots, including padding
+    size_type size() const {
+        return parent.size();
+    }
+
+    /// the fraction of slots that hold a compartment, in (0, 1]
+    double efficiency() const {
+        return size()? double(slot.size())/size(): 1.;
+    }
+};
+
+template <typename Size>
+constexpr Size interleaved_layout<Size>::npos;
+
+/// Make the interleaved layout of the matrices of the cells described by
+/// a combined parent index and cell index.
+template <typename Size>
+interleaved_layout<Size> make_interleaved_layout(
+    const std::vector<Size>& parent_index,
+    const std::vector<Size>& cell_index,
+    unsigned width)
+{
+    EXPECTS(width>0);
+    EXPECTS(!cell_index.empty());
+
+    using util::make_span;
+
+    interleaved_layout<Size> layout;
+    layout.width = width;
+
+    auto ncells = cell_index.size()-1;
+    auto cell_size = [&](Size c) { return cell_index[c+1]-cell_index[c]; };
+
+    std::vector<Size> order(ncells);
+    std::iota(order.begin(), order.end(), Size(0));
+    std::stable_sort(order.begin(), order.end(),
+        [&](Size l, Size r) { return cell_size(l)>cell_size(r); });
+
+    layout.slot.resize(parent_index.size());
+    layout.block_divisions.push_back(0);
+    for (std::size_t first=0; first<ncells; first+=width) {
+        Size base = layout.block_divisions.back();
+        Size rows = cell_size(order[first]);
+        Size end = base+rows*width;
+
+        // padding is its own parent
+        layout.parent.resize(end);
+        std::iota(layout.parent.begin()+base, layout.parent.end(), base);
+        layout.cv.resize(end, layout.npos);
+
+        for (auto lane: make_span(0u, width)) {
+            if (first+lane>=ncells) {
+                break;
+            }
+            auto c = order[first+lane];
+            auto cell_first = cell_index[c];
+            for (auto row: make_span(0u, cell_size(c))) {
+                auto i = cell_first+row;
+                auto k = base+row*width+lane;
+                layout.cv[k] = i;
+                layout.slot[i] = k;
+                layout.parent[k] = base+(parent_index[i]-cell_first)*width+lane;
+            }
+        }
+
+        // find the rows with a common parent row, which lane 0 always has,
+        // because it holds the largest cell of the block
+        layout.row_parent.resize(end/width, layout.npos);
+        for (auto row: make_span(1u, rows)) {
+            auto k0 = base+row*width;
+            auto q0 = base+(layout.parent[k0]-base)/width*width;
+            bool uniform = true;
+            for (auto lane: make_span(1u, width)) {
+                auto k = k0+lane;
+                if (layout.cv[k]!=layout.npos && layout.parent[k]!=q0+lane) {
+                    uniform = false;
+                }
+            }
+            if (uniform) {
+                layout.row_parent[k0/width] = q0;
+                for (auto lane: make_span(1u, width)) {
+                    if (layout.cv[k0+lane]==layout.npos) {
+                        layout.parent[k0+lane] = q0+lane;
+                    }
+                }
+            }
+        }
+        layout.block_divisions.push_back(end);
+    }
+
+    return layout;
+}
+
+} // namespace multicore
+} // namespace mc
+} // namespace nest
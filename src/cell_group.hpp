@@ -1,25 +1,49 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <vector>
 
 #include <algorithms.hpp>
 #include <cell.hpp>
 #include <common_types.hpp>
 #include <event_queue.hpp>
+#include <memory_usage.hpp>
 #include <spike.hpp>
 #include <spike_source.hpp>
 #include <util/debug.hpp>
 #include <util/partition.hpp>
 #include <util/range.hpp>
+#include <util/rangeutil.hpp>
 
 #include <profiling/profiler.hpp>
 
 namespace nest {
 namespace mc {
 
+/// Policy for delivering postsynaptic events to the cells in a group.
+enum class event_delivery_mode {
+    /// Truncate the integration step of the whole group so that each event is
+    /// delivered at its exact time.
+    exact,
+    /// Integrate the whole group with the fixed time step, and deliver each
+    /// event at the start of the first step that begins at or after the event
+    /// time (within the minimum step tolerance).
+    step_aligned
+};
+
+/// Options for the construction of a cell group, which are applied to its
+/// lowered cell before the cells are lowered.
+struct cell_group_options {
+    /// Number the compartments of each cell depth first, instead of segment
+    /// by segment.
+    bool depth_first_numbering = false;
+};
+
 template <typename LoweredCell>
 class cell_group {
 public:
@@ -41,7 +65,8 @@ public:
     cell_group() = default;
 
     template <typename Cells>
-    cell_group(cell_gid_type first_gid, const Cells& cells):
+    cell_group(cell_gid_type first_gid, const Cells& cells,
+               const cell_group_options& options = cell_group_options()):
         gid_base_{first_gid}
     {
         // Create lookup structure for probe and target ids.
@@ -56,6 +81,7 @@ public:
         target_handles_.resize(n_targets);
         probe_handles_.resize(n_probes);
 
+        cell_.depth_first_numbering(options.depth_first_numbering);
         cell_.initialize(cells, detector_handles_, target_handles_, probe_handles_);
 
         // Create spike detectors and associate them with globally unique source ids.
@@ -88,8 +114,24 @@ public:
         return 0.1*dt;
     }
 
+    /// The smallest time_type that is not before t, so that the events of
+    /// pop_if_before(time_after(t)) are exactly those before t.
+    static time_type time_after(double t) {
+        time_type r = t;
+        return r<t? std::nextafter(r, std::numeric_limits<time_type>::infinity()): r;
+    }
+
+    /// Integrate to tfinal.
+    /// Steps are taken with exactly dt, unless an event or tfinal truncates
+    /// them, and never end after either. The remainder of a step truncated
+    /// by an event just before tfinal is integrated, even if it is shorter
+    /// than min_step(dt), so that samples and spikes at tfinal are not moved
+    /// to the next interval.
     void advance(time_type tfinal, time_type dt) {
-        while (cell_.time()<tfinal) {
+        // the time of the lowered cell is compared in the precision of tfinal,
+        // because a sum of full steps in double precision can fall short of
+        // the single precision tfinal by round off
+        while (time_type(cell_.time())<tfinal) {
             // take any pending samples
             time_type cell_time = cell_.time();
 
@@ -106,21 +148,40 @@ public:
             }
             PL();
 
-            // look for events in the next time step
-            time_type tstep = cell_.time()+dt;
-            tstep = std::min(tstep, tfinal);
-            auto next = events_.pop_if_before(tstep);
+            // look for events in the next time step; the step times are
+            // computed in the double precision of the lowered cell's time,
+            // so that a full step is exactly dt
+            double tstep = cell_.time()+dt;
+            double tend = std::min(tstep, double(tfinal));
+
+            // with step aligned delivery only events that are due at the start
+            // of the step are considered, so that the step is never truncated.
+            double tdue = tend;
+            if (event_delivery_==event_delivery_mode::step_aligned) {
+                tdue = std::min(tdue, cell_.time()+min_step(dt));
+            }
+            auto next = events_.pop_if_before(time_after(tdue));
 
-            // apply events that are due within the smallest allowed time step.
+            // apply events that are due within the smallest allowed time step,
+            // delivering them to the lowered cell in one batch.
             while (next && (next->time-cell_.time()) < min_step(dt)) {
-                auto handle = get_target_handle(next->target);
-                cell_.deliver_event(handle, next->weight);
-                next = events_.pop_if_before(tstep);
+                staged_events_.push_back({get_target_handle(next->target), next->weight});
+                next = events_.pop_if_before(time_after(tdue));
+            }
+            if (!staged_events_.empty()) {
+                util::sort_by(staged_events_,
+                    [](const deliverable_event& e) { return e.handle; });
+                cell_.deliver_events(staged_events_);
+                staged_events_.clear();
             }
 
-            // integrate cell state
-            time_type tnext = next ? next->time: tstep;
-            cell_.advance(tnext - cell_.time());
+            // integrate cell state: a step that is not truncated by an event
+            // or by tfinal is dt itself, so that the lowered cell does not see
+            // the round off of the step times as a change of dt; truncated
+            // steps end exactly at the event or at tfinal
+            double tnext = next ? double(next->time): tend;
+            double step = tnext==tstep? double(dt): tnext-cell_.time();
+            cell_.advance(step);
 
             if (!cell_.is_physical_solution()) {
                 std::cerr << "warning: solution out of bounds for cell "
@@ -145,11 +206,18 @@ public:
 
     }
 
+    /// Set the policy used to deliver postsynaptic events during advance().
+    void set_event_delivery(event_delivery_mode mode) {
+        event_delivery_ = mode;
+    }
+
+    event_delivery_mode event_delivery() const {
+        return event_delivery_;
+    }
+
     template <typename R>
     void enqueue_events(const R& events) {
-        for (auto e : events) {
-            events_.push(e);
-        }
+        events_.push(std::begin(events), std::end(events));
     }
 
     const std::vector<spike<source_id_type, time_type>>&
@@ -195,6 +263,30 @@ public:
         return cell_.probe(get_probe_handle(probe_id));
     }
 
+    /// the number of integration steps since construction or reset()
+    std::size_t num_steps() const {
+        return cell_.num_steps();
+    }
+
+    /// the number of integration steps with a different dt to the step
+    /// before, i.e. the steps after and including each truncated step
+    std::size_t num_dt_changes() const {
+        return cell_.num_dt_changes();
+    }
+
+    /// the memory used by the lowered cell, the event queues, the samplers
+    /// and the handles into the lowered cell
+    mc::memory_usage memory_usage() const {
+        auto m = cell_.memory_usage();
+        m.state += vector_memory(spike_sources_) + vector_memory(spikes_)
+            + vector_memory(detector_handles_) + vector_memory(target_handles_)
+            + vector_memory(probe_handles_) + vector_memory(probe_handle_divisions_);
+        m.event_queues += events_.memory() + sample_events_.memory()
+            + vector_memory(staged_events_);
+        m.samplers += vector_memory(samplers_) + vector_memory(sampler_start_times_);
+        return m;
+    }
+
 private:
     /// gid of first cell in group
     cell_gid_type gid_base_;
@@ -211,6 +303,13 @@ private:
     /// pending events to be delivered
     event_queue<postsynaptic_spike_event<time_type>> events_;
 
+    /// events that are due, staged for batched delivery to the lowered cell
+    using deliverable_event = typename lowered_cell_type::deliverable_event;
+    std::vector<deliverable_event> staged_events_;
+
+    /// how events are scheduled relative to the integration steps
+    event_delivery_mode event_delivery_ = event_delivery_mode::exact;
+
     /// pending samples to be taken
     event_queue<sample_event<time_type>> sample_events_;
     std::vector<time_type> sampler_start_times_;
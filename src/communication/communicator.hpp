@@ -2,23 +2,53 @@
 
 #include <algorithm>
 #include <iostream>
+#include <numeric>
 #include <vector>
 #include <random>
 #include <functional>
+#include <type_traits>
+#include <utility>
 
 #include <algorithms.hpp>
 #include <connection.hpp>
 #include <communication/gathered_vector.hpp>
 #include <event_queue.hpp>
+#include <memory_usage.hpp>
 #include <spike.hpp>
+#include <threading/threading.hpp>
 #include <util/debug.hpp>
 #include <util/double_buffer.hpp>
 #include <util/partition.hpp>
+#include <util/span.hpp>
 
 namespace nest {
 namespace mc {
 namespace communication {
 
+namespace impl {
+    // Test if a communication policy sends spikes only to the domains that
+    // subscribe to their sources, by providing a subscribe method.
+    template <typename Policy, typename = void>
+    struct has_subscribe: std::false_type {};
+
+    template <typename Policy>
+    struct has_subscribe<Policy, decltype(
+        std::declval<Policy&>().subscribe(
+            std::declval<const std::vector<cell_gid_type>&>(),
+            std::declval<std::pair<cell_gid_type, cell_gid_type>>()),
+        void())>: std::true_type {};
+
+    // Test if a communication policy encodes spike times with a time quantum,
+    // by providing a set_time_quantum method.
+    template <typename Policy, typename = void>
+    struct has_time_quantum: std::false_type {};
+
+    template <typename Policy>
+    struct has_time_quantum<Policy, decltype(
+        std::declval<Policy&>().set_time_quantum(std::declval<double>()),
+        void())>: std::true_type {};
+}
+
 // When the communicator is constructed the number of target groups and targets
 // is specified, along with a mapping between local cell id and local
 // target id.
@@ -72,6 +102,32 @@ public:
         if (!std::is_sorted(connections_.begin(), connections_.end())) {
             threading::sort(connections_);
         }
+
+        // Build a dense table over the range of source gids, where the
+        // connections from source gid g are in the range
+        //     [source_divisions_[g-source_gid_base_], source_divisions_[g-source_gid_base_+1])
+        // of the sorted connections.
+        source_divisions_.clear();
+        source_gid_base_ = 0;
+        if (!connections_.empty()) {
+            source_gid_base_ = connections_.front().source().gid;
+            auto num_gids = connections_.back().source().gid - source_gid_base_ + 1;
+
+            source_divisions_.assign(num_gids+1, 0);
+            for (const auto& con: connections_) {
+                ++source_divisions_[con.source().gid-source_gid_base_+1];
+            }
+            std::partial_sum(
+                source_divisions_.begin(), source_divisions_.end(), source_divisions_.begin());
+        }
+
+        // Cache the local cell group index of the target of each connection.
+        connection_group_index_.resize(connections_.size());
+        for (auto i: util::make_span(0, connections_.size())) {
+            connection_group_index_[i] = cell_group_index(connections_[i].destination().gid);
+        }
+
+        subscribe(impl::has_subscribe<communication_policy_type>());
     }
 
     /// the minimum delay of all connections in the global network.
@@ -88,10 +144,14 @@ public:
     ///
     /// Takes as input the list of local_spikes that were generated on the calling domain.
     /// Returns the full global set of vectors, along with meta data about their partition
+    ///
+    /// If the communication policy sends spikes only to the domains that
+    /// subscribe to their source, only the spikes with targets on the calling
+    /// domain are returned.
     gathered_vector<spike_type> exchange(const std::vector<spike_type>& local_spikes) {
         // global all-to-all to gather a local copy of the global spike list on each node.
         auto global_spikes = communication_policy_.gather_spikes( local_spikes );
-        num_spikes_ += global_spikes.size();
+        num_spikes_ += count_spikes(global_spikes, local_spikes, impl::has_subscribe<communication_policy_type>());
         return global_spikes;
     }
 
@@ -103,21 +163,71 @@ public:
     /// events in each queue are all events that must be delivered to targets in that cell
     /// group as a result of the global spike exchange.
     std::vector<event_queue> make_event_queues(const gathered_vector<spike_type>& global_spikes) {
-        auto queues = std::vector<event_queue>(num_groups_local());
-        for (auto spike : global_spikes.values()) {
-            // search for targets
-            auto targets = std::equal_range(connections_.begin(), connections_.end(), spike.source);
+        const auto& spikes = global_spikes.values();
+        auto num_groups = num_groups_local();
 
-            // generate an event for each target
-            for (auto it=targets.first; it!=targets.second; ++it) {
-                auto gidx = cell_group_index(it->destination().gid);
-                queues[gidx].push_back(it->make_event(spike));
-            }
+        // Split the spikes into contiguous blocks, one per thread, unless
+        // there are too few spikes to make it worth the overhead.
+        auto num_blocks = std::max(1, std::min<int>(
+            threading::num_threads(),
+            spikes.size()/min_spikes_per_block));
+
+        if (num_blocks==1) {
+            auto queues = std::vector<event_queue>(num_groups);
+            append_events(spikes.begin(), spikes.end(), queues);
+            return queues;
         }
 
+        // Generate the events for each block of spikes in thread-private
+        // per-group buckets.
+        auto block_size = (spikes.size()+num_blocks-1)/num_blocks;
+        auto block_queues =
+            std::vector<std::vector<event_queue>>(num_blocks, std::vector<event_queue>(num_groups));
+        threading::parallel_for::apply(0, num_blocks,
+            [&](int b) {
+                auto first = std::min(spikes.size(), b*block_size);
+                auto last = std::min(spikes.size(), first+block_size);
+                append_events(spikes.begin()+first, spikes.begin()+last, block_queues[b]);
+            });
+
+        // Concatenate the buckets of each group in block order, so that the
+        // events are in the same order as if generated serially.
+        auto queues = std::vector<event_queue>(num_groups);
+        threading::parallel_for::apply(0, num_groups,
+            [&](int g) {
+                std::size_t n = 0;
+                for (const auto& bq: block_queues) {
+                    n += bq[g].size();
+                }
+                queues[g].reserve(n);
+                for (const auto& bq: block_queues) {
+                    queues[g].insert(queues[g].end(), bq[g].begin(), bq[g].end());
+                }
+            });
+
         return queues;
     }
 
+    /// Returns the range of indexes into connections() of the connections
+    /// with source id `source`.
+    /// Only valid after construct() has been called.
+    std::pair<std::size_t, std::size_t> connection_range(cell_member_type source) const {
+        if (source.gid<source_gid_base_ ||
+            source.gid-source_gid_base_+1>=source_divisions_.size())
+        {
+            return {0u, 0u};
+        }
+
+        auto first = source_divisions_[source.gid-source_gid_base_];
+        auto last = source_divisions_[source.gid-source_gid_base_+1];
+
+        // Connections from the same cell are sorted by source index, and most
+        // cells have only one source, so this search is over very few items.
+        auto b = connections_.begin();
+        auto targets = std::equal_range(b+first, b+last, source);
+        return {targets.first-b, targets.second-b};
+    }
+
     /// Returns the total number of global spikes over the duration of the simulation
     uint64_t num_spikes() const { return num_spikes_; }
 
@@ -125,15 +235,90 @@ public:
         return connections_;
     }
 
-    communication_policy_type communication_policy() const {
+    /// the bytes allocated for the connections and their indexes
+    std::size_t memory() const {
+        return vector_memory(connections_) + vector_memory(connection_group_index_)
+            + vector_memory(source_divisions_);
+    }
+
+    const communication_policy_type& communication_policy() const {
         return communication_policy_;
     }
 
+    /// Exchange spike times quantized to multiples of quantum, for policies
+    /// that encode spike times (see packed_global_policy). The quantum should
+    /// be no larger than the time step. Returns false if the policy exchanges
+    /// the exact spike times.
+    bool set_spike_time_quantum(double quantum) {
+        return set_spike_time_quantum(quantum, impl::has_time_quantum<communication_policy_type>());
+    }
+
     void reset() {
         num_spikes_ = 0;
     }
 
 private:
+    /// the minimum number of spikes for which event generation is split over
+    /// a thread
+    static constexpr std::size_t min_spikes_per_block = 1000;
+
+    /// generate the events for the spikes in [first, last), appending them
+    /// to the per-group queues
+    template <typename Iter>
+    void append_events(Iter first, Iter last, std::vector<event_queue>& queues) {
+        for (; first!=last; ++first) {
+            auto spike = *first;
+
+            // look up targets
+            auto targets = connection_range(spike.source);
+
+            // generate an event for each target
+            for (auto i: util::make_span(targets)) {
+                auto gidx = connection_group_index_[i];
+                queues[gidx].push_back(connections_[i].make_event(spike));
+            }
+        }
+    }
+
+    /// subscribe to the sources of the local connections, for policies that
+    /// support it
+    void subscribe(std::true_type) {
+        std::vector<cell_gid_type> sources;
+        for (const auto& con: connections_) {
+            if (sources.empty() || sources.back()!=con.source().gid) {
+                sources.push_back(con.source().gid);
+            }
+        }
+        communication_policy_.subscribe(sources, cell_gid_partition_.bounds());
+    }
+
+    void subscribe(std::false_type) {}
+
+    bool set_spike_time_quantum(double quantum, std::true_type) {
+        communication_policy_.set_time_quantum(quantum);
+        return true;
+    }
+
+    bool set_spike_time_quantum(double, std::false_type) {
+        return false;
+    }
+
+    /// the number of spikes in an exchange: all spikes are gathered on
+    /// every domain, unless the policy has subscriptions
+    std::size_t count_spikes(
+        const gathered_vector<spike_type>& global_spikes,
+        const std::vector<spike_type>&, std::false_type)
+    {
+        return global_spikes.size();
+    }
+
+    std::size_t count_spikes(
+        const gathered_vector<spike_type>&,
+        const std::vector<spike_type>& local_spikes, std::true_type)
+    {
+        return communication_policy_.sum(local_spikes.size());
+    }
+
     std::size_t cell_group_index(cell_gid_type cell_gid) const {
         EXPECTS(is_local_cell(cell_gid));
         return cell_gid_partition_.index(cell_gid);
@@ -141,6 +326,13 @@ private:
 
     std::vector<connection_type> connections_;
 
+    /// local cell group index of the target of each connection
+    std::vector<cell_local_size_type> connection_group_index_;
+
+    /// partition of connections_ by source gid, offset by source_gid_base_
+    std::vector<std::size_t> source_divisions_;
+    cell_gid_type source_gid_base_ = 0;
+
     communication_policy_type communication_policy_;
 
     uint64_t num_spikes_ = 0u;
@@ -1,19 +1,33 @@
 #pragma once
 
-#ifdef WITH_MPI
+#if defined(WITH_SPARSE_EXCHANGE)
+    #include "communication/mpi_sparse_global_policy.hpp"
+#elif defined(WITH_MPI)
     #include "communication/mpi_global_policy.hpp"
 #else
     #include "communication/serial_global_policy.hpp"
 #endif
 
+#ifdef WITH_PACKED_SPIKES
+    #include "communication/packed_global_policy.hpp"
+#endif
+
 namespace nest {
 namespace mc {
 namespace communication {
 
-#ifdef WITH_MPI
-using global_policy = nest::mc::communication::mpi_global_policy;
+#if defined(WITH_SPARSE_EXCHANGE)
+using base_global_policy = nest::mc::communication::mpi_sparse_global_policy;
+#elif defined(WITH_MPI)
+using base_global_policy = nest::mc::communication::mpi_global_policy;
+#else
+using base_global_policy = nest::mc::communication::serial_global_policy;
+#endif
+
+#ifdef WITH_PACKED_SPIKES
+using global_policy = packed_global_policy<base_global_policy>;
 #else
-using global_policy = nest::mc::communication::serial_global_policy;
+using global_policy = base_global_policy;
 #endif
 
 template <typename Policy>
@@ -160,6 +160,56 @@ namespace mpi {
         );
     }
 
+    /// Personalized all to all exchange of a distributed vector.
+    /// The values in [send_divisions[i], send_divisions[i+1]) are sent to
+    /// rank i.
+    /// Returns the received values, partitioned by the rank that sent them.
+    template <typename T>
+    gathered_vector<T> all_to_all_with_partition(
+        const std::vector<T>& values, const std::vector<int>& send_divisions)
+    {
+        using gathered_type = gathered_vector<T>;
+        using count_type = typename gathered_vector<T>::count_type;
+        using traits = mpi_traits<T>;
+
+        EXPECTS(send_divisions.size()==std::size_t(size()+1));
+        EXPECTS(std::size_t(send_divisions.back())==values.size());
+
+        std::vector<int> send_counts(size());
+        std::vector<int> send_displs(size());
+        for (int i=0; i<size(); ++i) {
+            send_counts[i] = (send_divisions[i+1]-send_divisions[i])*traits::count();
+            send_displs[i] = send_divisions[i]*traits::count();
+        }
+
+        // exchange the number of values to be sent between each pair of ranks
+        std::vector<int> recv_counts(size());
+        MPI_Alltoall(
+            send_counts.data(), 1, MPI_INT,
+            recv_counts.data(), 1, MPI_INT,
+            MPI_COMM_WORLD);
+        auto recv_displs = algorithms::make_index(recv_counts);
+
+        std::vector<T> buffer(recv_displs.back()/traits::count());
+
+        MPI_Alltoallv(
+            // send buffer
+            values.data(), send_counts.data(), send_displs.data(), traits::mpi_type(),
+            // receive buffer
+            buffer.data(), recv_counts.data(), recv_displs.data(), traits::mpi_type(),
+            MPI_COMM_WORLD
+        );
+
+        for (auto& d : recv_displs) {
+            d /= traits::count();
+        }
+
+        return gathered_type(
+            std::move(buffer),
+            std::vector<count_type>(recv_displs.begin(), recv_displs.end())
+        );
+    }
+
     template <typename T>
     T reduce(T value, MPI_Op op, int root) {
         using traits = mpi_traits<T>;
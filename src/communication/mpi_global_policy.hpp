@@ -25,6 +25,16 @@ struct mpi_global_policy {
         return mpi::gather_all_with_partition(local_spikes);
     }
 
+    /// Gather the blocks of bytes that encode(local_spikes, buf) appends to
+    /// buf on each rank, partitioned by rank.
+    template <typename Spike, typename Encode>
+    static gathered_vector<char>
+    gather_encoded(const std::vector<Spike>& local_spikes, Encode encode) {
+        std::vector<char> buf;
+        encode(local_spikes, buf);
+        return mpi::gather_all_with_partition(buf);
+    }
+
     static int id() { return mpi::rank(); }
 
     static int size() { return mpi::size(); }
@@ -44,6 +54,12 @@ struct mpi_global_policy {
         return nest::mc::mpi::reduce(value, MPI_SUM);
     }
 
+    /// The values of every rank, concatenated in order of rank.
+    template <typename T>
+    static std::vector<T> gather_all(const std::vector<T>& values) {
+        return mpi::gather_all(values);
+    }
+
     template <
         typename T,
         typename = typename std::enable_if<std::is_integral<T>::value>
@@ -0,0 +1,217 @@
+#pragma once
+
+#ifndef WITH_MPI
+#error "mpi_sparse_global_policy.hpp should only be compiled in a WITH_MPI build"
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <algorithms.hpp>
+#include <common_types.hpp>
+#include <communication/gathered_vector.hpp>
+#include <communication/mpi.hpp>
+#include <communication/mpi_global_policy.hpp>
+#include <spike.hpp>
+#include <util/debug.hpp>
+#include <util/span.hpp>
+
+namespace nest {
+namespace mc {
+namespace communication {
+
+/// Global policy that sends each spike only to the ranks with connections
+/// from its source, instead of gathering all spikes on every rank.
+///
+/// The ranks that subscribe to each source are set up by the collective
+/// subscribe() call, which the communicator makes in construct().
+/// Until then, or for spikes from sources that are not on the calling rank,
+/// spikes are sent to every rank.
+///
+/// Because a rank only receives the spikes that it subscribed to, the
+/// spikes returned by gather_spikes() are not the global set of spikes.
+struct mpi_sparse_global_policy: public mpi_global_policy {
+    using id_type = cell_gid_type;
+
+    /// Register the source gids with connections to targets on the calling
+    /// rank, which has the cells with gids in [local_cells.first, local_cells.second).
+    /// Must be called on every rank.
+    void subscribe(const std::vector<id_type>& sources, std::pair<id_type, id_type> local_cells) {
+        // gather the gid ranges of every rank, and sort the non-empty ranges
+        // so that the rank with a gid can be found with a binary search
+        auto ranges = mpi::gather_all(local_cells);
+        auto nranks = size();
+        std::vector<int> rank_order;
+        for (auto rank: util::make_span(0, nranks)) {
+            if (ranges[rank].first<ranges[rank].second) {
+                rank_order.push_back(rank);
+            }
+        }
+        std::sort(rank_order.begin(), rank_order.end(),
+            [&](int l, int r) { return ranges[l].first<ranges[r].first; });
+
+        auto owner = [&](id_type gid) {
+            auto it = std::upper_bound(rank_order.begin(), rank_order.end(), gid,
+                [&](id_type g, int rank) { return g<ranges[rank].first; });
+            if (it==rank_order.begin()) {
+                return -1;
+            }
+            auto rank = *(it-1);
+            return gid<ranges[rank].second? rank: -1;
+        };
+
+        // send each subscribed source to the rank with the source cell
+        std::vector<int> send_counts(nranks, 0);
+        std::vector<int> owners;
+        owners.reserve(sources.size());
+        for (auto gid: sources) {
+            owners.push_back(owner(gid));
+            if (owners.back()>=0) {
+                ++send_counts[owners.back()];
+            }
+        }
+
+        auto send_divisions = algorithms::make_index(send_counts);
+        std::vector<id_type> send_gids(send_divisions.back());
+        auto fill = send_divisions;
+        for (auto i: util::make_span(0, sources.size())) {
+            if (owners[i]>=0) {
+                send_gids[fill[owners[i]]++] = sources[i];
+            }
+        }
+
+        auto subscriptions = mpi::all_to_all_with_partition(send_gids, send_divisions);
+
+        // build the list of subscribing ranks of each local cell
+        gid_base_ = local_cells.first;
+        auto nlocal = local_cells.second-local_cells.first;
+        std::vector<unsigned> counts(nlocal, 0);
+        for (auto gid: subscriptions.values()) {
+            ++counts[gid-gid_base_];
+        }
+        subscriber_divisions_ = algorithms::make_index(counts);
+        subscribers_.resize(subscriber_divisions_.back());
+
+        auto pos = subscriber_divisions_;
+        const auto& part = subscriptions.partition();
+        for (auto rank: util::make_span(0, nranks)) {
+            for (auto i: util::make_span(part[rank], part[rank+1])) {
+                subscribers_[pos[subscriptions.values()[i]-gid_base_]++] = rank;
+            }
+        }
+
+        subscribed_ = true;
+    }
+
+    /// Send each local spike to the ranks that subscribe to its source.
+    /// Returns the spikes received by the calling rank, partitioned by the
+    /// rank of their source.
+    template <typename Spike>
+    gathered_vector<Spike> gather_spikes(const std::vector<Spike>& local_spikes) {
+        if (!subscribed_) {
+            auto spikes = mpi::gather_all_with_partition(local_spikes);
+            bytes_sent_ += sizeof(Spike)*local_spikes.size()*(size()-1);
+            bytes_received_ += sizeof(Spike)*(spikes.size()-local_spikes.size());
+            return spikes;
+        }
+
+        std::vector<int> send_counts(size(), 0);
+        for (const auto& s: local_spikes) {
+            for_each_subscriber(s.source.gid, [&](int rank) { ++send_counts[rank]; });
+        }
+
+        auto send_divisions = algorithms::make_index(send_counts);
+        std::vector<Spike> send_spikes(send_divisions.back());
+        auto fill = send_divisions;
+        for (const auto& s: local_spikes) {
+            for_each_subscriber(s.source.gid, [&](int rank) { send_spikes[fill[rank]++] = s; });
+        }
+
+        auto spikes = mpi::all_to_all_with_partition(send_spikes, send_divisions);
+
+        auto self = id();
+        bytes_sent_ += sizeof(Spike)*(send_spikes.size()-send_counts[self]);
+        bytes_received_ += sizeof(Spike)*(spikes.size()-spikes.count(self));
+        return spikes;
+    }
+
+    /// Send to each rank the block of bytes that encode(spikes, buf) appends
+    /// to buf for the local spikes with sources that the rank subscribes to.
+    /// No block is sent to the ranks that subscribe to none of the spikes.
+    /// Returns the blocks received by the calling rank, partitioned by the
+    /// rank of their source.
+    template <typename Spike, typename Encode>
+    gathered_vector<char> gather_encoded(const std::vector<Spike>& local_spikes, Encode encode) {
+        std::vector<char> buf;
+        if (!subscribed_) {
+            encode(local_spikes, buf);
+            auto blocks = mpi::gather_all_with_partition(buf);
+            bytes_sent_ += buf.size()*(size()-1);
+            bytes_received_ += blocks.values().size()-buf.size();
+            return blocks;
+        }
+
+        std::vector<std::vector<Spike>> send_spikes(size());
+        for (const auto& s: local_spikes) {
+            for_each_subscriber(s.source.gid, [&](int rank) { send_spikes[rank].push_back(s); });
+        }
+
+        std::vector<int> send_divisions = {0};
+        for (const auto& spikes: send_spikes) {
+            if (!spikes.empty()) {
+                encode(spikes, buf);
+            }
+            send_divisions.push_back(buf.size());
+        }
+
+        auto blocks = mpi::all_to_all_with_partition(buf, send_divisions);
+
+        auto self = id();
+        auto self_bytes = send_divisions[self+1]-send_divisions[self];
+        bytes_sent_ += buf.size()-self_bytes;
+        bytes_received_ += blocks.values().size()-self_bytes;
+        return blocks;
+    }
+
+    /// The number of bytes of spikes sent to other ranks by gather_spikes.
+    std::uint64_t bytes_sent() const { return bytes_sent_; }
+
+    /// The number of bytes of spikes received from other ranks by gather_spikes.
+    std::uint64_t bytes_received() const { return bytes_received_; }
+
+    static const char* name() { return "MPI sparse"; }
+
+private:
+    /// call f(rank) for each rank that subscribes to the source cell gid
+    template <typename F>
+    void for_each_subscriber(id_type gid, F f) const {
+        auto i = gid-gid_base_;
+        if (gid<gid_base_ || i+1>=subscriber_divisions_.size()) {
+            // not a local source: send to all ranks
+            for (auto rank: util::make_span(0, size())) {
+                f(rank);
+            }
+            return;
+        }
+        for (auto j: util::make_span(subscriber_divisions_[i], subscriber_divisions_[i+1])) {
+            f(subscribers_[j]);
+        }
+    }
+
+    bool subscribed_ = false;
+
+    // subscribers_[subscriber_divisions_[i]...] are the ranks that subscribe
+    // to the local cell with gid gid_base_+i
+    id_type gid_base_ = 0;
+    std::vector<unsigned> subscriber_divisions_;
+    std::vector<int> subscribers_;
+
+    std::uint64_t bytes_sent_ = 0;
+    std::uint64_t bytes_received_ = 0;
+};
+
+} // namespace communication
+} // namespace mc
+} // namespace nest
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <communication/gathered_vector.hpp>
+#include <communication/spike_codec.hpp>
+
+namespace nest {
+namespace mc {
+namespace communication {
+
+/// Wraps a global policy to exchange spikes in the compact encoding of
+/// spike_codec, instead of as an array of spike structs.
+///
+/// The local spikes are encoded in blocks, which are exchanged as bytes with
+/// the gather_encoded method of the wrapped policy: one block that is
+/// gathered on every domain, or with a sparse policy, one block for each
+/// domain that subscribes to the sources of the spikes.
+///
+/// Spike times are exchanged without loss, unless a time quantum is set
+/// with set_time_quantum(), which the communicator forwards from
+/// communicator::set_spike_time_quantum().
+template <typename Policy>
+struct packed_global_policy: public Policy {
+    using base_policy = Policy;
+
+    template <typename Spike>
+    gathered_vector<Spike> gather_spikes(const std::vector<Spike>& local_spikes) {
+        using time_type = typename Spike::time_type;
+        using count_type = typename gathered_vector<Spike>::count_type;
+
+        spike_codec<time_type> codec(time_quantum_);
+
+        auto blocks = base_policy::gather_encoded(local_spikes,
+            [&](const std::vector<Spike>& spikes, std::vector<char>& buf) {
+                auto n = buf.size();
+                codec.encode(spikes, buf);
+                bytes_sent_ += buf.size()-n;
+            });
+
+        // decode the blocks from each domain, keeping the partition by domain
+        std::vector<Spike> spikes;
+        std::vector<count_type> partition = {0};
+        const auto& part = blocks.partition();
+        const char* data = blocks.values().data();
+        for (std::size_t i=0; i+1<part.size(); ++i) {
+            const char* b = data+part[i];
+            const char* e = data+part[i+1];
+            while (b<e) {
+                b = codec.decode(b, e, spikes);
+            }
+            partition.push_back(spikes.size());
+        }
+
+        return gathered_vector<Spike>(std::move(spikes), std::move(partition));
+    }
+
+    /// Quantize spike times to multiples of quantum relative to the earliest
+    /// spike of each block in each exchange. A quantum of zero is lossless.
+    void set_time_quantum(double quantum) {
+        time_quantum_ = quantum;
+    }
+
+    double time_quantum() const {
+        return time_quantum_;
+    }
+
+    /// The total size in bytes of the blocks of local spikes encoded by
+    /// gather_spikes.
+    std::uint64_t bytes_sent() const {
+        return bytes_sent_;
+    }
+
+    static const char* name() {
+        static const std::string n = std::string(base_policy::name())+" packed";
+        return n.c_str();
+    }
+
+private:
+    double time_quantum_ = 0;
+    std::uint64_t bytes_sent_ = 0;
+};
+
+} // namespace communication
+} // namespace mc
+} // namespace nest
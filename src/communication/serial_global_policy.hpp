@@ -22,6 +22,14 @@ struct serial_global_policy {
         );
     }
 
+    template <typename Spike, typename Encode>
+    static gathered_vector<char>
+    gather_encoded(const std::vector<Spike>& local_spikes, Encode encode) {
+        std::vector<char> buf;
+        encode(local_spikes, buf);
+        return gather_spikes(buf);
+    }
+
     static int id() {
         return 0;
     }
@@ -45,6 +53,11 @@ struct serial_global_policy {
         return value;
     }
 
+    template <typename T>
+    static std::vector<T> gather_all(const std::vector<T>& values) {
+        return values;
+    }
+
     template <
         typename T,
         typename = typename std::enable_if<std::is_integral<T>::value>
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <common_types.hpp>
+#include <spike.hpp>
+#include <util/debug.hpp>
+
+namespace nest {
+namespace mc {
+namespace communication {
+
+/// Compact encoding of blocks of spikes for exchange between domains.
+///
+/// The spikes in a block are sorted by source, and stored as:
+///     count                       varint
+///     first source gid            varint  (if count>0)
+///     base time                   Time    (if count>0 and the quantum is
+///                                         not zero, minimum spike time)
+/// followed by, for each spike:
+///     gid - previous gid          varint
+///     source index                varint
+///     time - base time            varint number of quanta, or the time
+///                                 as Time if the quantum is zero
+///
+/// Varints are little endian base 128, with 7 bits per byte.
+/// With a zero quantum the encoding is lossless, otherwise decoded spike
+/// times are within half a quantum of the original times.
+template <typename Time>
+class spike_codec {
+public:
+    using time_type = Time;
+    using spike_type = spike<cell_member_type, time_type>;
+
+    explicit spike_codec(time_type quantum = 0):
+        quantum_(quantum)
+    {
+        EXPECTS(quantum>=0);
+    }
+
+    time_type quantum() const {
+        return quantum_;
+    }
+
+    /// Append the encoded block of spikes to buf.
+    void encode(std::vector<spike_type> spikes, std::vector<char>& buf) const {
+        std::sort(spikes.begin(), spikes.end(),
+            [](const spike_type& l, const spike_type& r) { return l.source<r.source; });
+
+        put_varint(spikes.size(), buf);
+        if (spikes.empty()) {
+            return;
+        }
+
+        auto gid = spikes.front().source.gid;
+        put_varint(gid, buf);
+
+        time_type base_time = 0;
+        if (quantum_>0) {
+            base_time = std::min_element(spikes.begin(), spikes.end(),
+                [](const spike_type& l, const spike_type& r) { return l.time<r.time; })->time;
+            put_raw(base_time, buf);
+        }
+
+        for (const auto& s: spikes) {
+            put_varint(s.source.gid-gid, buf);
+            put_varint(s.source.index, buf);
+            if (quantum_>0) {
+                put_varint(std::uint64_t(std::round((s.time-base_time)/quantum_)), buf);
+            }
+            else {
+                put_raw(s.time, buf);
+            }
+            gid = s.source.gid;
+        }
+    }
+
+    /// Decode the block of spikes that starts at b, appending the spikes to out.
+    /// Returns a pointer to the end of the block.
+    const char* decode(const char* b, const char* e, std::vector<spike_type>& out) const {
+        auto count = get_varint(b, e);
+        if (count==0) {
+            return b;
+        }
+
+        cell_gid_type gid = get_varint(b, e);
+        auto base_time = quantum_>0? get_raw<time_type>(b, e): time_type(0);
+
+        out.reserve(out.size()+count);
+        for (std::uint64_t i=0; i<count; ++i) {
+            gid += get_varint(b, e);
+            cell_lid_type index = get_varint(b, e);
+            time_type t = quantum_>0?
+                base_time + get_varint(b, e)*quantum_:
+                get_raw<time_type>(b, e);
+            out.push_back({{gid, index}, t});
+        }
+        return b;
+    }
+
+private:
+    time_type quantum_;
+
+    static void put_varint(std::uint64_t v, std::vector<char>& buf) {
+        while (v>=0x80) {
+            buf.push_back(char(v|0x80));
+            v >>= 7;
+        }
+        buf.push_back(char(v));
+    }
+
+    static std::uint64_t get_varint(const char*& b, const char* e) {
+        std::uint64_t v = 0;
+        for (unsigned shift=0; ; shift+=7) {
+            EXPECTS(b<e);
+            auto byte = std::uint8_t(*b++);
+            v |= std::uint64_t(byte&0x7f)<<shift;
+            if (!(byte&0x80)) {
+                return v;
+            }
+        }
+    }
+
+    template <typename T>
+    static void put_raw(T v, std::vector<char>& buf) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &v, sizeof(T));
+        buf.insert(buf.end(), bytes, bytes+sizeof(T));
+    }
+
+    template <typename T>
+    static T get_raw(const char*& b, const char* e) {
+        EXPECTS(b+sizeof(T)<=e);
+        T v;
+        std::memcpy(&v, b, sizeof(T));
+        b += sizeof(T);
+        return v;
+    }
+};
+
+} // namespace communication
+} // namespace mc
+} // namespace nest
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <iterator>
 #include <ostream>
-#include <queue>
+#include <vector>
 
 #include "common_types.hpp"
 #include "util/optional.hpp"
@@ -40,6 +42,15 @@ struct sample_event {
 
 /* Event objects must have a method event_time() which returns a value
  * from a type with a total ordering with respect to <, >, etc.
+ *
+ * Events are stored in a flat buffer that is sorted by event time, and
+ * popped by advancing a cursor through the buffer. Pushed events are staged,
+ * and merged into the sorted buffer in one sort and merge the first time a
+ * staged event could be popped. This suits the typical usage patterns:
+ * all of the events for an integration epoch are pushed in bulk after spike
+ * exchange, then popped one integration step at a time; and the samplers
+ * of a cell group are popped when due, then pushed again with a later time,
+ * so that they are merged once per step, not once per sampler.
  */
 
 template <typename Event>
@@ -54,49 +65,83 @@ public :
     // push stuff
     template <typename Iter>
     void push(Iter b, Iter e) {
-         for (; b!=e; ++b) {
-             queue_.push(*b);
-         }
+        for (; b!=e; ++b) {
+            push(*b);
+        }
     }
 
     // push thing
     void push(const value_type& e) {
-         queue_.push(e);
+        if (staged_.empty() || e.when()<staged_min_) {
+            staged_min_ = e.when();
+        }
+        staged_.push_back(e);
     }
 
     std::size_t size() const {
-        return queue_.size();
+        return events_.size()-head_ + staged_.size();
+    }
+
+    // the bytes allocated for events, including spare capacity
+    std::size_t memory() const {
+        return (events_.capacity() + staged_.capacity() + merged_.capacity())*sizeof(value_type);
     }
 
     // pop until
     util::optional<value_type> pop_if_before(time_type t_until) {
-         if (!queue_.empty() && queue_.top().when() < t_until) {
-             auto ev = queue_.top();
-             queue_.pop();
-             return ev;
-         }
-         else {
-             return util::nothing;
-         }
+        if (!staged_.empty() && staged_min_<t_until) {
+            merge_staged();
+        }
+
+        if (head_<events_.size() && events_[head_].when() < t_until) {
+            return events_[head_++];
+        }
+        else {
+            return util::nothing;
+        }
     }
 
     // clear everything
     void clear() {
-        queue_ = decltype(queue_){};
+        events_.clear();
+        staged_.clear();
+        head_ = 0;
     }
 
 private:
-    struct event_greater {
+    struct event_less {
         bool operator()(const Event& a, const Event& b) {
-            return a.when() > b.when();
+            return a.when() < b.when();
         }
     };
 
-    std::priority_queue<
-        Event,
-        std::vector<Event>,
-        event_greater
-    > queue_;
+    // Sort the staged events, and merge them with the events that have not
+    // yet been popped, into the storage of the last merge.
+    void merge_staged() {
+        std::sort(staged_.begin(), staged_.end(), event_less{});
+
+        merged_.clear();
+        merged_.reserve(events_.size()-head_+staged_.size());
+        std::merge(
+            events_.begin()+head_, events_.end(), staged_.begin(), staged_.end(),
+            std::back_inserter(merged_), event_less{});
+
+        std::swap(events_, merged_);
+        head_ = 0;
+        staged_.clear();
+    }
+
+    // events sorted by time; events_[0:head_) have already been popped
+    std::vector<Event> events_;
+    std::size_t head_ = 0;
+
+    // events that have been pushed since the last merge, and the earliest
+    // of their times
+    std::vector<Event> staged_;
+    time_type staged_min_ = time_type();
+
+    // the storage that events_ is merged into
+    std::vector<Event> merged_;
 };
 
 } // namespace nest
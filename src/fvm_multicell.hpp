@@ -3,8 +3,11 @@
 #include <algorithm>
 #include <iterator>
 #include <map>
+#include <numeric>
 #include <set>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <algorithms.hpp>
@@ -16,9 +19,11 @@
 #include <math.hpp>
 #include <matrix.hpp>
 #include <memory/memory.hpp>
+#include <memory_usage.hpp>
 #include <profiling/profiler.hpp>
 #include <segment.hpp>
 #include <stimulus.hpp>
+#include <threading/threading.hpp>
 #include <util/debug.hpp>
 #include <util/meta.hpp>
 #include <util/partition.hpp>
@@ -29,6 +34,51 @@ namespace nest {
 namespace mc {
 namespace fvm {
 
+namespace impl {
+    // Test if a backend matrix assembler can assemble and solve the
+    // system in one pass, with an assemble_and_solve method.
+    template <typename Assembler, typename View, typename = void>
+    struct has_fused_solve: std::false_type {};
+
+    template <typename Assembler, typename View>
+    struct has_fused_solve<Assembler, View, decltype(
+        std::declval<Assembler&>().assemble_and_solve(0., std::declval<View>()),
+        void())>: std::true_type {};
+
+    // Test if a backend matrix assembler can solve large cells in parallel,
+    // with a decompose_cells method.
+    template <typename Assembler, typename = void>
+    struct has_decompose_cells: std::false_type {};
+
+    template <typename Assembler>
+    struct has_decompose_cells<Assembler, decltype(
+        std::declval<Assembler&>().decompose_cells(0u),
+        void())>: std::true_type {};
+
+    // Test if a backend matrix assembler can use an interleaved layout
+    // that solves several cells at once, with an interleave method.
+    template <typename Assembler, typename = void>
+    struct has_interleave: std::false_type {};
+
+    template <typename Assembler>
+    struct has_interleave<Assembler, decltype(
+        std::declval<Assembler&>().interleave(
+            std::declval<const typename Assembler::layout_type&>()),
+        void())>: std::true_type {};
+}
+
+/// The values of v permuted so that v[i] moves to position order[i].
+template <typename T, typename I>
+std::vector<T> permute(const std::vector<T>& v, const std::vector<I>& order) {
+    EXPECTS(v.size()==order.size());
+
+    std::vector<T> out(v.size());
+    for (std::size_t i=0; i<v.size(); ++i) {
+        out[order[i]] = v[i];
+    }
+    return out;
+}
+
 inline int find_cv_index(const segment_location& loc, const compartment_model& graph) {
     const auto& si = graph.segment_index;
     const auto seg = loc.segment;
@@ -72,6 +122,14 @@ public:
         resting_potential_ = potential_mV;
     }
 
+    /// Number the compartments of each cell depth first, instead of segment
+    /// by segment, so that the compartments of each sub-tree of the cell are
+    /// contiguous. Must be set before initialize(); a cell_group sets it from
+    /// its cell_group_options.
+    void depth_first_numbering(bool enable) {
+        depth_first_numbering_ = enable;
+    }
+
     template <typename Cells, typename Detectors, typename Targets, typename Probes>
     void initialize(
         const Cells& cells,           // collection of nest::mc::cell descriptions
@@ -81,10 +139,22 @@ public:
 
     void reset();
 
+    /// an event to be delivered to the target with handle `handle`
+    struct deliverable_event {
+        target_handle handle;
+        value_type weight;
+    };
+
     void deliver_event(target_handle h, value_type weight) {
         mechanisms_[h.first]->net_receive(h.second, weight);
     }
 
+    /// Deliver a batch of events, which must be sorted by target handle,
+    /// i.e. by mechanism.
+    /// Each mechanism receives its events in a single call.
+    template <typename Events>
+    void deliver_events(const Events& events);
+
     value_type detector_voltage(detector_handle h) const {
         return voltage_[h]; // detector_handle is just the compartment index
     }
@@ -180,23 +250,123 @@ public:
         return it==mechanisms_.end() ? util::nothing: util::just(*it);
     }
 
-    value_type time() const { return t_; }
+    double time() const { return t_; }
+
+    /// true if the cell matrices are solved in the interleaved layout
+    bool matrix_interleaved() const {
+        return matrix_interleaved_;
+    }
+
+    /// The interleaved matrix layout is used if at least this fraction
+    /// of its storage holds compartments, not padding.
+    static constexpr double min_interleave_efficiency = 0.8;
+
+    /// true if the first mechanism writes, instead of adds, the current of
+    /// every CV, so that the current is not zeroed before each step
+    bool overwrite_current() const {
+        return overwrite_current_;
+    }
+
+    /// the number of cells that are solved with the branch parallel solver
+    size_type num_decomposed_cells() const {
+        return num_decomposed_cells_;
+    }
+
+    /// Cells with at least this many compartments are solved with the branch
+    /// parallel solver, if there is more than one thread and the matrix is
+    /// not interleaved.
+    static constexpr size_type min_decomposed_cell_size = 10000;
+
+    /// The node indexes of density mechanisms are accessed directly over
+    /// runs of consecutive CVs if the runs are this long on average.
+    static constexpr size_type min_index_run_length = 8;
 
     std::size_t num_probes() const { return probes_.size(); }
 
+    /// The arena from which the state of the group is allocated by
+    /// backends with arena allocated storage, with the bytes allocated to
+    /// each component: "state" (voltage, current and the CV geometry),
+    /// "matrix", "mechanisms" and "ions".
+    const memory::arena& arena() const { return arena_; }
+
+    /// The memory used by the cell state, matrix, mechanisms and ions.
+    /// With an arena allocated backend this is the allocations from the
+    /// arena of each component, otherwise it is the size of their arrays.
+    /// The lookup tables of the mechanisms are counted in both cases.
+    mc::memory_usage memory_usage() const {
+        mc::memory_usage m;
+        if (arena_.size()) {
+            auto component = [this](const char* name) -> std::size_t {
+                auto it = arena_.usage().find(name);
+                return it==arena_.usage().end()? 0: it->second;
+            };
+            m.state = component("state");
+            m.matrix = component("matrix");
+            m.mechanisms = component("mechanisms");
+            m.ions = component("ions");
+
+            // the lookup tables of mechanisms are built outside the arena
+            for (const auto& mech: mechanisms_) {
+                m.mechanisms += mech->table_memory();
+            }
+        }
+        else {
+            m.state = (cv_areas_.size()+face_conductance_.size()+cv_capacitance_.size()
+                      +current_.size()+voltage_.size())*sizeof(value_type);
+            m.matrix = matrix_.memory();
+            for (const auto& mech: mechanisms_) {
+                m.mechanisms += mech->memory();
+            }
+            for (const auto& ion: ions_) {
+                m.ions += ion.second.memory();
+            }
+        }
+        m.state += vector_memory(probes_)+vector_memory(event_index_)+vector_memory(event_weight_);
+        return m;
+    }
+
+    /// the number of calls to advance() since initialize() or reset()
+    std::size_t num_steps() const { return num_steps_; }
+
+    /// The number of those steps with a different dt to the step before,
+    /// including the first step, in which the terms of the matrix that
+    /// depend on dt are recomputed.
+    std::size_t num_dt_changes() const { return num_dt_changes_; }
+
 private:
-    /// current time [ms]
-    value_type t_ = value_type{0};
+    /// The storage of the cell state, matrix, mechanisms and ions, which
+    /// must be destroyed after them, and so is declared first.
+    memory::arena arena_;
+
+    /// current time [ms], accumulated in double precision whatever the
+    /// value_type of the backend
+    double t_ = 0;
 
     /// resting potential (initial voltage condition)
     value_type resting_potential_ = -65;
 
+    /// number compartments depth first in initialize()
+    bool depth_first_numbering_ = false;
+
+    /// the time step of the last step, and the step counts
+    double dt_ = 0;
+    std::size_t num_steps_ = 0;
+    std::size_t num_dt_changes_ = 0;
+
     /// the linear system for implicit time stepping of cell state
     matrix_type matrix_;
 
     /// the helper used to construct the matrix
     matrix_assembler matrix_assembler_;
 
+    bool matrix_interleaved_ = false;
+
+    size_type num_decomposed_cells_ = 0;
+
+    /// true if the first mechanism writes the current of every CV, so that
+    /// the current is not zeroed at the start of each step
+    bool overwrite_current_ = false;
+
     /// cv_areas_[i] is the surface area of CV i [µm^2]
     array cv_areas_;
 
@@ -223,6 +393,10 @@ private:
 
     std::vector<std::pair<const array fvm_multicell::*, size_type>> probes_;
 
+    /// scratch space for the instance indexes and weights of batched events
+    std::vector<size_type> event_index_;
+    std::vector<value_type> event_weight_;
+
     /// Compact representation of the control volumes into which a segment is
     /// decomposed. Used to reconstruct the weights used to convert current
     /// densities to currents for density channels.
@@ -262,6 +436,65 @@ private:
         std::vector<value_type>& tmp_cv_areas,
         std::vector<value_type>& tmp_cv_capacitance
     );
+
+    // Use the interleaved matrix layout if there are enough cells to fill
+    // at least one block, and the cells are of similar enough size that
+    // the interleaved layout is not mostly padding.
+    void interleave_matrix(
+        const std::vector<size_type>& parent_index,
+        const std::vector<size_type>& cell_index,
+        std::true_type)
+    {
+        if (cell_index.size()-1<matrix_assembler::simd_width) {
+            return;
+        }
+        auto layout = matrix_assembler::make_layout(parent_index, cell_index);
+        if (layout.efficiency()>=min_interleave_efficiency) {
+            matrix_assembler_.interleave(layout);
+            matrix_interleaved_ = true;
+        }
+    }
+
+    void interleave_matrix(
+        const std::vector<size_type>&, const std::vector<size_type>&, std::false_type)
+    {}
+
+    // Solve large cells with the branch parallel solver.
+    void decompose_matrix(std::true_type) {
+        if (!matrix_interleaved_ && threading::num_threads()>1) {
+            num_decomposed_cells_ = matrix_assembler_.decompose_cells(min_decomposed_cell_size);
+        }
+    }
+
+    void decompose_matrix(std::false_type) {}
+
+    /// true if index has one entry for each of the n CVs
+    static bool covers_all_cvs(std::vector<size_type> index, size_type n) {
+        if (index.size()!=n) {
+            return false;
+        }
+        std::sort(index.begin(), index.end());
+        return std::adjacent_find(index.begin(), index.end())==index.end();
+    }
+
+    // update voltage_ by solving the linear system for time step dt, which
+    // is passed to the assembler in double precision
+    void solve_voltage(double dt, std::true_type) {
+        PE("matrix", "solve");
+        matrix_assembler_.assemble_and_solve(dt, voltage_);
+        PL(2);
+    }
+
+    void solve_voltage(double dt, std::false_type) {
+        PE("matrix", "setup");
+        matrix_assembler_.assemble(dt);
+
+        PL(); PE("solve");
+        matrix_.solve();
+        PL();
+        memory::copy(matrix_.rhs(), voltage_);
+        PL();
+    }
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -431,6 +664,9 @@ void fvm_multicell<Backend>::initialize(
     auto cell_comp_part = make_partition(cell_comp_bounds, cell_num_compartments);
     auto ncomp = cell_comp_part.bounds().second;
 
+    // allocate the storage of the group from its arena
+    memory::arena_scope arena_scope(arena_, "state");
+
     // initialize storage from total compartment count
     current_ = array(ncomp, 0);
     voltage_ = array(ncomp, resting_potential_);
@@ -443,6 +679,14 @@ void fvm_multicell<Backend>::initialize(
     // initialize vector used for matrix creation.
     std::vector<size_type> group_parent_index(ncomp);
 
+    // The compartments are first numbered segment by segment in each cell,
+    // and comp_order[i] is the final index of compartment i.
+    // Only the stimuli, detectors and probes, and the synapses are numbered
+    // in the final order in the loop over cells, the remaining compartment
+    // information is permuted afterwards.
+    std::vector<size_type> comp_order(ncomp);
+    std::iota(comp_order.begin(), comp_order.end(), size_type(0));
+
     // create each cell:
     auto target_hi = target_handles.begin();
     auto detector_hi = detector_handles.begin();
@@ -475,6 +719,13 @@ void fvm_multicell<Backend>::initialize(
             group_parent_index[k] = graph.parent_index[k-comp_ival.first]+comp_ival.first;
         }
 
+        if (depth_first_numbering_) {
+            auto numbering = algorithms::depth_first_numbering(graph.parent_index);
+            for (auto k: make_span(comp_ival)) {
+                comp_order[k] = numbering[k-comp_ival.first]+comp_ival.first;
+            }
+        }
+
         auto seg_num_compartments =
             transform_view(c.segments(), [](const segment_ptr& s) { return s->num_compartments(); });
         const auto nseg = seg_num_compartments.size();
@@ -514,7 +765,7 @@ void fvm_multicell<Backend>::initialize(
 
             auto& map_entry = syn_mech_map[syn_mech_index];
 
-            auto syn_cv = comp_ival.first + find_cv_index(syn.location, graph);
+            auto syn_cv = comp_order[comp_ival.first + find_cv_index(syn.location, graph)];
             map_entry.push_back(syn_cv);
         }
 
@@ -528,7 +779,7 @@ void fvm_multicell<Backend>::initialize(
         std::vector<value_type> stim_delays;
         std::vector<value_type> stim_amplitudes;
         for (const auto& stim: c.stimuli()) {
-            auto idx = comp_ival.first+find_cv_index(stim.location, graph);
+            auto idx = comp_order[comp_ival.first+find_cv_index(stim.location, graph)];
             stim_index.push_back(idx);
             stim_durations.push_back(stim.clamp.duration());
             stim_delays.push_back(stim.clamp.delay());
@@ -543,6 +794,7 @@ void fvm_multicell<Backend>::initialize(
         //       This is because the hard-coded stimulus mechanism makes no
         //       optimizations that rely on this assumption.
         if (stim_index.size()) {
+            memory::arena_scope stim_scope(arena_, "mechanisms");
             auto stim = new stimulus(
                 voltage_, current_, memory::make_const_view(stim_index));
             stim->set_parameters(stim_amplitudes, stim_durations, stim_delays);
@@ -553,7 +805,7 @@ void fvm_multicell<Backend>::initialize(
         for (const auto& detector: c.detectors()) {
             EXPECTS(detectors_count < detectors_size);
 
-            auto comp = comp_ival.first+find_cv_index(detector.location, graph);
+            auto comp = comp_order[comp_ival.first+find_cv_index(detector.location, graph)];
             *detector_hi++ = comp;
             ++detectors_count;
         }
@@ -562,7 +814,7 @@ void fvm_multicell<Backend>::initialize(
         for (const auto& probe: c.probes()) {
             EXPECTS(probes_count < probes_size);
 
-            auto comp = comp_ival.first+find_cv_index(probe.location, graph);
+            auto comp = comp_order[comp_ival.first+find_cv_index(probe.location, graph)];
             switch (probe.kind) {
             case probeKind::membrane_voltage:
                 *probe_hi++ = {&fvm_multicell::voltage_, comp};
@@ -583,19 +835,37 @@ void fvm_multicell<Backend>::initialize(
     EXPECTS(probes_size==probes_count);
 
     // store the geometric information in target-specific containers
-    face_conductance_ = make_const_view(tmp_face_conductance);
-    cv_areas_         = make_const_view(tmp_cv_areas);
-    cv_capacitance_   = make_const_view(tmp_cv_capacitance);
+    if (depth_first_numbering_) {
+        for (auto& p: group_parent_index) {
+            p = comp_order[p];
+        }
+        group_parent_index = permute(group_parent_index, comp_order);
+
+        face_conductance_ = make_const_view(permute(tmp_face_conductance, comp_order));
+        cv_areas_         = make_const_view(permute(tmp_cv_areas, comp_order));
+        cv_capacitance_   = make_const_view(permute(tmp_cv_capacitance, comp_order));
+    }
+    else {
+        face_conductance_ = make_const_view(tmp_face_conductance);
+        cv_areas_         = make_const_view(tmp_cv_areas);
+        cv_capacitance_   = make_const_view(tmp_cv_capacitance);
+    }
 
     // initalize matrix
+    arena_scope.set_component("matrix");
     matrix_ = matrix_type(group_parent_index, cell_comp_bounds);
 
     matrix_assembler_ = matrix_assembler(
-        matrix_.d(), matrix_.u(), matrix_.rhs(), matrix_.p(),
+        matrix_.d(), matrix_.u(), matrix_.rhs(), matrix_.p(), matrix_.cell_index(),
         cv_capacitance_, face_conductance_, voltage_, current_);
 
+    interleave_matrix(group_parent_index, cell_comp_bounds,
+        impl::has_interleave<matrix_assembler>());
+    decompose_matrix(impl::has_decompose_cells<matrix_assembler>());
+
     // For each density mechanism build the full node index, i.e the list of
     // compartments with that mechanism, then build the mechanism instance.
+    arena_scope.set_component("mechanisms");
     std::vector<size_type> mech_cv_index(ncomp);
     std::vector<value_type> mech_cv_weight(ncomp);
     std::map<std::string, std::vector<size_type>> mech_index_map;
@@ -636,10 +906,38 @@ void fvm_multicell<Backend>::initialize(
             w *= 1e-2;
         }
 
+        if (depth_first_numbering_) {
+            std::vector<std::pair<size_type, value_type>> cvs;
+            for (auto i: make_span(0u, mech_cv_index.size())) {
+                cvs.push_back({comp_order[mech_cv_index[i]], mech_cv_weight[i]});
+            }
+            std::sort(cvs.begin(), cvs.end());
+            assign_by(mech_cv_index, cvs, [](const std::pair<size_type, value_type>& x) { return x.first; });
+            assign_by(mech_cv_weight, cvs, [](const std::pair<size_type, value_type>& x) { return x.second; });
+        }
+
         mechanisms_.push_back(
             backend::make_mechanism(mech.first, voltage_, current_, mech_cv_weight, mech_cv_index)
         );
 
+        // Access the CV state directly over runs of consecutive CVs, if the
+        // runs are long enough to be worth vectorizing.
+        auto runs = algorithms::contiguous_runs(mech_cv_index);
+        if ((runs.size()-1)*min_index_run_length<=mech_cv_index.size()) {
+            mechanisms_.back()->set_index_runs(runs);
+        }
+
+        // The first density mechanism that is defined on every CV writes the
+        // current instead of adding to it, so that the current need not be
+        // zeroed before each step: it is moved to the front of the mechanisms
+        // so that its current is computed first.
+        if (!overwrite_current_ && covers_all_cvs(mech_cv_index, ncomp)) {
+            overwrite_current_ = mechanisms_.back()->set_overwrite_current(true);
+            if (overwrite_current_) {
+                std::rotate(mechanisms_.begin(), std::prev(mechanisms_.end()), mechanisms_.end());
+            }
+        }
+
         // save the indices for easy lookup later in initialization
         mech_index_map[mech.first] = mech_cv_index;
     }
@@ -690,6 +988,7 @@ void fvm_multicell<Backend>::initialize(
     EXPECTS(targets_size==targets_count);
 
     // build the ion species
+    arena_scope.set_component("ions");
     for (auto ion : mechanisms::ion_kinds()) {
         // find the compartment indexes of all compartments that have a
         // mechanism that depends on/influences ion
@@ -740,10 +1039,39 @@ void fvm_multicell<Backend>::initialize(
     reset();
 }
 
+template <typename Backend>
+template <typename Events>
+void fvm_multicell<Backend>::deliver_events(const Events& events) {
+    auto b = std::begin(events);
+    auto e = std::end(events);
+
+    EXPECTS(std::is_sorted(b, e,
+        [](const deliverable_event& l, const deliverable_event& r) {
+            return l.handle.first<r.handle.first;
+        }));
+
+    while (b!=e) {
+        auto mech_index = b->handle.first;
+
+        event_index_.clear();
+        event_weight_.clear();
+        for (; b!=e && b->handle.first==mech_index; ++b) {
+            event_index_.push_back(b->handle.second);
+            event_weight_.push_back(b->weight);
+        }
+
+        mechanisms_[mech_index]->net_receive_batch(
+            event_index_.data(), event_weight_.data(), event_index_.size());
+    }
+}
+
 template <typename Backend>
 void fvm_multicell<Backend>::reset() {
     memory::fill(voltage_, resting_potential_);
     t_ = 0.;
+    dt_ = 0.;
+    num_steps_ = 0;
+    num_dt_changes_ = 0;
     for (auto& m : mechanisms_) {
         // TODO : the parameters have to be set before the nrn_init
         // for now use a dummy value of dt.
@@ -754,10 +1082,19 @@ void fvm_multicell<Backend>::reset() {
 
 template <typename Backend>
 void fvm_multicell<Backend>::advance(double dt) {
+    ++num_steps_;
+    if (dt!=dt_) {
+        ++num_dt_changes_;
+        dt_ = dt;
+    }
+
     PE("current");
-    memory::fill(current_, 0.);
+    if (!overwrite_current_) {
+        memory::fill(current_, 0.);
+    }
 
-    // update currents from ion channels
+    // update currents from ion channels; if overwrite_current_ is set, the
+    // first mechanism writes the current of every CV
     for(auto& m : mechanisms_) {
         PE(m->name().c_str());
         m->set_params(t_, dt);
@@ -767,14 +1104,7 @@ void fvm_multicell<Backend>::advance(double dt) {
     PL();
 
     // solve the linear system
-    PE("matrix", "setup");
-    matrix_assembler_.assemble(dt);
-
-    PL(); PE("solve");
-    matrix_.solve();
-    PL();
-    memory::copy(matrix_.rhs(), voltage_);
-    PL();
+    solve_voltage(dt, impl::has_fused_solve<matrix_assembler, view>());
 
     // integrate state of gating variables etc.
     PE("state");
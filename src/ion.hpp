@@ -71,7 +71,7 @@ public :
 
     std::size_t memory() const {
         return 4u*size() * sizeof(value_type)
-               +  size() * sizeof(iarray)
+               +  size() * sizeof(size_type)
                +  sizeof(ion);
     }
 
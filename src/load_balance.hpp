@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <cell.hpp>
+#include <common_types.hpp>
+#include <recipe.hpp>
+#include <threading/threading.hpp>
+#include <util/debug.hpp>
+#include <util/span.hpp>
+
+namespace nest {
+namespace mc {
+
+/// Linear model of the relative cost of advancing a cell, in arbitrary
+/// units. The default coefficients weight the work per time step of
+/// the matrix solve and density mechanisms (per compartment), synapse
+/// state updates and event delivery (per target), threshold detection
+/// (per source) and sampling (per probe), on top of a fixed per-cell
+/// overhead.
+struct cell_cost_model {
+    double per_cell = 4;
+    double per_compartment = 1;
+    double per_target = 0.5;
+    double per_source = 0.2;
+    double per_probe = 0.1;
+
+    double cost(const cell_count_info& info, cell_size_type num_compartments) const {
+        return per_cell
+            + per_compartment*num_compartments
+            + per_target*info.num_targets
+            + per_source*info.num_sources
+            + per_probe*info.num_probes;
+    }
+};
+
+/// Estimated cost of each of the cells with gid in [first, last).
+inline std::vector<double> estimate_cell_costs(
+    const recipe& rec, cell_gid_type first, cell_gid_type last,
+    const cell_cost_model& model = cell_cost_model{})
+{
+    std::vector<double> costs(last-first);
+    threading::parallel_for::apply(0, costs.size(),
+        [&](int i) {
+            auto gid = first+i;
+            costs[i] = model.cost(
+                rec.get_cell_count_info(gid), rec.get_cell(gid).num_compartments());
+        });
+    return costs;
+}
+
+/// Split the sequence of costs into n contiguous parts of as close to equal
+/// total cost as possible.
+/// Returns the n+1 divisions of the partition, as indexes into costs.
+/// No part is empty, unless there are fewer costs than parts.
+inline std::vector<cell_size_type> partition_by_cost(const std::vector<double>& costs, unsigned n) {
+    EXPECTS(n>0);
+
+    cell_size_type size = costs.size();
+    std::vector<double> prefix(size+1, 0.);
+    std::partial_sum(costs.begin(), costs.end(), prefix.begin()+1);
+
+    std::vector<cell_size_type> divs(n+1, 0);
+    divs[n] = size;
+    for (auto k: util::make_span(1u, n)) {
+        // find the division that is closest to the k'th n-tile of the cost
+        auto target = prefix.back()*k/n;
+        cell_size_type i = std::lower_bound(prefix.begin(), prefix.end(), target)-prefix.begin();
+        if (i>0 && target-prefix[i-1]<prefix[i]-target) {
+            --i;
+        }
+
+        // leave at least one item for each remaining part
+        auto lo = std::min(divs[k-1]+1, size);
+        auto hi = size>=n? size-(n-k): size;
+        divs[k] = std::max(lo, std::min(i, hi));
+    }
+
+    return divs;
+}
+
+/// The cells and cell groups assigned to one domain.
+struct load_balance {
+    /// the range [first, last) of gids of the cells in the domain
+    std::pair<cell_gid_type, cell_gid_type> cell_range;
+
+    /// the partition of the cell range into cell groups
+    std::vector<cell_gid_type> group_divisions;
+
+    /// the estimated cost of each cell group
+    std::vector<double> group_costs;
+};
+
+/// Distribute cells with the given estimated costs over num_domains domains
+/// in contiguous ranges of equal estimated cost, then split the cells of
+/// domain_id into cell groups of equal estimated cost.
+///
+/// The number of groups in the domain is the number of cells divided by
+/// group_size, rounded up, as if the cells were split evenly into groups
+/// of group_size cells.
+inline load_balance balance_cells(
+    const std::vector<double>& costs, unsigned num_domains, unsigned domain_id,
+    cell_size_type group_size)
+{
+    EXPECTS(domain_id<num_domains);
+    EXPECTS(group_size>0);
+
+    load_balance lb;
+    auto domain_divs = partition_by_cost(costs, num_domains);
+    lb.cell_range = {domain_divs[domain_id], domain_divs[domain_id+1]};
+
+    auto first = lb.cell_range.first;
+    auto ncells = lb.cell_range.second-first;
+    if (ncells==0) {
+        lb.group_divisions = {first};
+        return lb;
+    }
+
+    std::vector<double> local_costs(costs.begin()+first, costs.begin()+lb.cell_range.second);
+    auto ngroups = (ncells+group_size-1)/group_size;
+    for (auto d: partition_by_cost(local_costs, ngroups)) {
+        lb.group_divisions.push_back(first+d);
+    }
+
+    for (auto i: util::make_span(0u, ngroups)) {
+        auto b = local_costs.begin();
+        lb.group_costs.push_back(std::accumulate(
+            b+(lb.group_divisions[i]-first), b+(lb.group_divisions[i+1]-first), 0.));
+    }
+
+    return lb;
+}
+
+/// Distribute the cells of a recipe over the domains of the communication
+/// policy, and split the cells of the local domain into cell groups, as
+/// above.
+///
+/// Each domain estimates the costs of an equal share of the cells, which
+/// requires a call to recipe::get_cell for each of them, and the costs of
+/// all cells are gathered on every domain.
+template <typename Communication>
+load_balance balance_cells(
+    const recipe& rec, cell_size_type group_size,
+    const cell_cost_model& model = cell_cost_model{})
+{
+    unsigned num_domains = Communication::size();
+    unsigned domain_id = Communication::id();
+
+    std::uint64_t ncells = rec.num_cells();
+    cell_gid_type first = ncells*domain_id/num_domains;
+    cell_gid_type last = ncells*(domain_id+1)/num_domains;
+    auto costs = Communication::gather_all(estimate_cell_costs(rec, first, last, model));
+
+    return balance_cells(costs, num_domains, domain_id, group_size);
+}
+
+} // namespace mc
+} // namespace nest
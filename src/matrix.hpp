@@ -63,6 +63,12 @@ public:
         return cell_index_.size() - 1;
     }
 
+    /// the memory used by the matrix and its indexes, in bytes
+    std::size_t memory() const {
+        return (d_.size()+u_.size()+rhs_.size())*sizeof(value_type)
+             + (parent_index_.size()+cell_index_.size())*sizeof(size_type);
+    }
+
     /// the vector holding the diagonal of the matrix
     view d() { return d_; }
     const_view d() const { return d_; }
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 #include <util/meta.hpp>
 
 #include <indexed_view.hpp>
@@ -62,6 +63,39 @@ public:
     virtual void nrn_state()    = 0;
     virtual void nrn_current()  = 0;
     virtual void net_receive(int, value_type) {};
+
+    /// Deliver a batch of n events, where event k adds weight[k] to the
+    /// instance with index[k].
+    /// Mechanisms that support events override this with a single loop over
+    /// the batch; the default makes one call to net_receive() per event.
+    virtual void net_receive_batch(const size_type* index, const value_type* weight, size_type n) {
+        for (size_type k=0; k<n; ++k) {
+            net_receive(index[k], weight[k]);
+        }
+    }
+
+    /// Density mechanisms that are defined on every CV can write, instead of
+    /// add, their contribution to vec_i_ in nrn_current(), which saves
+    /// zeroing vec_i_ before the currents are updated each step.
+    /// Returns false if the mechanism does not support overwriting.
+    virtual bool set_overwrite_current(bool) { return false; }
+
+    /// Partition the instances into runs [divisions[k], divisions[k+1]) on
+    /// consecutive CVs, over which density mechanisms can access the CV
+    /// state directly instead of through the node index.
+    /// Returns false if the mechanism does not support direct access.
+    virtual bool set_index_runs(const std::vector<size_type>&) { return false; }
+
+    /// The largest error of the lookup tables that the mechanism interpolates
+    /// from in place of evaluating its rate functions, relative to the
+    /// magnitude of the tabulated values, as measured by nrn_init().
+    /// Zero for mechanisms without tables.
+    virtual value_type table_error() const { return 0; }
+
+    /// The bytes of the lookup tables, which are included in memory(), but
+    /// are not allocated from the arena of the cell group.
+    virtual std::size_t table_memory() const { return 0; }
+
     virtual bool uses_ion(ionKind) const = 0;
     virtual void set_ion(ionKind k, ion_type& i, const std::vector<size_type>& index) = 0;
 
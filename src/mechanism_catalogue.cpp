@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <dlfcn.h>
+
+#include <mechanism_catalogue.hpp>
+#include <util/path.hpp>
+
+namespace nest {
+namespace mc {
+
+const nmc_catalogue& open_catalogue(const std::string& path) {
+    // clear any error left by an earlier call
+    dlerror();
+
+    void* handle = dlopen(path.c_str(), RTLD_NOW|RTLD_LOCAL);
+    if (!handle) {
+        throw std::runtime_error(
+            "unable to load mechanism catalogue "+path+" : "+dlerror());
+    }
+
+    auto symbol = dlsym(handle, "nmc_mechanism_catalogue");
+    if (!symbol) {
+        throw std::runtime_error(
+            path+" is not a mechanism catalogue : "+dlerror());
+    }
+
+    auto catalogue = reinterpret_cast<nmc_catalogue_function>(symbol)();
+    if (!catalogue || catalogue->version!=NMC_CATALOGUE_VERSION) {
+        throw std::runtime_error(
+            "mechanism catalogue "+path+" has the wrong version : expected "
+            +std::to_string(NMC_CATALOGUE_VERSION));
+    }
+
+    return *catalogue;
+}
+
+std::vector<std::string> find_catalogues(const std::string& search_path) {
+    std::vector<std::string> paths;
+
+    std::istringstream dirs(search_path);
+    std::string dir;
+    while (std::getline(dirs, dir, ':')) {
+        if (dir.empty()) {
+            continue;
+        }
+
+        DIR* d = opendir(dir.c_str());
+        if (!d) {
+            continue;
+        }
+
+        std::vector<std::string> names;
+        while (auto entry = readdir(d)) {
+            std::string name = entry->d_name;
+            auto n = name.size();
+            if (n>3 && name.compare(n-3, 3, ".so")==0) {
+                names.push_back(name);
+            }
+        }
+        closedir(d);
+
+        std::sort(names.begin(), names.end());
+        for (auto& name: names) {
+            paths.push_back((util::path(dir)/name).native());
+        }
+    }
+
+    return paths;
+}
+
+} // namespace mc
+} // namespace nest
@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+ * A mechanism catalogue is a shared library of mechanisms that is loaded at
+ * run time, so that mechanisms can be added without rebuilding the library.
+ *
+ * A catalogue exports one function with C linkage,
+ *
+ *      const nmc_catalogue* nmc_mechanism_catalogue();
+ *
+ * which describes the mechanisms in the library, and the function of each
+ * backend that makes them. modcc generates the catalogue of a mechanism with
+ * the --catalogue flag, e.g.
+ *
+ *      modcc -t cpu --catalogue -o hh_catalogue.cpp hh.mod
+ *
+ * and the build_catalogues function in mechanisms/BuildModules.cmake builds
+ * such catalogues into shared libraries.
+ *
+ * The makers are C++ functions of the backend types, so a catalogue has to be
+ * built with the same compiler and headers as the library that loads it.
+ */
+
+#include <string>
+#include <vector>
+
+#define NMC_CATALOGUE_VERSION 1
+
+extern "C" {
+
+struct nmc_catalogue_entry {
+    const char* name;       // the name of the mechanism, e.g. "hh"
+    const char* backend;    // the name() of the backend, e.g. "cpu"
+    void (*maker)();        // the maker_type of the backend
+};
+
+struct nmc_catalogue {
+    unsigned version;       // NMC_CATALOGUE_VERSION of the catalogue
+    unsigned size;
+    const nmc_catalogue_entry* entries;
+};
+
+typedef const nmc_catalogue* (*nmc_catalogue_function)();
+
+} // extern "C"
+
+// Define the catalogue of the modcc generated mechanism Mech, which is a
+// template on the backend, for both multicore backends.
+#define NMC_MULTICORE_CATALOGUE(name, Mech)                                    \
+extern "C" const nmc_catalogue* nmc_mechanism_catalogue() {                    \
+    using ::nest::mc::multicore::backend;                                      \
+    using ::nest::mc::multicore::backend_f32;                                  \
+    static const nmc_catalogue_entry entries[] = {                             \
+        {#name, "cpu", reinterpret_cast<void (*)()>(&backend::maker<Mech>)},   \
+        {#name, "cpu_f32", reinterpret_cast<void (*)()>(&backend_f32::maker<Mech>)} \
+    };                                                                         \
+    static const nmc_catalogue catalogue = {NMC_CATALOGUE_VERSION, 2, entries}; \
+    return &catalogue;                                                         \
+}
+
+namespace nest {
+namespace mc {
+
+/// Load the catalogue in the shared library at path.
+///
+/// Throws std::runtime_error if the library can't be loaded, or is not a
+/// catalogue with the same version as this library.
+/// The library is never unloaded, because mechanisms made by it may be
+/// alive until the program exits.
+const nmc_catalogue& open_catalogue(const std::string& path);
+
+/// The paths of the shared libraries in the directories of a colon separated
+/// search path, in the order of the directories, and in alphabetical order in
+/// each directory. Directories that don't exist are skipped.
+std::vector<std::string> find_catalogues(const std::string& search_path);
+
+} // namespace mc
+} // namespace nest
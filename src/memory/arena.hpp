@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "allocator.hpp"
+
+namespace nest {
+namespace mc {
+namespace memory {
+
+/// A region of host memory from which the state of a cell group is
+/// sub-allocated with a bump pointer, so that the state of the group is in
+/// a few large blocks instead of dozens of separate heap allocations.
+///
+/// Allocations are never released individually: the blocks are freed when
+/// the arena is destroyed. Each allocation is attributed to a named
+/// component, for reporting the memory footprint of the group.
+class arena {
+public:
+    using size_type = std::size_t;
+
+    /// allocations are aligned to cache lines
+    static constexpr size_type alignment = 64;
+
+    /// the size of the first block
+    static constexpr size_type min_block_size = size_type(1)<<16;
+
+    /// blocks of at least this size are aligned to, and sized in multiples
+    /// of, huge pages
+    static constexpr size_type huge_page_size = size_type(1)<<21;
+
+    arena() = default;
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    arena(arena&&) = default;
+
+    /// Swap with other, instead of releasing the blocks immediately: in a
+    /// member-wise move assignment the containers that were allocated from
+    /// this arena may be released after it.
+    arena& operator=(arena&& other) {
+        std::swap(blocks_, other.blocks_);
+        std::swap(usage_, other.usage_);
+        return *this;
+    }
+
+    /// Allocate n bytes, aligned to alignment, attributed to component.
+    /// Returns nullptr on failure.
+    void* allocate(size_type n, const std::string& component) {
+        n = round_up(n, alignment);
+        if (blocks_.empty() || blocks_.back().size-blocks_.back().used<n) {
+            auto size = blocks_.empty()? min_block_size: 2*blocks_.back().size;
+            if (!add_block(std::max(size, n))) {
+                return nullptr;
+            }
+        }
+
+        auto& b = blocks_.back();
+        void* ptr = b.data.get()+b.used;
+        b.used += n;
+        usage_[component] += n;
+        return ptr;
+    }
+
+    /// the total size of the blocks of the arena, in bytes
+    size_type capacity() const {
+        size_type n = 0;
+        for (const auto& b: blocks_) {
+            n += b.size;
+        }
+        return n;
+    }
+
+    /// the number of bytes allocated from the arena
+    size_type size() const {
+        size_type n = 0;
+        for (const auto& b: blocks_) {
+            n += b.used;
+        }
+        return n;
+    }
+
+    /// the number of blocks that the arena has allocated
+    size_type num_blocks() const {
+        return blocks_.size();
+    }
+
+    /// the number of bytes allocated to each component
+    const std::map<std::string, size_type>& usage() const {
+        return usage_;
+    }
+
+private:
+    struct block_deleter {
+        void operator()(char* p) const {
+            std::free(p);
+        }
+    };
+
+    struct block {
+        std::unique_ptr<char, block_deleter> data;
+        size_type size;
+        size_type used;
+    };
+
+    std::vector<block> blocks_;
+    std::map<std::string, size_type> usage_;
+
+    static size_type round_up(size_type n, size_type m) {
+        return (n+m-1)/m*m;
+    }
+
+    bool add_block(size_type size) {
+        auto page = size>=huge_page_size? huge_page_size: size_type(4096);
+        size = round_up(size, page);
+
+        void* ptr;
+        if (posix_memalign(&ptr, page, size)) {
+            return false;
+        }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (page==huge_page_size) {
+            madvise(ptr, size, MADV_HUGEPAGE);
+        }
+#endif
+        blocks_.push_back({std::unique_ptr<char, block_deleter>(static_cast<char*>(ptr)), size, 0});
+        return true;
+    }
+};
+
+/// Direct the allocations of containers with an arena_allocator on this
+/// thread to an arena, attributed to component, for the lifetime of the
+/// scope. Scopes can be nested.
+class arena_scope {
+public:
+    arena_scope(arena& a, std::string component):
+        previous_(current())
+    {
+        current() = {&a, std::move(component)};
+    }
+
+    ~arena_scope() {
+        current() = std::move(previous_);
+    }
+
+    arena_scope(const arena_scope&) = delete;
+    arena_scope& operator=(const arena_scope&) = delete;
+
+    /// attribute subsequent allocations in the scope to component
+    void set_component(std::string component) {
+        current().component = std::move(component);
+    }
+
+    /// allocate from the arena of the innermost scope, or return nullptr if
+    /// there is no scope on this thread
+    static void* allocate(std::size_t n) {
+        auto& s = current();
+        return s.a? s.a->allocate(n, s.component): nullptr;
+    }
+
+    static bool active() {
+        return current().a!=nullptr;
+    }
+
+private:
+    struct state {
+        arena* a;
+        std::string component;
+    };
+
+    state previous_;
+
+    static state& current() {
+        static thread_local state s{nullptr, {}};
+        return s;
+    }
+};
+
+namespace impl {
+    // Allocate from the arena of the current arena_scope, or from the heap
+    // outside of any scope.
+    // Each allocation is preceded by a header of Alignment bytes, which
+    // records where it was allocated, so that it can be freed outside of
+    // the scope in which it was allocated.
+    template <size_type Alignment>
+    class arena_policy {
+        static_assert(Alignment<=arena::alignment,
+                "alignment is greater than the alignment of an arena");
+        static_assert(Alignment>=sizeof(bool),
+                "alignment is too small for the allocation header");
+
+    public:
+        void *allocate_policy(size_type size) {
+            bool from_arena = arena_scope::active();
+            char* ptr = from_arena?
+                static_cast<char*>(arena_scope::allocate(size+Alignment)):
+                aligned_malloc<char, Alignment>(size+Alignment);
+            if (ptr==nullptr) {
+                return nullptr;
+            }
+
+            *reinterpret_cast<bool*>(ptr) = from_arena;
+            return ptr+Alignment;
+        }
+
+        void free_policy(void *ptr) {
+            char* base = static_cast<char*>(ptr)-Alignment;
+            if (!*reinterpret_cast<bool*>(base)) {
+                free(base);
+            }
+        }
+
+        static constexpr size_type alignment() {
+            return Alignment;
+        }
+        static constexpr bool is_malloc_compatible() {
+            return false;
+        }
+    };
+} // namespace impl
+
+namespace util {
+    template <size_t Alignment>
+    struct type_printer<impl::arena_policy<Alignment>>{
+        static std::string print() {
+            std::stringstream str;
+            str << "arena_policy<" << Alignment << ">";
+            return str.str();
+        }
+    };
+} // namespace util
+
+/// allocator for containers whose storage is allocated from the arena of
+/// the current arena_scope, aligned to cache lines by default
+template <class T, size_t alignment=arena::alignment>
+using arena_allocator = allocator<T, impl::arena_policy<alignment>>;
+
+} // namespace memory
+} // namespace mc
+} // namespace nest
@@ -2,6 +2,7 @@
 
 #include <iostream>
 
+#include "arena.hpp"
 #include "array.hpp"
 #include "definitions.hpp"
 #include "host_coordinator.hpp"
@@ -20,6 +21,13 @@ using host_vector = array<T, host_coordinator<T>>;
 template <typename T>
 using host_view = array_view<T, host_coordinator<T>>;
 
+// specialization for host vectors allocated from the arena of the current
+// arena_scope, e.g. the state of a cell group
+template <typename T>
+using arena_vector = array<T, host_coordinator<T, arena_allocator<T>>>;
+template <typename T>
+using arena_view = array_view<T, host_coordinator<T, arena_allocator<T>>>;
+
 template <typename T>
 std::ostream& operator<< (std::ostream& o, host_view<T> const& v) {
     o << "[";
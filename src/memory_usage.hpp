@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+namespace nest {
+namespace mc {
+
+/// The memory used by a cell group or model, in bytes, by component.
+struct memory_usage {
+    /// voltage, current, CV geometry, handles and spike detectors
+    std::size_t state = 0;
+    /// the matrix and its assembly
+    std::size_t matrix = 0;
+    /// mechanism state and indexes, including stimuli
+    std::size_t mechanisms = 0;
+    /// ion species state
+    std::size_t ions = 0;
+    /// pending postsynaptic and sample events
+    std::size_t event_queues = 0;
+    /// samplers attached to probes
+    std::size_t samplers = 0;
+    /// network connections and their index
+    std::size_t connections = 0;
+
+    std::size_t total() const {
+        return state+matrix+mechanisms+ions+event_queues+samplers+connections;
+    }
+
+    memory_usage& operator+=(const memory_usage& other) {
+        state += other.state;
+        matrix += other.matrix;
+        mechanisms += other.mechanisms;
+        ions += other.ions;
+        event_queues += other.event_queues;
+        samplers += other.samplers;
+        connections += other.connections;
+        return *this;
+    }
+
+    friend memory_usage operator+(memory_usage a, const memory_usage& b) {
+        return a += b;
+    }
+
+    friend std::ostream& operator<<(std::ostream& o, const memory_usage& m) {
+        auto line = [&o](const char* name, std::size_t bytes) {
+            o << "  " << std::left << std::setw(14) << name << std::right
+              << std::setw(14) << bytes << " B\n";
+        };
+        line("state", m.state);
+        line("matrix", m.matrix);
+        line("mechanisms", m.mechanisms);
+        line("ions", m.ions);
+        line("event queues", m.event_queues);
+        line("samplers", m.samplers);
+        line("connections", m.connections);
+        line("total", m.total());
+        return o;
+    }
+};
+
+/// the bytes allocated by a std::vector
+template <typename T>
+std::size_t vector_memory(const std::vector<T>& v) {
+    return v.capacity()*sizeof(T);
+}
+
+} // namespace mc
+} // namespace nest
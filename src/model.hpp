@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -10,6 +11,7 @@
 #include <cell_group.hpp>
 #include <communication/communicator.hpp>
 #include <communication/global_policy.hpp>
+#include <memory_usage.hpp>
 #include <profiling/profiler.hpp>
 #include <recipe.hpp>
 #include <thread_private_spike_store.hpp>
@@ -22,6 +24,26 @@
 namespace nest {
 namespace mc {
 
+/// Accumulated wall times of the spike exchange and cell update tasks that
+/// model::run overlaps in each integration period.
+struct overlap_statistics {
+    double exchange_time = 0;   // time spent in spike exchange tasks
+    double update_time = 0;     // time spent in cell update tasks
+    double wall_time = 0;       // wall time of the integration periods
+    double hideable_time = 0;   // sum over periods of the shorter task time
+
+    /// The proportion of the time that could be hidden by overlapping the
+    /// tasks that was actually hidden: 1 for perfect overlap, 0 if the
+    /// tasks were serialized.
+    double efficiency() const {
+        if (hideable_time<=0) {
+            return 0;
+        }
+        auto hidden = exchange_time+update_time-wall_time;
+        return std::max(0., std::min(1., hidden/hideable_time));
+    }
+};
+
 template <typename Cell>
 class model {
 public:
@@ -32,6 +54,7 @@ public:
     using sampler_function = typename cell_group_type::sampler_function;
     using spike_type = typename communicator_type::spike_type;
     using spike_export_function = std::function<void(const std::vector<spike_type>&)>;
+    using timer = threading::timer;
 
     struct probe_record {
         cell_member_type id;
@@ -39,7 +62,8 @@ public:
     };
 
     template <typename Iter>
-    model(const recipe& rec, const util::partition_range<Iter>& groups):
+    model(const recipe& rec, const util::partition_range<Iter>& groups,
+          const cell_group_options& group_options = cell_group_options()):
         cell_group_divisions_(groups.divisions().begin(), groups.divisions().end())
     {
         // set up communicator based on partition
@@ -67,7 +91,7 @@ public:
                     }
                 }
 
-                cell_groups_[i] = cell_group_type(gids.first, cells);
+                cell_groups_[i] = cell_group_type(gids.first, cells, group_options);
                 PL(2);
             });
 
@@ -83,6 +107,8 @@ public:
         }
         communicator_.construct();
 
+        group_times_.assign(num_groups(), 0.);
+
         // Allocate an empty queue buffer for each cell group
         // These must be set initially to ensure that a queue is available for each
         // cell group for the first time step.
@@ -113,6 +139,9 @@ public:
         current_spikes().clear();
         previous_spikes().clear();
 
+        overlap_ = overlap_statistics{};
+        std::fill(group_times_.begin(), group_times_.end(), 0.);
+
         util::profilers_restart();
     }
 
@@ -135,7 +164,9 @@ public:
             current_spikes().clear();
 
             // task that updates cell state in parallel.
+            double update_time = 0;
             auto update_cells = [&] () {
+                auto start = timer::tic();
                 threading::parallel_for::apply(
                     0u, cell_groups_.size(),
                      [&](unsigned i) {
@@ -145,20 +176,25 @@ public:
                         group.enqueue_events(current_events()[i]);
                         PL();
 
+                        auto start = timer::tic();
                         group.advance(tuntil, dt);
+                        group_times_[i] += timer::toc(start);
 
                         PE("events");
                         current_spikes().insert(group.spikes());
                         group.clear_spikes();
                         PL(2);
                     });
+                update_time = timer::toc(start);
             };
 
             // task that performs spike exchange with the spikes generated in
             // the previous integration period, generating the postsynaptic
             // events that must be delivered at the start of the next
             // integration period at the latest.
+            double exchange_time = 0;
             auto exchange = [&] () {
+                auto start = timer::tic();
                 PE("stepping", "communciation");
 
                 PE("exchange");
@@ -176,15 +212,22 @@ public:
                 PL();
 
                 PL(2);
+                exchange_time = timer::toc(start);
             };
 
             // run the tasks, overlapping if the threading model and number of
             // available threads permits it.
+            auto start = timer::tic();
             threading::task_group g;
             g.run(exchange);
             g.run(update_cells);
             g.wait();
 
+            overlap_.exchange_time += exchange_time;
+            overlap_.update_time += update_time;
+            overlap_.wall_time += timer::toc(start);
+            overlap_.hideable_time += std::min(exchange_time, update_time);
+
             t_ = tuntil;
         }
 
@@ -211,10 +254,34 @@ public:
 
     const std::vector<probe_record>& probes() const { return probes_; }
 
+    /// Set the policy used by every cell group to deliver postsynaptic events.
+    void set_event_delivery(event_delivery_mode mode) {
+        for (auto& group: cell_groups_) {
+            group.set_event_delivery(mode);
+        }
+    }
+
     std::size_t num_spikes() const {
         return communicator_.num_spikes();
     }
 
+    /// Exchange spike times quantized to multiples of quantum, if the global
+    /// communication policy encodes spike times.
+    /// Returns false if the spike times are exchanged exactly.
+    bool set_spike_time_quantum(double quantum) {
+        return communicator_.set_spike_time_quantum(quantum);
+    }
+
+    /// The time spent advancing each cell group since the last reset.
+    const std::vector<double>& group_times() const {
+        return group_times_;
+    }
+
+    /// Timings of the overlapped exchange and update tasks since the last reset.
+    const overlap_statistics& overlap() const {
+        return overlap_;
+    }
+
     std::size_t num_groups() const {
         return cell_groups_.size();
     }
@@ -224,6 +291,23 @@ public:
         return bounds.second-bounds.first;
     }
 
+    /// The memory used on this rank by the cell groups, the connections and
+    /// the postsynaptic events that are waiting to be delivered to the groups.
+    mc::memory_usage memory_usage() const {
+        mc::memory_usage m;
+        for (const auto& group: cell_groups_) {
+            m += group.memory_usage();
+        }
+        m.connections += communicator_.memory();
+        for (const auto* queues: {&event_queues_.get(), &event_queues_.other()}) {
+            m.event_queues += vector_memory(*queues);
+            for (const auto& q: *queues) {
+                m.event_queues += vector_memory(q);
+            }
+        }
+        return m;
+    }
+
     // access cell_group directly
     cell_group_type& group(int i) {
         return cell_groups_[i];
@@ -249,6 +333,8 @@ private:
     }
 
     time_type t_ = 0.;
+    overlap_statistics overlap_;
+    std::vector<double> group_times_;
     std::vector<cell_group_type> cell_groups_;
     communicator_type communicator_;
     std::vector<probe_record> probes_;
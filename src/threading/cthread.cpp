@@ -0,0 +1,143 @@
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "cthread.hpp"
+
+namespace nest {
+namespace mc {
+namespace threading {
+namespace impl {
+
+namespace {
+    // index of the calling thread in the pool; 0 for threads not in the pool
+    thread_local int this_thread_index = 0;
+
+    int default_num_threads() {
+        if (auto env = std::getenv("NMC_NUM_THREADS")) {
+            auto n = std::atoi(env);
+            if (n>0) {
+                return n;
+            }
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+struct task_system::task_deque {
+    std::mutex mutex;
+    std::deque<task> tasks;
+};
+
+task_system& task_system::get() {
+    static task_system ts(default_num_threads());
+    return ts;
+}
+
+task_system::task_system(int nthreads) {
+    for (int i=0; i<nthreads; ++i) {
+        deques_.push_back(std::unique_ptr<task_deque>(new task_deque));
+    }
+    // the calling thread is worker 0
+    for (int i=1; i<nthreads; ++i) {
+        threads_.emplace_back([this, i]() { worker(i); });
+    }
+}
+
+task_system::~task_system() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        done_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t: threads_) {
+        t.join();
+    }
+}
+
+int task_system::num_threads() const {
+    return deques_.size();
+}
+
+int task_system::thread_index() const {
+    return this_thread_index;
+}
+
+void task_system::async(task t) {
+    // count the task before it can be popped, so that pending_ never
+    // underflows
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        ++pending_;
+    }
+    {
+        auto& q = *deques_[this_thread_index];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(std::move(t));
+    }
+    wake_.notify_one();
+}
+
+bool task_system::try_pop(int i, task& t) {
+    auto n = num_threads();
+
+    // newest task from own deque
+    {
+        auto& q = *deques_[i];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty()) {
+            t = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            --pending_;
+            return true;
+        }
+    }
+
+    // oldest task from the deque of another worker
+    for (int k=1; k<n; ++k) {
+        auto& q = *deques_[(i+k)%n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty()) {
+            t = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            --pending_;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool task_system::try_run_task() {
+    task t;
+    if (try_pop(this_thread_index, t)) {
+        t();
+        return true;
+    }
+    return false;
+}
+
+void task_system::worker(int i) {
+    this_thread_index = i;
+
+    task t;
+    while (true) {
+        if (try_pop(i, t)) {
+            t();
+            t = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait(lock, [this]() { return done_ || pending_>0; });
+        if (done_) {
+            return;
+        }
+    }
+}
+
+} // namespace impl
+} // namespace threading
+} // namespace mc
+} // namespace nest
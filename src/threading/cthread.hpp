@@ -0,0 +1,314 @@
+#pragma once
+
+#if !defined(WITH_CTHREAD)
+    #error "this header can only be loaded if WITH_CTHREAD is set"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nest {
+namespace mc {
+namespace threading {
+
+///////////////////////////////////////////////////////////////////////
+// task system
+///////////////////////////////////////////////////////////////////////
+namespace impl {
+
+using task = std::function<void()>;
+
+/// Persistent pool of std::threads, each with its own task deque.
+///
+/// Workers take tasks from the back of their own deque, and steal from the
+/// front of the deques of other workers when their own is empty.
+/// The thread that created the pool (usually the main thread) is worker 0:
+/// it has a deque, but only runs tasks while waiting for a task_group.
+///
+/// The number of threads is set by the NMC_NUM_THREADS environment
+/// variable, or std::thread::hardware_concurrency() if it is not set.
+class task_system {
+public:
+    /// the global task system, created on first use
+    static task_system& get();
+
+    ~task_system();
+
+    /// the number of threads, including the calling thread
+    int num_threads() const;
+
+    /// the index of the calling thread in [0, num_threads());
+    /// threads that are not in the pool have index 0
+    int thread_index() const;
+
+    /// add a task to the deque of the calling thread
+    void async(task t);
+
+    /// run one pending task if there is one, returning true if a task was run
+    bool try_run_task();
+
+private:
+    task_system(int nthreads);
+
+    void worker(int i);
+    bool try_pop(int i, task& t);
+
+    struct task_deque;
+    std::vector<std::unique_ptr<task_deque>> deques_;
+    std::vector<std::thread> threads_;
+
+    // workers with no tasks sleep on wake_ until there is pending work
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<std::size_t> pending_{0};
+    bool done_ = false;
+};
+
+} // namespace impl
+
+///////////////////////////////////////////////////////////////////////
+// types
+///////////////////////////////////////////////////////////////////////
+template <typename T>
+class enumerable_thread_specific {
+    using storage_class = std::vector<T>;
+    storage_class data;
+public :
+    using iterator = typename storage_class::iterator;
+    using const_iterator = typename storage_class::const_iterator;
+
+    enumerable_thread_specific() {
+        data = std::vector<T>(impl::task_system::get().num_threads());
+    }
+
+    enumerable_thread_specific(const T& init) {
+        data = std::vector<T>(impl::task_system::get().num_threads(), init);
+    }
+
+    T& local() { return data[impl::task_system::get().thread_index()]; }
+    const T& local() const { return data[impl::task_system::get().thread_index()]; }
+
+    auto size() -> decltype(data.size()) const { return data.size(); }
+
+    iterator begin() { return data.begin(); }
+    iterator end()   { return data.end(); }
+
+    const_iterator begin() const { return data.begin(); }
+    const_iterator end()   const { return data.end(); }
+
+    const_iterator cbegin() const { return data.cbegin(); }
+    const_iterator cend()   const { return data.cend(); }
+};
+
+template <typename T>
+class parallel_vector {
+    using value_type = T;
+    std::vector<value_type> data_;
+    std::mutex mutex_;
+public:
+    parallel_vector() = default;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    iterator begin() { return data_.begin(); }
+    iterator end()   { return data_.end(); }
+
+    const_iterator begin() const { return data_.begin(); }
+    const_iterator end()   const { return data_.end(); }
+
+    const_iterator cbegin() const { return data_.cbegin(); }
+    const_iterator cend()   const { return data_.cend(); }
+
+    void push_back (const value_type& val) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        data_.push_back(val);
+    }
+
+    void push_back (value_type&& val) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        data_.push_back(std::move(val));
+    }
+};
+
+inline std::string description() {
+    return "CThread";
+}
+
+struct timer {
+    using time_point = std::chrono::time_point<std::chrono::system_clock>;
+
+    static inline time_point tic() {
+        return std::chrono::system_clock::now();
+    }
+
+    static inline double toc(time_point t) {
+        return std::chrono::duration<double>(tic() - t).count();
+    }
+
+    static inline double difference(time_point b, time_point e) {
+        return std::chrono::duration<double>(e-b).count();
+    }
+};
+
+constexpr bool multithreaded() { return true; }
+
+/// the number of threads available for parallel work
+inline int num_threads() { return impl::task_system::get().num_threads(); }
+
+/// Tasks are run asynchronously by the thread pool.
+/// The thread that calls wait() runs pending tasks until all of the tasks in
+/// the group have completed, so task groups can be nested in tasks.
+/// The first exception thrown by a task is rethrown by wait().
+class task_group {
+public:
+    task_group() = default;
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    ~task_group() {
+        wait_for_tasks();
+    }
+
+    template<typename Func>
+    void run(const Func& f) {
+        ++in_flight_;
+        impl::task_system::get().async(
+            [this, f]() {
+                if (!canceling_) {
+                    try {
+                        f();
+                    }
+                    catch (...) {
+                        std::lock_guard<std::mutex> lock(exception_mutex_);
+                        if (!exception_) {
+                            exception_ = std::current_exception();
+                        }
+                        canceling_ = true;
+                    }
+                }
+                --in_flight_;
+            });
+    }
+
+    template<typename Func>
+    void run_and_wait(const Func& f) {
+        run(f);
+        wait();
+    }
+
+    void wait() {
+        wait_for_tasks();
+        canceling_ = false;
+        if (exception_) {
+            auto e = exception_;
+            exception_ = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    bool is_canceling() {
+        return canceling_;
+    }
+
+    void cancel() {
+        canceling_ = true;
+    }
+
+private:
+    std::atomic<std::size_t> in_flight_{0};
+    std::atomic<bool> canceling_{false};
+    std::mutex exception_mutex_;
+    std::exception_ptr exception_;
+
+    void wait_for_tasks() {
+        auto& ts = impl::task_system::get();
+        while (in_flight_) {
+            if (!ts.try_run_task()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+///////////////////////////////////////////////////////////////////////
+// algorithms
+///////////////////////////////////////////////////////////////////////
+struct parallel_for {
+    template <typename F>
+    static void apply(int left, int right, F f) {
+        if (right<=left) {
+            return;
+        }
+
+        // Split the range into a few blocks per thread so that work stealing
+        // can balance iterations of uneven cost.
+        const int n = right-left;
+        const int nblocks = std::min(n, 4*num_threads());
+        const int block_size = (n+nblocks-1)/nblocks;
+
+        task_group g;
+        for (int b=left; b<right; b+=block_size) {
+            auto e = std::min(right, b+block_size);
+            g.run([b, e, &f]() {
+                for (int i=b; i<e; ++i) {
+                    f(i);
+                }
+            });
+        }
+        g.wait();
+    }
+};
+
+namespace impl {
+    // ranges shorter than this are sorted serially
+    constexpr std::ptrdiff_t serial_sort_cutoff = 1<<14;
+
+    template <typename RandomIt, typename Compare>
+    void parallel_merge_sort(RandomIt begin, RandomIt end, Compare comp) {
+        if (std::distance(begin, end)<=serial_sort_cutoff) {
+            std::sort(begin, end, comp);
+            return;
+        }
+
+        auto mid = begin + std::distance(begin, end)/2;
+        task_group g;
+        g.run([&]() { parallel_merge_sort(begin, mid, comp); });
+        parallel_merge_sort(mid, end, comp);
+        g.wait();
+
+        std::inplace_merge(begin, mid, end, comp);
+    }
+} // namespace impl
+
+template <typename RandomIt>
+void sort(RandomIt begin, RandomIt end) {
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    impl::parallel_merge_sort(begin, end, std::less<value_type>());
+}
+
+template <typename RandomIt, typename Compare>
+void sort(RandomIt begin, RandomIt end, Compare comp) {
+    impl::parallel_merge_sort(begin, end, comp);
+}
+
+template <typename Container>
+void sort(Container& c) {
+    threading::sort(std::begin(c), std::end(c));
+}
+
+} // threading
+} // mc
+} // nest
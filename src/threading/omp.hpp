@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -57,9 +58,20 @@ public :
 struct parallel_for {
     template <typename F>
     static void apply(int left, int right, F f) {
-        #pragma omp parallel for
-        for(int i=left; i<right; ++i) {
-            f(i);
+        // Inside a parallel region, e.g. in a task of a task_group, a nested
+        // parallel for would run serially on the calling thread, so the
+        // iterations are shared among the threads of the team as tasks.
+        if (omp_in_parallel()) {
+            #pragma omp taskloop
+            for(int i=left; i<right; ++i) {
+                f(i);
+            }
+        }
+        else {
+            #pragma omp parallel for
+            for(int i=left; i<right; ++i) {
+                f(i);
+            }
         }
     }
 };
@@ -131,23 +143,39 @@ struct timer {
 
 constexpr bool multithreaded() { return true; }
 
+/// the number of threads available for parallel work
+inline int num_threads() { return omp_get_max_threads(); }
+
 
+/// Tasks are deferred until wait() is called, when they are run
+/// concurrently as OpenMP tasks, in a new parallel region if wait() is
+/// called from outside of one.
 class task_group {
 public:
     task_group() = default;
 
     template<typename Func>
     void run(const Func& f) {
-        f();
+        tasks_.push_back(f);
     }
 
     template<typename Func>
     void run_and_wait(const Func& f) {
-        f();
+        run(f);
+        wait();
     }
 
-    void wait()
-    {}
+    void wait() {
+        if (omp_in_parallel()) {
+            spawn_and_wait();
+        }
+        else {
+            #pragma omp parallel
+            #pragma omp master
+            spawn_and_wait();
+        }
+        tasks_.clear();
+    }
 
     bool is_canceling() {
         return false;
@@ -155,6 +183,18 @@ public:
 
     void cancel()
     {}
+
+private:
+    std::vector<std::function<void()>> tasks_;
+
+    void spawn_and_wait() {
+        for (auto& t: tasks_) {
+            auto f = &t;
+            #pragma omp task firstprivate(f)
+            (*f)();
+        }
+        #pragma omp taskwait
+    }
 };
 
 } // threading
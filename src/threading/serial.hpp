@@ -103,6 +103,9 @@ struct timer {
 
 constexpr bool multithreaded() { return false; }
 
+/// the number of threads available for parallel work
+inline int num_threads() { return 1; }
+
 /// Proxy for tbb task group.
 /// The tbb version launches tasks asynchronously, returning control to the
 /// caller. The serial version implemented here simply runs the task, before
@@ -46,6 +46,9 @@ struct timer {
 
 constexpr bool multithreaded() { return true; }
 
+/// the number of threads available for parallel work
+inline int num_threads() { return tbb::task_scheduler_init::default_num_threads(); }
+
 template <typename T>
 using parallel_vector = tbb::concurrent_vector<T>;
 
@@ -4,6 +4,8 @@
     #include "tbb.hpp"
 #elif defined(WITH_OMP)
     #include "omp.hpp"
+#elif defined(WITH_CTHREAD)
+    #include "cthread.hpp"
 #else
     #define WITH_SERIAL
     #include "serial.hpp"
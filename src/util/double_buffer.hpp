@@ -16,7 +16,7 @@ private:
     std::atomic<int> index_;
     std::array<T, 2> buffers_;
 
-    int other_index() {
+    int other_index() const {
         return index_ ? 0 : 1;
     }
 
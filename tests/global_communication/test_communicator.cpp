@@ -1,13 +1,17 @@
 #include "../gtest.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include <communication/communicator.hpp>
 #include <communication/global_policy.hpp>
+#include <util/span.hpp>
 
 using namespace nest::mc;
 
@@ -33,3 +37,74 @@ TEST(communicator, setup) {
     }
     */
 }
+
+// Compare the events generated by the communicator with those generated by a
+// brute force search over all connections.
+TEST(communicator, make_event_queues) {
+    using spike_type = communicator_type::spike_type;
+    using event_type = postsynaptic_spike_event<time_type>;
+
+    // 4 local groups of 5 cells each
+    std::vector<cell_gid_type> group_divs = {100, 105, 110, 115, 120};
+    communicator_type comm(util::partition_view(group_divs));
+
+    // Connections from a sparse set of source gids that straddle the local
+    // cells, with several sources per cell.
+    std::mt19937 gen;
+    std::uniform_int_distribution<cell_gid_type> src_gid(50, 500);
+    std::uniform_int_distribution<cell_lid_type> src_idx(0, 2);
+    std::uniform_int_distribution<cell_gid_type> dst_gid(100, 119);
+    std::uniform_int_distribution<cell_lid_type> dst_idx(0, 10);
+
+    std::vector<communicator_type::connection_type> cons;
+    for (auto i: util::make_span(0, 2000)) {
+        cons.push_back({
+            {src_gid(gen), src_idx(gen)},
+            {dst_gid(gen), dst_idx(gen)},
+            float(i), time_type(1)});
+        comm.add_connection(cons.back());
+    }
+    comm.construct();
+
+    // spikes from sources with and without connections, including ids
+    // outside the range of source gids; there are enough spikes for event
+    // generation to be split over threads if available
+    std::vector<spike_type> spikes;
+    for (auto rep: util::make_span(0u, 4u)) {
+        for (auto gid: util::make_span(0u, 600u)) {
+            for (auto idx: util::make_span(0u, 4u)) {
+                spikes.push_back({{gid, idx}, time_type(gid+rep)});
+            }
+        }
+    }
+    std::vector<unsigned> part = {0u, unsigned(spikes.size())};
+    gathered_vector<spike_type> global_spikes(std::move(spikes), std::move(part));
+
+    auto queues = comm.make_event_queues(global_spikes);
+    ASSERT_EQ(group_divs.size()-1, queues.size());
+
+    std::vector<std::vector<event_type>> expected(queues.size());
+    for (auto s: global_spikes.values()) {
+        for (auto c: cons) {
+            if (c.source()==s.source) {
+                auto gidx = (c.destination().gid-group_divs.front())/5;
+                expected[gidx].push_back(c.make_event(s));
+            }
+        }
+    }
+
+    auto event_less = [](const event_type& l, const event_type& r) {
+        return std::tie(l.time, l.target, l.weight)<std::tie(r.time, r.target, r.weight);
+    };
+    auto event_eq = [](const event_type& l, const event_type& r) {
+        return l.time==r.time && l.target==r.target && l.weight==r.weight;
+    };
+
+    for (auto i: util::make_span(0, queues.size())) {
+        std::sort(queues[i].begin(), queues[i].end(), event_less);
+        std::sort(expected[i].begin(), expected[i].end(), event_less);
+        EXPECT_EQ(expected[i].size(), queues[i].size());
+        EXPECT_TRUE(std::equal(
+            expected[i].begin(), expected[i].end(), queues[i].begin(), event_eq));
+    }
+}
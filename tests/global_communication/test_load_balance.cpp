@@ -0,0 +1,62 @@
+#include "../gtest.h"
+
+#include <vector>
+
+#include <common_types.hpp>
+#include <communication/global_policy.hpp>
+#include <load_balance.hpp>
+#include <recipe.hpp>
+
+#include "../test_common_cells.hpp"
+
+using namespace nest::mc;
+
+namespace {
+    // Recipe with cells of increasing size, so that the costs of the cells
+    // estimated on each domain are distinguishable.
+    class graded_recipe: public recipe {
+    public:
+        graded_recipe(cell_size_type n): ncells_(n) {}
+
+        cell_size_type num_cells() const override { return ncells_; }
+
+        cell get_cell(cell_gid_type gid) const override {
+            auto c = make_cell_ball_and_stick(false);
+            c.segment(1)->set_compartments(1+gid%7);
+            return c;
+        }
+
+        cell_count_info get_cell_count_info(cell_gid_type) const override {
+            return {1u, 0u, 0u};
+        }
+
+        std::vector<cell_connection> connections_on(cell_gid_type) const override {
+            return {};
+        }
+
+    private:
+        cell_size_type ncells_;
+    };
+}
+
+// Each domain estimates the costs of a share of the cells: the balance is
+// the same as if every domain had estimated the costs of all of the cells.
+TEST(load_balance, balance_cells) {
+    using policy = communication::global_policy;
+
+    const cell_size_type group_size = 3;
+    for (cell_size_type ncells: {0, 1, 5, 37}) {
+        graded_recipe rec(ncells);
+        auto lb = balance_cells<policy>(rec, group_size);
+
+        auto costs = estimate_cell_costs(rec, 0, ncells);
+        auto expected = balance_cells(costs, policy::size(), policy::id(), group_size);
+        EXPECT_EQ(expected.cell_range, lb.cell_range);
+        EXPECT_EQ(expected.group_divisions, lb.group_divisions);
+        EXPECT_EQ(expected.group_costs, lb.group_costs);
+
+        // the domains cover the cells
+        int n = lb.cell_range.second-lb.cell_range.first;
+        EXPECT_EQ(int(ncells), policy::sum(n));
+    }
+}
@@ -97,4 +97,35 @@ TEST(mpi, gather_all_with_partition) {
     EXPECT_EQ(expected_divisions, gathered.partition());
 }
 
+TEST(mpi, all_to_all_with_partition) {
+    using policy = mpi_global_policy;
+
+    int id = policy::id();
+    int size = policy::size();
+
+    // rank i sends i+j copies of big_thing(100*i+j) to rank j
+    std::vector<big_thing> data;
+    std::vector<int> divisions = {0};
+    for (int j = 0; j<size; ++j) {
+        for (int k = 0; k<id+j; ++k) {
+            data.push_back(100*id+j);
+        }
+        divisions.push_back(data.size());
+    }
+
+    std::vector<big_thing> expected_values;
+    std::vector<unsigned> expected_divisions = {0};
+    for (int i = 0; i<size; ++i) {
+        for (int k = 0; k<i+id; ++k) {
+            expected_values.push_back(100*i+id);
+        }
+        expected_divisions.push_back(expected_values.size());
+    }
+
+    auto received = mpi::all_to_all_with_partition(data, divisions);
+
+    EXPECT_EQ(expected_values, received.values());
+    EXPECT_EQ(expected_divisions, received.partition());
+}
+
 #endif // WITH_MPI
@@ -0,0 +1,147 @@
+#ifdef WITH_MPI
+
+#include "../gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <communication/communicator.hpp>
+#include <communication/mpi_global_policy.hpp>
+#include <communication/mpi_sparse_global_policy.hpp>
+#include <communication/packed_global_policy.hpp>
+#include <util/span.hpp>
+
+using namespace nest::mc;
+using namespace nest::mc::communication;
+
+using time_type = float;
+using event_type = postsynaptic_spike_event<time_type>;
+
+namespace {
+    // Build a communicator on each rank for a network with ncells_per_rank
+    // cells per rank in groups of 2, where each cell has targets connected
+    // to sources on the same or neighbouring ranks.
+    template <typename Policy>
+    communicator<time_type, Policy> make_communicator(
+        std::vector<cell_gid_type>& divisions, cell_gid_type ncells_per_rank)
+    {
+        auto id = Policy::id();
+        auto size = Policy::size();
+        auto first = id*ncells_per_rank;
+
+        divisions.clear();
+        for (auto i: util::make_span(0u, ncells_per_rank/2+1)) {
+            divisions.push_back(first+2*i);
+        }
+
+        communicator<time_type, Policy> comm(util::partition_view(divisions));
+
+        // the same connections are generated for each policy
+        std::mt19937 gen(id);
+        std::uniform_int_distribution<int> rank_dist(-1, 1);
+        std::uniform_int_distribution<cell_gid_type> cell_dist(0, ncells_per_rank-1);
+        for (auto gid: util::make_span(first, first+ncells_per_rank)) {
+            for (auto i: util::make_span(0u, 5u)) {
+                auto src_rank = (id+size+rank_dist(gen))%size;
+                cell_gid_type src = src_rank*ncells_per_rank+cell_dist(gen);
+                comm.add_connection({{src, 0u}, {gid, i}, float(i), time_type(1)});
+            }
+        }
+        comm.construct();
+
+        return comm;
+    }
+
+    void sort_events(std::vector<std::vector<event_type>>& queues) {
+        for (auto& q: queues) {
+            std::sort(q.begin(), q.end(),
+                [](const event_type& l, const event_type& r) {
+                    return std::tie(l.time, l.target, l.weight)<std::tie(r.time, r.target, r.weight);
+                });
+        }
+    }
+}
+
+// The sparse exchange must generate the same events as gathering all spikes.
+TEST(sparse_exchange, events) {
+    using spike_type = spike<cell_member_type, time_type>;
+    const cell_gid_type ncells_per_rank = 20;
+
+    std::vector<cell_gid_type> dense_divs, sparse_divs;
+    auto dense = make_communicator<mpi_global_policy>(dense_divs, ncells_per_rank);
+    auto sparse = make_communicator<mpi_sparse_global_policy>(sparse_divs, ncells_per_rank);
+
+    // every third local cell spikes
+    std::vector<spike_type> local_spikes;
+    auto first = mpi_global_policy::id()*ncells_per_rank;
+    for (auto gid: util::make_span(first, first+ncells_per_rank)) {
+        if (gid%3==0) {
+            local_spikes.push_back({{gid, 0u}, time_type(gid)});
+        }
+    }
+
+    auto dense_events = dense.make_event_queues(dense.exchange(local_spikes));
+    auto sparse_events = sparse.make_event_queues(sparse.exchange(local_spikes));
+    sort_events(dense_events);
+    sort_events(sparse_events);
+
+    ASSERT_EQ(dense_events.size(), sparse_events.size());
+    for (auto i: util::make_span(0, dense_events.size())) {
+        ASSERT_EQ(dense_events[i].size(), sparse_events[i].size());
+        for (auto j: util::make_span(0, dense_events[i].size())) {
+            EXPECT_EQ(dense_events[i][j].target, sparse_events[i][j].target);
+            EXPECT_EQ(dense_events[i][j].time, sparse_events[i][j].time);
+            EXPECT_EQ(dense_events[i][j].weight, sparse_events[i][j].weight);
+        }
+    }
+
+    // both count the global number of spikes
+    EXPECT_EQ(dense.num_spikes(), sparse.num_spikes());
+
+    // spikes are only sent to neighbouring ranks, at most two others
+    auto bytes_sent = sparse.communication_policy().bytes_sent();
+    EXPECT_LE(bytes_sent, 2*sizeof(spike_type)*local_spikes.size());
+}
+
+// Packed spikes exchanged with the sparse policy generate the same events as
+// gathering all spikes, in fewer bytes than the spike structs.
+TEST(sparse_exchange, packed) {
+    using spike_type = spike<cell_member_type, time_type>;
+    using packed_policy = packed_global_policy<mpi_sparse_global_policy>;
+    const cell_gid_type ncells_per_rank = 20;
+
+    std::vector<cell_gid_type> dense_divs, packed_divs;
+    auto dense = make_communicator<mpi_global_policy>(dense_divs, ncells_per_rank);
+    auto packed = make_communicator<packed_policy>(packed_divs, ncells_per_rank);
+
+    std::vector<spike_type> local_spikes;
+    auto first = mpi_global_policy::id()*ncells_per_rank;
+    for (auto gid: util::make_span(first, first+ncells_per_rank)) {
+        if (gid%3==0) {
+            local_spikes.push_back({{gid, 0u}, time_type(gid)});
+        }
+    }
+
+    auto dense_events = dense.make_event_queues(dense.exchange(local_spikes));
+    auto packed_events = packed.make_event_queues(packed.exchange(local_spikes));
+    sort_events(dense_events);
+    sort_events(packed_events);
+
+    ASSERT_EQ(dense_events.size(), packed_events.size());
+    for (auto i: util::make_span(0, dense_events.size())) {
+        ASSERT_EQ(dense_events[i].size(), packed_events[i].size());
+        for (auto j: util::make_span(0, dense_events[i].size())) {
+            EXPECT_EQ(dense_events[i][j].target, packed_events[i][j].target);
+            EXPECT_EQ(dense_events[i][j].time, packed_events[i][j].time);
+            EXPECT_EQ(dense_events[i][j].weight, packed_events[i][j].weight);
+        }
+    }
+    EXPECT_EQ(dense.num_spikes(), packed.num_spikes());
+
+    auto bytes_sent = packed.communication_policy().bytes_sent();
+    EXPECT_LT(bytes_sent, 2*sizeof(spike_type)*local_spikes.size());
+}
+
+#endif // WITH_MPI
@@ -1,3 +1,6 @@
+#include <map>
+#include <string>
+
 #include "test.hpp"
 #include "module.hpp"
 
@@ -14,3 +17,174 @@ TEST(Module, open) {
         EXPECT_NE(t.type, tok::reserved);
     }
 }
+
+static const char* kinetic_module =
+    "NEURON {                                \n"
+    "    SUFFIX markov                       \n"
+    "    NONSPECIFIC_CURRENT i               \n"
+    "}                                       \n"
+    "PARAMETER {                             \n"
+    "    gbar = 0.001                        \n"
+    "}                                       \n"
+    "STATE {                                 \n"
+    "    c1 c2 o                             \n"
+    "}                                       \n"
+    "ASSIGNED {                              \n"
+    "    v                                   \n"
+    "}                                       \n"
+    "BREAKPOINT {                            \n"
+    "    SOLVE kin METHOD %                  \n"
+    "    i = gbar*o*v                        \n"
+    "}                                       \n"
+    "INITIAL {                               \n"
+    "    c1 = 1                              \n"
+    "    c2 = 0                              \n"
+    "    o = 0                               \n"
+    "}                                       \n"
+    "KINETIC kin {                           \n"
+    "    LOCAL a                             \n"
+    "    a = exp(v)                          \n"
+    "    ~ % (a, 2*a)                        \n"
+    "    ~ c2 <-> o (3*a, 4)                 \n"
+    "    CONSERVE c1 + c2 + o = 1            \n"
+    "}                                       \n";
+
+static std::string kinetic_text(const char* method, const char* reaction) {
+    return pprintf(kinetic_module, method, reaction);
+}
+
+// parse the module and perform semantic analysis, returning true on success
+static bool kinetic_semantic(const char* method, const char* reaction) {
+    auto text = kinetic_text(method, reaction);
+    Module m(text.c_str(), text.size());
+    Parser p(m, false);
+    return p.parse() && m.semantic();
+}
+
+TEST(Module, kinetic_sparse) {
+    auto text = kinetic_text("sparse", "c1 <-> c2");
+    Module m(text.c_str(), text.size());
+    Parser p(m, false);
+    ASSERT_TRUE(p.parse());
+    ASSERT_TRUE(m.semantic());
+
+    auto state = m.symbols()["nrn_state"]->is_api_method();
+    ASSERT_NE(nullptr, state);
+
+    // the chain c1 <-> c2 <-> o is tridiagonal, so the elimination updates
+    // c2 and o, and the back substitution updates all of the species
+    std::map<std::string, int> updates;
+    for(auto& s: state->body()->statements()) {
+        if(auto a = s->is_assignment()) {
+            ++updates[a->lhs()->is_identifier()->spelling()];
+        }
+    }
+    EXPECT_EQ(1, updates["c1"]);
+    EXPECT_EQ(2, updates["c2"]);
+    EXPECT_EQ(2, updates["o"]);
+
+    // no fill in
+    EXPECT_EQ(0u, updates.count("j_0_2_"));
+    EXPECT_EQ(0u, updates.count("j_2_0_"));
+}
+
+TEST(Module, kinetic_errors) {
+    // KINETIC blocks can only be solved with METHOD sparse
+    EXPECT_FALSE(kinetic_semantic("cnexp", "c1 <-> c2"));
+
+    // only first order reactions can be solved
+    EXPECT_FALSE(kinetic_semantic("sparse", "2c1 <-> c2"));
+    EXPECT_FALSE(kinetic_semantic("sparse", "c1 + o <-> c2"));
+
+    // the species must be state variables
+    EXPECT_FALSE(kinetic_semantic("sparse", "c1 <-> a"));
+}
+
+static const char* table_module =
+    "NEURON {                                \n"
+    "    SUFFIX tab                          \n"
+    "    NONSPECIFIC_CURRENT i               \n"
+    "    RANGE gbar                          \n"
+    "}                                       \n"
+    "PARAMETER {                             \n"
+    "    gbar = 0.001                        \n"
+    "    celsius = 6.3                       \n"
+    "}                                       \n"
+    "STATE {                                 \n"
+    "    m                                   \n"
+    "}                                       \n"
+    "ASSIGNED {                              \n"
+    "    v                                   \n"
+    "    minf                                \n"
+    "    mtau                                \n"
+    "}                                       \n"
+    "BREAKPOINT {                            \n"
+    "    SOLVE states METHOD cnexp           \n"
+    "    i = gbar*m*v                        \n"
+    "}                                       \n"
+    "INITIAL {                               \n"
+    "    rates(%)                            \n"
+    "    m = minf                            \n"
+    "}                                       \n"
+    "DERIVATIVE states {                     \n"
+    "    rates(%)                            \n"
+    "    m' = (minf-m)/mtau                  \n"
+    "}                                       \n"
+    "PROCEDURE rates(%) {                    \n"
+    "    LOCAL q10                           \n"
+    "    %                                   \n"
+    "    q10 = 3^((celsius-6.3)/10)          \n"
+    "    minf = 1/(1+exp(-v))                \n"
+    "    mtau = %/q10                        \n"
+    "}                                       \n";
+
+// parse the module and perform semantic analysis, returning true on success
+static bool table_semantic(
+    const char* table, const char* tau, const char* args="v", const char* call_args="v")
+{
+    auto text = pprintf(table_module, call_args, call_args, args, table, tau);
+    Module m(text.c_str(), text.size());
+    Parser p(m, false);
+    return p.parse() && m.semantic();
+}
+
+TEST(Module, table) {
+    const char* table = "TABLE minf, mtau DEPEND celsius FROM -100 TO 100 WITH 200";
+    auto text = pprintf(table_module, "v", "v", "v", table, "1");
+    Module m(text.c_str(), text.size());
+    Parser p(m, false);
+    ASSERT_TRUE(p.parse());
+    ASSERT_TRUE(m.semantic());
+
+    // the TABLE statement is moved out of the body of the procedure
+    auto rates = m.symbols()["rates"]->is_procedure();
+    ASSERT_NE(nullptr, rates);
+    ASSERT_NE(nullptr, rates->table());
+    EXPECT_EQ(2u, rates->table()->outputs().size());
+    for(auto& s: rates->body()->statements()) {
+        EXPECT_EQ(nullptr, s->is_table_statement());
+    }
+}
+
+TEST(Module, table_errors) {
+    const char* table = "TABLE minf, mtau DEPEND celsius FROM -100 TO 100 WITH 200";
+
+    // the procedure must have one argument
+    EXPECT_FALSE(table_semantic(table, "1", "v, w", "v, 1"));
+
+    // the outputs can't depend on variables that differ between instances
+    EXPECT_FALSE(table_semantic(table, "gbar"));
+    EXPECT_FALSE(table_semantic(table, "m"));
+
+    // parameters must be listed as DEPEND variables
+    EXPECT_FALSE(table_semantic("TABLE minf, mtau FROM -100 TO 100 WITH 200", "1"));
+
+    // the outputs must be ASSIGNED variables
+    EXPECT_FALSE(table_semantic(
+        "TABLE minf, mtau, celsius DEPEND celsius FROM -100 TO 100 WITH 200", "1"));
+
+    // a procedure can have only one TABLE
+    EXPECT_FALSE(table_semantic(
+        "TABLE minf DEPEND celsius FROM -100 TO 100 WITH 200\n"
+        "TABLE mtau DEPEND celsius FROM -100 TO 100 WITH 200", "1"));
+}
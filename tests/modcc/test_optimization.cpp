@@ -1,9 +1,14 @@
 #include <cmath>
+#include <cstring>
 
 #include "test.hpp"
 
 #include "constantfolder.hpp"
 #include "modccutil.hpp"
+#include "module.hpp"
+#include "simplifier.hpp"
+
+#include "expr_expand.hpp"
 
 TEST(Optimizer, constant_folding) {
     auto v = make_unique<ConstantFolderVisitor>();
@@ -78,3 +83,123 @@ TEST(Optimizer, constant_folding) {
         VERBOSE_PRINT("");;
     }
 }
+
+static const char* procedure_with_redundancy =
+    "PROCEDURE p(x) {                   \n"
+    "    LOCAL a, b, c                  \n"
+    "    a = exp(-(x+y)/4)              \n"
+    "    b = 2*exp(-(x+y)/8) + (x+y)/a  \n"
+    "    y = a*b                        \n"
+    "    c = exp(-(x+y)/4) + a/b        \n"
+    "    y = c                          \n"
+    "}                                  \n";
+
+// parse p into globals, with y a global variable
+static ProcedureExpression* parse_procedure_p(scope_type::symbol_map& globals) {
+    auto p = Parser(procedure_with_redundancy).parse_procedure();
+    auto proc = p->is_symbol()->is_procedure();
+    globals["p"] = std::move(p);
+    globals["y"] = make_symbol<VariableExpression>(Location(), "y");
+    proc->semantic(globals);
+    return proc;
+}
+
+static int count_ops(Expression* e, tok op) {
+    int n = 0;
+    if(auto b = e->is_binary()) {
+        n += (b->op()==op) + count_ops(b->lhs(), op) + count_ops(b->rhs(), op);
+    }
+    else if(auto u = e->is_unary()) {
+        n += (u->op()==op) + count_ops(u->expression(), op);
+    }
+    return n;
+}
+
+static int count_ops(BlockExpression* body, tok op) {
+    int n = 0;
+    for(auto& s : body->statements()) {
+        n += count_ops(s.get(), op);
+    }
+    return n;
+}
+
+TEST(Optimizer, strength_reduction) {
+    scope_type::symbol_map globals;
+    auto p = parse_procedure_p(globals);
+    auto body = p->body();
+    auto before = expand_assignments(body->statements());
+
+    // divisions by variables are left as they are
+    EXPECT_EQ(3, reduce_strength(body));
+    EXPECT_EQ(2, count_ops(body, tok::divide));
+    VERBOSE_PRINT( p->to_string() );
+
+    // the divisors are powers of two, so the results are exact
+    auto after = expand_assignments(body->statements());
+    for(auto var : {"a", "b", "c", "y"}) {
+        EXPECT_EQ(before[var], after[var]);
+    }
+}
+
+TEST(Optimizer, common_subexpression_elimination) {
+    scope_type::symbol_map globals;
+    auto p = parse_procedure_p(globals);
+    auto body = p->body();
+    auto before = expand_assignments(body->statements());
+
+    // -(x+y) in the assignments to a and b, then the x+y in it and in b,
+    // which can't be reused in c after y has been assigned to
+    EXPECT_EQ(6, count_ops(body, tok::plus));
+    EXPECT_EQ(3, count_ops(body, tok::minus));
+    EXPECT_EQ(2, eliminate_common_subexpressions(body));
+    EXPECT_EQ(4, count_ops(body, tok::plus));
+    EXPECT_EQ(2, count_ops(body, tok::minus));
+    VERBOSE_PRINT( p->to_string() );
+
+    auto after = expand_assignments(body->statements());
+    for(auto var : {"a", "b", "c", "y"}) {
+        EXPECT_EQ(before[var], after[var]);
+    }
+
+    // nothing left to eliminate
+    EXPECT_EQ(0, eliminate_common_subexpressions(body));
+}
+
+static const char* divisions_module =
+    "NEURON {                                \n"
+    "    SUFFIX divisions                    \n"
+    "    NONSPECIFIC_CURRENT i               \n"
+    "}                                       \n"
+    "ASSIGNED {                              \n"
+    "    v                                   \n"
+    "}                                       \n"
+    "BREAKPOINT {                            \n"
+    "    rates(v)                            \n"
+    "    i = v                               \n"
+    "}                                       \n"
+    "INITIAL {                               \n"
+    "}                                       \n"
+    "PROCEDURE rates(u) {                    \n"
+    "    LOCAL a, b                          \n"
+    "    a = u/3                             \n"
+    "    b = u/3 + 1                         \n"
+    "}                                       \n";
+
+// the number of divisions in the rates procedure after simplification
+static int simplified_divisions(bool strength_reduction) {
+    Module m(divisions_module, std::strlen(divisions_module));
+    Parser p(m, false);
+    EXPECT_TRUE(p.parse());
+    EXPECT_TRUE(m.semantic());
+    m.simplify(strength_reduction);
+    return count_ops(m.symbols()["rates"]->is_procedure()->body(), tok::divide);
+}
+
+TEST(Optimizer, simplify_module) {
+    // by default only the common subexpression u/3 is eliminated, which
+    // does not change the results
+    EXPECT_EQ(1, simplified_divisions(false));
+
+    // strength reduction replaces the division by a multiplication
+    EXPECT_EQ(0, simplified_divisions(true));
+}
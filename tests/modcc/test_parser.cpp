@@ -173,6 +173,42 @@ TEST(Parser, parse_conductance) {
     }
 }
 
+TEST(Parser, parse_table) {
+    std::unique_ptr<TableExpression> s;
+
+    EXPECT_TRUE(check_parse(s, &Parser::parse_table,
+        "TABLE minf, mtau DEPEND celsius FROM -100 TO 100 WITH 200"));
+    if (s) {
+        EXPECT_EQ(s->outputs(), (std::vector<std::string>{"minf", "mtau"}));
+        EXPECT_EQ(s->depends(), (std::vector<std::string>{"celsius"}));
+        EXPECT_EQ(s->from(), -100);
+        EXPECT_EQ(s->to(), 100);
+        EXPECT_EQ(s->n(), 200);
+    }
+
+    EXPECT_TRUE(check_parse(s, &Parser::parse_table, "TABLE ninf FROM 0 TO 1.5 WITH 3"));
+    if (s) {
+        EXPECT_EQ(s->outputs(), (std::vector<std::string>{"ninf"}));
+        EXPECT_TRUE(s->depends().empty());
+        EXPECT_EQ(s->from(), 0);
+        EXPECT_EQ(s->to(), 1.5);
+        EXPECT_EQ(s->n(), 3);
+    }
+
+    const char* bad_tables[] = {
+        "TABLE FROM 0 TO 1 WITH 10",
+        "TABLE minf, FROM 0 TO 1 WITH 10",
+        "TABLE minf DEPEND FROM 0 TO 1 WITH 10",
+        "TABLE minf FROM 0 WITH 10",
+        "TABLE minf FROM 0 TO 1 WITH 2.5",
+        "TABLE minf FROM 1 TO 0 WITH 10",
+        "TABLE minf FROM 0 TO 1 WITH 0"
+    };
+    for (auto text: bad_tables) {
+        EXPECT_TRUE(check_parse_fail(&Parser::parse_table, text));
+    }
+}
+
 TEST(Parser, parse_if) {
     std::unique_ptr<IfExpression> s;
 
@@ -0,0 +1,123 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <backends/fvm_multicore.hpp>
+#include <matrix.hpp>
+#include <profiling/profiler.hpp>
+#include <threading/threading.hpp>
+#include <util/span.hpp>
+
+using namespace nest::mc;
+
+using backend = multicore::backend;
+using matrix_type = matrix<backend>;
+using value_type = backend::value_type;
+using size_type = backend::size_type;
+using timer = util::timer_type;
+
+// Parent index of a cell with about ncomp compartments, made of unbranched
+// cables of branch_length compartments, where each cable has two children
+// with probability one half, so that the dendritic tree is irregular.
+std::vector<size_type> make_parent_index(size_type ncomp, size_type branch_length, std::mt19937& gen) {
+    std::bernoulli_distribution branch(0.5);
+
+    std::vector<size_type> p = {0};
+    std::vector<size_type> tips = {0};
+    for (std::size_t t=0; t<tips.size() && p.size()<ncomp; ++t) {
+        auto nchild = t==0 || branch(gen)? 2: 0;
+        if (t+1==tips.size()) {
+            // keep growing the tree
+            nchild = 2;
+        }
+        for (auto c=0; c<nchild; ++c) {
+            size_type parent = tips[t];
+            for (auto i: util::make_span(0u, branch_length)) {
+                (void)i;
+                p.push_back(parent);
+                parent = p.size()-1;
+            }
+            tips.push_back(parent);
+        }
+    }
+    return p;
+}
+
+int main(int argc, char** argv) {
+    int ncomp = argc>1? std::atoi(argv[1]): 100000;
+    int branch_length = argc>2? std::atoi(argv[2]): 20;
+    if (ncomp<1 || branch_length<1) {
+        std::cout << "branch_solver [ncomp [branch_length]]\n"
+                  << "   Compare the time per step of the serial and branch parallel matrix\n"
+                  << "   assembly and solve of one cell of about ncomp (default 10^5)\n"
+                  << "   compartments, in a tree of branches of branch_length (default 20)\n"
+                  << "   compartments. Run with different numbers of threads to measure the\n"
+                  << "   scaling, e.g. with the NMC_NUM_THREADS or OMP_NUM_THREADS variables.\n";
+        return 1;
+    }
+
+    const value_type dt = 0.025;
+    const unsigned steps = 50;
+
+    std::mt19937 gen(42);
+    auto p = make_parent_index(ncomp, branch_length, gen);
+    std::vector<size_type> ci = {0, size_type(p.size())};
+    auto n = p.size();
+
+    std::uniform_real_distribution<value_type> u(0, 1);
+    backend::array cv_capacitance(n), face_conductance(n), current(n);
+    for (auto i: util::make_span(0u, n)) {
+        cv_capacitance[i] = 0.5+u(gen);
+        face_conductance[i] = 1+u(gen);
+        current[i] = 0.01*(u(gen)-0.5);
+    }
+
+    auto run = [&](bool decompose, backend::array& voltage) {
+        matrix_type m(p, ci);
+        backend::matrix_assembler assembler(
+            m.d(), m.u(), m.rhs(), m.p(), m.cell_index(),
+            cv_capacitance, face_conductance, voltage, current);
+        if (decompose) {
+            assembler.decompose_cells(0);
+        }
+
+        auto start = timer::tic();
+        for (unsigned i=0; i<steps; ++i) {
+            assembler.assemble_and_solve(dt, voltage);
+        }
+        return timer::toc(start)/steps;
+    };
+
+    backend::array v_serial(n, -65.), v_parallel(n, -65.);
+    auto t_serial = run(false, v_serial);
+    auto t_parallel = run(true, v_parallel);
+
+    value_type max_diff = 0;
+    for (auto i: util::make_span(0u, n)) {
+        max_diff = std::max(max_diff, std::fabs(v_serial[i]-v_parallel[i]));
+    }
+    if (max_diff>1e-9) {
+        std::cerr << "error: branch parallel solution differs by " << max_diff << " mV\n";
+        return 2;
+    }
+
+    auto dec = multicore::make_branch_decomposition(
+        p.data(), size_type(0), size_type(n),
+        std::max(size_type(backend::matrix_assembler::min_subtree_size),
+                 size_type(n/(4*threading::num_threads()))));
+
+    std::cout << "compartments " << n
+              << ", threads " << threading::num_threads()
+              << " (" << threading::description() << ")"
+              << ", sub-trees " << dec.num_subtrees()
+              << ", reduced system " << dec.reduced_nodes.size() << "\n";
+    std::cout << std::setw(16) << "solver" << std::setw(16) << "ms/step" << "\n";
+    std::cout << std::setw(16) << "serial" << std::setw(16) << t_serial*1e3 << "\n";
+    std::cout << std::setw(16) << "branch parallel" << std::setw(16) << t_parallel*1e3 << "\n";
+    std::cout << "speedup " << t_serial/t_parallel << "\n";
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <common_types.hpp>
+#include <communication/communicator.hpp>
+#include <communication/global_policy.hpp>
+#include <profiling/profiler.hpp>
+#include <util/partition.hpp>
+#include <util/span.hpp>
+
+using namespace nest::mc;
+
+using time_type = float;
+using communicator_type = communication::communicator<time_type, communication::global_policy>;
+using spike_type = communicator_type::spike_type;
+using event_list = communicator_type::event_queue;
+using timer = util::timer_type;
+
+// Reference implementation: the binary search over all connections for each
+// spike that was used before the source index was added to the communicator.
+std::vector<event_list> reference_event_queues(
+    std::vector<communicator_type::connection_type>& connections,
+    const std::vector<cell_gid_type>& group_divisions,
+    const gathered_vector<spike_type>& global_spikes)
+{
+    auto groups = util::partition_view(group_divisions);
+    std::vector<event_list> queues(groups.size());
+    for (auto spike: global_spikes.values()) {
+        auto targets = std::equal_range(connections.begin(), connections.end(), spike.source);
+        for (auto it=targets.first; it!=targets.second; ++it) {
+            auto gidx = groups.index(it->destination().gid);
+            queues[gidx].push_back(it->make_event(spike));
+        }
+    }
+    return queues;
+}
+
+int main(int argc, char** argv) {
+    communication::global_policy_guard global_guard(argc, argv);
+
+    if (argc>1 && std::atof(argv[1])<1e6) {
+        std::cout << "communicator [max_connections]\n"
+                  << "   Compare event generation with binary search and the source index\n"
+                  << "   for 10^6 up to max_connections (default 10^8) connections per rank.\n";
+        return 1;
+    }
+    double max_connections = argc>1? std::atof(argv[1]): 1e8;
+
+    // Network parameters: each local cell has fan-in of 1000 connections
+    // from a global population of 100 times as many cells as there are
+    // local cells; 1% of the global cells spike in each exchange.
+    const unsigned fan_in = 1000;
+    const unsigned group_size = 100;
+    const double spike_fraction = 0.01;
+
+    std::cout << std::setw(14) << "connections"
+              << std::setw(12) << "spikes"
+              << std::setw(14) << "build (s)"
+              << std::setw(16) << "search (ns/sp)"
+              << std::setw(16) << "index (ns/sp)"
+              << std::setw(10) << "speedup" << "\n";
+
+    std::mt19937 gen(42);
+    for (double n=1e6; n<=max_connections; n*=10) {
+        auto num_local = cell_gid_type(n/fan_in);
+        auto num_global = 100*num_local;
+
+        std::vector<cell_gid_type> group_divisions;
+        for (cell_gid_type i=0; i<num_local; i+=group_size) {
+            group_divisions.push_back(i);
+        }
+        group_divisions.push_back(num_local);
+
+        communicator_type comm(util::partition_view(group_divisions));
+        std::uniform_int_distribution<cell_gid_type> src_dist(0, num_global-1);
+        std::uniform_real_distribution<float> weight_dist(0, 1);
+        for (auto gid: util::make_span(0u, num_local)) {
+            for (auto i: util::make_span(0u, fan_in)) {
+                comm.add_connection({
+                    {src_dist(gen), 0u}, {gid, cell_lid_type(i)},
+                    weight_dist(gen), time_type(10)});
+            }
+        }
+
+        auto start = timer::tic();
+        comm.construct();
+        auto t_build = timer::toc(start);
+
+        std::vector<spike_type> spikes;
+        std::uniform_real_distribution<time_type> time_dist(0, 10);
+        for (auto gid: util::make_span(0u, num_global)) {
+            if (weight_dist(gen)<spike_fraction) {
+                spikes.push_back({{gid, 0u}, time_dist(gen)});
+            }
+        }
+        auto num_spikes = spikes.size();
+        std::vector<unsigned> part = {0u, unsigned(num_spikes)};
+        gathered_vector<spike_type> global_spikes(std::move(spikes), std::move(part));
+
+        auto connections = comm.connections();
+        start = timer::tic();
+        auto expected = reference_event_queues(connections, group_divisions, global_spikes);
+        auto t_search = timer::toc(start);
+
+        start = timer::tic();
+        auto queues = comm.make_event_queues(global_spikes);
+        auto t_index = timer::toc(start);
+
+        for (auto i: util::make_span(0, queues.size())) {
+            if (queues[i].size()!=expected[i].size()) {
+                std::cerr << "error: different number of events generated for group " << i << "\n";
+                return 2;
+            }
+        }
+
+        std::cout << std::setw(14) << std::size_t(n)
+                  << std::setw(12) << num_spikes
+                  << std::setw(14) << t_build
+                  << std::setw(16) << t_search/num_spikes*1e9
+                  << std::setw(16) << t_index/num_spikes*1e9
+                  << std::setw(10) << t_search/t_index << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cell.hpp>
+#include <fvm_multicell.hpp>
+#include <profiling/profiler.hpp>
+#include <swcio.hpp>
+#include <util/span.hpp>
+
+using namespace nest::mc;
+
+using fvm_cell = fvm::fvm_multicell<multicore::backend>;
+using timer = util::timer_type;
+
+// Set associative cache with LRU replacement, used to count the misses of
+// the memory accesses made in a time step, because hardware counters are
+// not available on every platform.
+class cache_model {
+public:
+    cache_model(std::size_t size, unsigned ways, unsigned line=64):
+        ways_(ways), line_(line), sets_(size/(line*ways)),
+        tags_(sets_*ways, -1), stamps_(sets_*ways, 0)
+    {}
+
+    // returns true on a hit
+    bool access(std::uintptr_t addr) {
+        auto line = std::int64_t(addr/line_);
+        auto set = std::size_t(line)%sets_;
+        auto b = set*ways_;
+
+        ++clock_;
+        auto lru = b;
+        for (auto i=b; i<b+ways_; ++i) {
+            if (tags_[i]==line) {
+                stamps_[i] = clock_;
+                return true;
+            }
+            if (stamps_[i]<stamps_[lru]) {
+                lru = i;
+            }
+        }
+        tags_[lru] = line;
+        stamps_[lru] = clock_;
+        ++misses_;
+        return false;
+    }
+
+    std::uint64_t misses() const { return misses_; }
+    void reset_count() { misses_ = 0; }
+
+private:
+    std::size_t ways_, line_, sets_;
+    std::vector<std::int64_t> tags_;
+    std::vector<std::uint64_t> stamps_;
+    std::uint64_t clock_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+// Two level cache: a 32 KiB 8 way L1, and a 1 MiB 16 way L2.
+struct memory_model {
+    cache_model l1{32*1024, 8};
+    cache_model l2{1024*1024, 16};
+    std::uint64_t accesses = 0;
+
+    template <typename T>
+    void access(const T* p) {
+        ++accesses;
+        if (!l1.access(std::uintptr_t(p))) {
+            l2.access(std::uintptr_t(p));
+        }
+    }
+
+    void reset_count() {
+        accesses = 0;
+        l1.reset_count();
+        l2.reset_count();
+    }
+};
+
+// Replay the accesses made in one time step to compartment indexed data:
+// the loads and stores of voltage and current through the node index of each
+// mechanism, and the loads and stores of the Hines solve.
+void replay_step(fvm_cell& fvcell, memory_model& mem) {
+    auto v = fvcell.voltage().data();
+    auto c = fvcell.current().data();
+    for (auto& m: fvcell.mechanisms()) {
+        auto ni = m->node_index();
+        for (auto i: util::make_span(0u, ni.size())) {
+            mem.access(&ni[i]);
+            mem.access(v+ni[i]);
+            mem.access(c+ni[i]);
+        }
+    }
+
+    const auto& J = fvcell.jacobian();
+    auto d = J.d().data();
+    auto u = J.u().data();
+    auto rhs = J.rhs().data();
+    auto p = J.p().data();
+    auto ci = J.cell_index();
+    for (auto m: util::make_span(0u, J.num_cells())) {
+        for (auto i=ci[m+1]-1; i>ci[m]; --i) {
+            mem.access(u+i); mem.access(d+i); mem.access(rhs+i); mem.access(p+i);
+            mem.access(d+p[i]); mem.access(rhs+p[i]);
+        }
+        for (auto i=ci[m]+1; i<ci[m+1]; ++i) {
+            mem.access(rhs+i); mem.access(u+i); mem.access(p+i);
+            mem.access(rhs+p[i]); mem.access(d+i);
+        }
+    }
+}
+
+// A copy of cell c with the segments numbered breadth first, as if the cell
+// had been read from a morphology file that was not sorted depth first.
+cell breadth_first_copy(const cell& c) {
+    const auto& parents = c.segment_parents();
+    auto nseg = c.num_segments();
+
+    std::vector<cell_lid_type> order = {0};
+    std::vector<cell_lid_type> index(nseg, 0);
+    for (std::size_t i=0; i<order.size(); ++i) {
+        for (auto j: util::make_span(1u, nseg)) {
+            if (parents[j]==order[i]) {
+                index[j] = order.size();
+                order.push_back(j);
+            }
+        }
+    }
+
+    cell copy;
+    copy.add_soma(c.soma()->radius(), c.soma()->center());
+    for (auto j: util::make_span(1u, nseg)) {
+        auto seg = order[j];
+        copy.add_cable(index[parents[seg]], c.segment(seg)->clone());
+    }
+    return copy;
+}
+
+// Add compartments of length about comp_length, mechanisms, synapses and
+// a detector to a cell read from a morphology file.
+void add_model(cell& c, double comp_length) {
+    // hh on the soma and axon, passive dendrites
+    for (auto& seg: c.segments()) {
+        if (auto cable = seg->as_cable()) {
+            cable->set_compartments(std::max(1., std::round(cable->length()/comp_length)));
+        }
+        if (seg->is_soma() || seg->is_axon()) {
+            seg->add_mechanism(hh_parameters());
+        }
+        else {
+            seg->add_mechanism(pas_parameters());
+        }
+    }
+
+    // synapses at random locations
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<cell_lid_type> seg_dist(1, c.num_segments()-1);
+    std::uniform_real_distribution<double> pos_dist(0, 1);
+    for (unsigned i=0; i<100; ++i) {
+        c.add_synapse({seg_dist(gen), pos_dist(gen)}, parameter_list("expsyn"));
+    }
+    c.add_detector({0, 0}, 0);
+}
+
+// Print the modelled cache misses and time per step of a group of ncells
+// copies of proto, with each compartment numbering.
+void run(const std::string& morphology, const cell& proto, unsigned ncells) {
+    std::vector<cell> cells;
+    for (unsigned i=0; i<ncells; ++i) {
+        cells.emplace_back(clone_cell, proto);
+    }
+    auto ntargets = ncells*proto.synapses().size();
+
+    const unsigned steps = 100;
+    for (bool depth_first: {false, true}) {
+        fvm_cell fvcell;
+        fvcell.depth_first_numbering(depth_first);
+
+        std::vector<fvm_cell::target_handle> targets(ntargets);
+        std::vector<fvm_cell::detector_handle> detectors(ncells);
+        std::vector<fvm_cell::probe_handle> probes;
+        fvcell.initialize(cells, detectors, targets, probes);
+        fvcell.reset();
+
+        // the first step warms the cache model
+        memory_model mem;
+        replay_step(fvcell, mem);
+        mem.reset_count();
+        replay_step(fvcell, mem);
+
+        auto start = timer::tic();
+        for (unsigned i=0; i<steps; ++i) {
+            fvcell.advance(0.025);
+        }
+        auto t = timer::toc(start)/steps;
+
+        std::cout << std::setw(14) << morphology
+                  << std::setw(14) << (depth_first? "depth first": "segment")
+                  << std::setw(12) << mem.accesses
+                  << std::setw(12) << mem.l1.misses()
+                  << std::setw(12) << mem.l2.misses()
+                  << std::setw(12) << t*1e3 << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc<2) {
+        std::cout << "compartment_order swc_file [ncells [compartment_length]]\n"
+                  << "   Compare the modelled L1 and L2 cache misses per time step, and the\n"
+                  << "   time per step, of a group of ncells (default 1000) copies of the cell\n"
+                  << "   in swc_file, with compartments numbered segment by segment and depth\n"
+                  << "   first. The cell is also copied with its segments numbered breadth\n"
+                  << "   first. Cables are divided into compartments of about\n"
+                  << "   compartment_length µm (default 10).\n";
+        return 1;
+    }
+
+    std::ifstream fid(argv[1]);
+    if (!fid) {
+        std::cerr << "error: unable to open " << argv[1] << "\n";
+        return 1;
+    }
+    auto file_cell = io::swc_read_cell(fid);
+    unsigned ncells = argc>2? std::atoi(argv[2]): 1000;
+    double comp_length = argc>3? std::atof(argv[3]): 10.;
+
+    auto bfs_cell = breadth_first_copy(file_cell);
+    add_model(file_cell, comp_length);
+    add_model(bfs_cell, comp_length);
+
+    std::cout << "cells " << ncells << ", segments per cell " << file_cell.num_segments()
+              << ", compartments per cell " << file_cell.num_compartments() << "\n";
+    std::cout << std::setw(14) << "segments"
+              << std::setw(14) << "numbering"
+              << std::setw(12) << "accesses"
+              << std::setw(12) << "L1 misses"
+              << std::setw(12) << "L2 misses"
+              << std::setw(12) << "ms/step" << "\n";
+
+    run("file order", file_cell, ncells);
+    run("breadth first", bfs_cell, ncells);
+
+    return 0;
+}
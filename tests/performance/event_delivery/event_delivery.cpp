@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include <backends/fvm.hpp>
+#include <cell_group.hpp>
+#include <common_types.hpp>
+#include <communication/global_policy.hpp>
+#include <fvm_multicell.hpp>
+#include <model.hpp>
+#include <profiling/profiler.hpp>
+#include <util/span.hpp>
+
+#include "miniapp_recipes.hpp"
+
+using namespace nest::mc;
+
+using global_policy = communication::global_policy;
+using lowered_cell = fvm::fvm_multicell<multicore::backend>;
+using model_type = model<lowered_cell>;
+using time_type = model_type::time_type;
+using spike_type = model_type::spike_type;
+using timer = util::timer_type;
+
+struct run_result {
+    double wall_time;
+    std::map<cell_gid_type, std::vector<time_type>> spike_times;
+};
+
+run_result run_model(
+    const recipe& rec, cell_gid_type group_size,
+    event_delivery_mode mode, time_type tfinal, time_type dt)
+{
+    auto ncells = rec.num_cells();
+
+    std::vector<cell_gid_type> group_divisions;
+    for (cell_gid_type i=0; i<ncells; i+=group_size) {
+        group_divisions.push_back(i);
+    }
+    group_divisions.push_back(ncells);
+
+    model_type m(rec, util::partition_view(group_divisions));
+    m.set_event_delivery(mode);
+
+    run_result result;
+    m.set_global_spike_callback(
+        [&](const std::vector<spike_type>& spikes) {
+            for (auto& s: spikes) {
+                result.spike_times[s.source.gid].push_back(s.time);
+            }
+        });
+
+    // kick start the network with one artificial spike per 20 cells,
+    // as in the miniapp.
+    for (cell_gid_type c=0; c<ncells; c+=20) {
+        m.add_artificial_spike({c, 0});
+    }
+
+    auto start = timer::tic();
+    m.run(tfinal, dt);
+    result.wall_time = timer::toc(start);
+
+    for (auto& s: result.spike_times) {
+        std::sort(s.second.begin(), s.second.end());
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv) {
+    communication::global_policy_guard global_guard(argc, argv);
+
+    if (argc < 3) {
+        std::cout << "event_delivery <int ncells> <int group_size> [nsynapses] [tfinal] [dt]\n"
+                  << "   Compare exact and step aligned delivery of postsynaptic events\n"
+                  << "   in a randomly connected network of ncells cells, simulated with\n"
+                  << "   cell groups of group_size cells.\n"
+                  << "   Reports the cell steps per second for each mode, and the error\n"
+                  << "   in spike times of the step aligned mode relative to exact delivery.\n";
+        return 1;
+    }
+
+    auto ncells = std::atoi(argv[1]);
+    auto group_size = std::atoi(argv[2]);
+    auto nsynapses = argc>3? std::atoi(argv[3]): 100;
+    time_type tfinal = argc>4? std::atof(argv[4]): 100.;
+    time_type dt = argc>5? std::atof(argv[5]): 0.025;
+
+    if (ncells<1 || group_size<1 || nsynapses<1 || tfinal<=0 || dt<=0) {
+        std::cout << "event_delivery: all arguments must be greater than zero\n";
+        return 1;
+    }
+
+    basic_recipe_param p;
+    p.num_compartments = 10;
+    p.num_synapses = nsynapses;
+    auto rec = make_basic_rgraph_recipe(ncells, p);
+
+    auto exact = run_model(*rec, group_size, event_delivery_mode::exact, tfinal, dt);
+    auto aligned = run_model(*rec, group_size, event_delivery_mode::step_aligned, tfinal, dt);
+
+    // compare the i'th spike of each source in the two runs
+    std::size_t num_exact = 0, num_aligned = 0, num_matched = 0;
+    double max_err = 0, sum_err = 0;
+    for (auto& s: exact.spike_times) {
+        num_exact += s.second.size();
+    }
+    for (auto& s: aligned.spike_times) {
+        num_aligned += s.second.size();
+
+        auto it = exact.spike_times.find(s.first);
+        if (it==exact.spike_times.end()) {
+            continue;
+        }
+        auto n = std::min(s.second.size(), it->second.size());
+        for (std::size_t i=0; i<n; ++i) {
+            double err = std::abs(s.second[i]-it->second[i]);
+            max_err = std::max(max_err, err);
+            sum_err += err;
+            ++num_matched;
+        }
+    }
+
+    auto cell_steps = ncells*std::ceil(tfinal/dt);
+    std::cout << "cells " << ncells << ", group size " << group_size
+              << ", synapses/cell " << nsynapses << ", " << tfinal << " ms, dt " << dt << " ms\n";
+    std::cout << "exact delivery        : " << exact.wall_time << " s, "
+              << cell_steps/exact.wall_time << " cell steps/s, "
+              << num_exact << " spikes\n";
+    std::cout << "step aligned delivery : " << aligned.wall_time << " s, "
+              << cell_steps/aligned.wall_time << " cell steps/s, "
+              << num_aligned << " spikes\n";
+    std::cout << "speedup               : " << exact.wall_time/aligned.wall_time << "\n";
+    std::cout << "spike time error (ms) : mean "
+              << (num_matched? sum_err/num_matched: 0.) << ", max " << max_err
+              << " over " << num_matched << " matched spikes\n";
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include <event_queue.hpp>
+#include <profiling/profiler.hpp>
+
+using namespace nest::mc;
+
+using time_type = float;
+using event_type = postsynaptic_spike_event<time_type>;
+using timer = util::timer_type;
+
+// Reference implementation: the binary heap based event queue that
+// event_queue replaced.
+class heap_event_queue {
+public:
+    using value_type = event_type;
+
+    template <typename Iter>
+    void push(Iter b, Iter e) {
+        for (; b!=e; ++b) {
+            queue_.push(*b);
+        }
+    }
+
+    util::optional<value_type> pop_if_before(time_type t_until) {
+        if (!queue_.empty() && queue_.top().when() < t_until) {
+            auto ev = queue_.top();
+            queue_.pop();
+            return ev;
+        }
+        return util::nothing;
+    }
+
+private:
+    struct event_greater {
+        bool operator()(const event_type& a, const event_type& b) {
+            return a.when() > b.when();
+        }
+    };
+
+    std::priority_queue<event_type, std::vector<event_type>, event_greater> queue_;
+};
+
+// Emulate the use of an event queue by a cell group: at the start of each
+// epoch the events generated by the spike exchange are pushed in bulk, then
+// the events are popped one integration step at a time.
+template <typename Queue>
+double run(const std::vector<std::vector<event_type>>& epochs,
+           time_type epoch_length, time_type dt, std::size_t& num_popped)
+{
+    Queue q;
+    num_popped = 0;
+
+    auto start = timer::tic();
+    time_type t = 0;
+    for (auto& events: epochs) {
+        q.push(events.begin(), events.end());
+
+        auto t_end = t+epoch_length;
+        for (; t<t_end; t+=dt) {
+            while (q.pop_if_before(t+dt)) {
+                ++num_popped;
+            }
+        }
+    }
+    return timer::toc(start);
+}
+
+int main(int argc, char** argv) {
+    if (argc>1 && std::atof(argv[1])<1e3) {
+        std::cout << "event_queue [max_events]\n"
+                  << "   Compare the binary heap and sorted buffer event queues\n"
+                  << "   for 10^3 up to max_events (default 10^7) events per cell group.\n";
+        return 1;
+    }
+    double max_events = argc>1? std::atof(argv[1]): 1e7;
+
+    const time_type epoch_length = 10; // ms, i.e. half a typical min delay
+    const time_type dt = 0.025;        // ms
+    const unsigned num_epochs = 10;
+
+    std::cout << std::setw(12) << "events"
+              << std::setw(14) << "heap (ns/ev)"
+              << std::setw(14) << "flat (ns/ev)"
+              << std::setw(10) << "speedup" << "\n";
+
+    std::mt19937 gen(42);
+    for (double n=1e3; n<=max_events; n*=10) {
+        // Generate the events delivered in each epoch, with delivery times
+        // spread over the current and next epoch.
+        auto per_epoch = std::size_t(n/num_epochs);
+        std::vector<std::vector<event_type>> epochs(num_epochs);
+        for (unsigned k=0; k<num_epochs; ++k) {
+            std::uniform_real_distribution<time_type> dist(k*epoch_length, (k+2)*epoch_length);
+            for (std::size_t i=0; i<per_epoch; ++i) {
+                epochs[k].push_back({{0u, cell_lid_type(i%1000)}, dist(gen), 0.1f});
+            }
+        }
+
+        std::size_t heap_popped, flat_popped;
+        auto t_heap = run<heap_event_queue>(epochs, epoch_length, dt, heap_popped);
+        auto t_flat = run<event_queue<event_type>>(epochs, epoch_length, dt, flat_popped);
+
+        if (heap_popped!=flat_popped) {
+            std::cerr << "error: queues delivered different numbers of events\n";
+            return 2;
+        }
+
+        auto total = double(per_epoch*num_epochs);
+        std::cout << std::setw(12) << std::size_t(total)
+                  << std::setw(14) << t_heap/total*1e9
+                  << std::setw(14) << t_flat/total*1e9
+                  << std::setw(10) << t_heap/t_flat << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <backends/fvm_multicore.hpp>
+#include <matrix.hpp>
+#include <profiling/profiler.hpp>
+#include <util/span.hpp>
+
+using namespace nest::mc;
+
+using backend = multicore::backend;
+using matrix_type = matrix<backend>;
+using value_type = backend::value_type;
+using size_type = backend::size_type;
+using timer = util::timer_type;
+
+// Bytes moved to or from memory per compartment in each time step,
+// assuming that the arrays of all cells do not fit in cache, but the
+// arrays of one cell do. Writes to a line that is not in cache are
+// counted twice, because the line is read before it is written.
+//
+// The separate passes stream:
+//      assemble        read gi, diag, voltage, current; write d, rhs
+//      backward sweep  read u, d, rhs, p; write d, rhs
+//      forward sweep   read u, d, rhs, p; write rhs
+//      copy            read rhs; write voltage
+// The fused pass reads gi, diag, voltage, current, u, p, and writes d, rhs
+// and voltage, of which voltage is already in cache. Here gi and diag are the
+// capacitance term and diagonal for the time step, which the assembler only
+// recomputes when dt changes.
+// The interleaved pass also reads the compartment index of each slot.
+constexpr std::size_t V = sizeof(value_type);
+constexpr std::size_t I = sizeof(size_type);
+constexpr std::size_t separate_bytes = (4*V + 4*V) + (3*V+I + 2*V) + (3*V+I + V) + (V + 2*V);
+constexpr std::size_t fused_bytes = (5*V+I) + 4*V + V;
+constexpr std::size_t interleaved_bytes = fused_bytes + I;
+
+// Parent index of ncells random unbranched cables of ncomp compartments,
+// with a branch point at about one compartment in twenty.
+std::vector<size_type> make_parent_index(unsigned ncells, unsigned ncomp, std::mt19937& gen) {
+    std::uniform_real_distribution<double> u(0, 1);
+    std::vector<size_type> p;
+    for (unsigned c=0; c<ncells; ++c) {
+        size_type first = p.size();
+        p.push_back(first);
+        for (unsigned i=1; i<ncomp; ++i) {
+            size_type parent = first+i-1;
+            if (u(gen)<0.05) {
+                parent = first + std::uniform_int_distribution<size_type>(0, i-1)(gen);
+            }
+            p.push_back(parent);
+        }
+    }
+    return p;
+}
+
+int main(int argc, char** argv) {
+    int ncells = argc>1? std::atoi(argv[1]): 1000;
+    int ncomp = argc>2? std::atoi(argv[2]): 400;
+    if (ncells<1 || ncomp<1) {
+        std::cout << "matrix_solve [ncells [ncomp]]\n"
+                  << "   Compare the time per compartment and the bytes moved per compartment\n"
+                  << "   in each time step of the separate and fused matrix assembly and solve,\n"
+                  << "   for ncells (default 1000) cells of ncomp (default 400) compartments.\n";
+        return 1;
+    }
+
+    const value_type dt = 0.025;
+    const unsigned steps = 50;
+
+    std::mt19937 gen(42);
+    auto p = make_parent_index(ncells, ncomp, gen);
+    std::vector<size_type> ci;
+    for (int c=0; c<=ncells; ++c) {
+        ci.push_back(c*ncomp);
+    }
+    auto n = p.size();
+
+    std::uniform_real_distribution<value_type> u(0, 1);
+    backend::array cv_capacitance(n), face_conductance(n), current(n);
+    for (auto i: util::make_span(0u, n)) {
+        cv_capacitance[i] = 0.5+u(gen);
+        face_conductance[i] = 1+u(gen);
+        current[i] = 0.01*(u(gen)-0.5);
+    }
+
+    // separate passes: assemble, solve, copy solution to voltage
+    backend::array voltage(n, -65.);
+    matrix_type m(p, ci);
+    backend::matrix_assembler assembler(
+        m.d(), m.u(), m.rhs(), m.p(), m.cell_index(),
+        cv_capacitance, face_conductance, voltage, current);
+
+    auto start = timer::tic();
+    for (unsigned i=0; i<steps; ++i) {
+        assembler.assemble(dt);
+        m.solve();
+        memory::copy(m.rhs(), voltage);
+    }
+    auto t_separate = timer::toc(start);
+
+    // fused pass
+    backend::array voltage_fused(n, -65.);
+    matrix_type m_fused(p, ci);
+    backend::matrix_assembler fused(
+        m_fused.d(), m_fused.u(), m_fused.rhs(), m_fused.p(), m_fused.cell_index(),
+        cv_capacitance, face_conductance, voltage_fused, current);
+
+    start = timer::tic();
+    for (unsigned i=0; i<steps; ++i) {
+        fused.assemble_and_solve(dt, voltage_fused);
+    }
+    auto t_fused = timer::toc(start);
+
+    // fused pass with interleaved layout
+    backend::array voltage_interleaved(n, -65.);
+    matrix_type m_interleaved(p, ci);
+    backend::matrix_assembler interleaved(
+        m_interleaved.d(), m_interleaved.u(), m_interleaved.rhs(),
+        m_interleaved.p(), m_interleaved.cell_index(),
+        cv_capacitance, face_conductance, voltage_interleaved, current);
+    interleaved.interleave(backend::matrix_assembler::make_layout(p, ci));
+
+    start = timer::tic();
+    for (unsigned i=0; i<steps; ++i) {
+        interleaved.assemble_and_solve(dt, voltage_interleaved);
+    }
+    auto t_interleaved = timer::toc(start);
+
+    value_type max_diff = 0;
+    for (auto i: util::make_span(0u, n)) {
+        max_diff = std::max(max_diff, std::fabs(voltage[i]-voltage_fused[i]));
+        max_diff = std::max(max_diff, std::fabs(voltage[i]-voltage_interleaved[i]));
+    }
+    if (max_diff>1e-9) {
+        std::cerr << "error: fused solution differs by " << max_diff << " mV\n";
+        return 2;
+    }
+
+    auto ns = [&](double t) { return t/(n*steps)*1e9; };
+    auto gbs = [&](double t, std::size_t bytes) { return bytes*n*steps/t*1e-9; };
+
+    std::cout << "cells " << ncells << ", compartments per cell " << ncomp
+              << ", steps " << steps
+              << ", interleaved width " << backend::matrix_assembler::simd_width << "\n";
+    std::cout << std::setw(10) << "method"
+              << std::setw(16) << "bytes/comp-step"
+              << std::setw(16) << "ns/comp-step"
+              << std::setw(16) << "GB/s" << "\n";
+    std::cout << std::setw(10) << "separate"
+              << std::setw(16) << separate_bytes
+              << std::setw(16) << ns(t_separate)
+              << std::setw(16) << gbs(t_separate, separate_bytes) << "\n";
+    std::cout << std::setw(10) << "fused"
+              << std::setw(16) << fused_bytes
+              << std::setw(16) << ns(t_fused)
+              << std::setw(16) << gbs(t_fused, fused_bytes) << "\n";
+    std::cout << std::setw(10) << "interleave"
+              << std::setw(16) << interleaved_bytes
+              << std::setw(16) << ns(t_interleaved)
+              << std::setw(16) << gbs(t_interleaved, interleaved_bytes) << "\n";
+    std::cout << "speedup: fused " << t_separate/t_fused
+              << ", interleaved " << t_separate/t_interleaved << "\n";
+
+    return 0;
+}
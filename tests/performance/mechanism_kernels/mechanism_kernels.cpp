@@ -0,0 +1,119 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <backends/fvm_multicore.hpp>
+#include <ion.hpp>
+#include <memory/wrappers.hpp>
+#include <profiling/profiler.hpp>
+
+using namespace nest::mc;
+
+using backend = multicore::backend;
+using size_type = backend::size_type;
+using value_type = backend::value_type;
+using timer = util::timer_type;
+
+// A density mechanism on n consecutive CVs, with its own voltage, current
+// and ions, as set up by fvm_multicell.
+struct density_state {
+    backend::array vec_v;
+    backend::array vec_i;
+    std::map<mechanisms::ionKind, mechanisms::ion<backend>> ions;
+    mechanisms::mechanism_ptr<backend> mech;
+
+    density_state(const std::string& name, std::size_t n):
+        vec_v(n), vec_i(n, 0.)
+    {
+        for (auto i=0u; i<n; ++i) {
+            vec_v[i] = -80.+50.*i/n;
+        }
+        std::vector<size_type> node_index(n);
+        std::iota(node_index.begin(), node_index.end(), 0);
+        auto weights = std::vector<value_type>(n, 1.0);
+        mech = backend::make_mechanism(
+            name, memory::make_view(vec_v), memory::make_view(vec_i), weights, node_index);
+
+        for (auto kind: mechanisms::ion_kinds()) {
+            if (mech->uses_ion(kind)) {
+                ions[kind] = node_index;
+                memory::fill(ions[kind].reversal_potential(), 50.);
+                memory::fill(ions[kind].internal_concentration(), 10.);
+                memory::fill(ions[kind].external_concentration(), 140.);
+                mech->set_ion(kind, ions[kind], node_index);
+            }
+        }
+
+        mech->set_params(0, 0.025);
+        mech->nrn_init();
+    }
+
+    void step() {
+        memory::fill(vec_i, 0.);
+        for (auto& ion: ions) {
+            memory::fill(ion.second.current(), 0.);
+        }
+        mech->nrn_current();
+        mech->nrn_state();
+    }
+};
+
+// Time the steps of the mechanism, in ns per instance per step.
+double run(density_state& s, unsigned num_steps) {
+    auto start = timer::tic();
+    for (auto i=0u; i<num_steps; ++i) {
+        s.step();
+    }
+    return timer::toc(start)/num_steps/s.mech->size()*1e9;
+}
+
+int main(int argc, char** argv) {
+    if (argc>1 && std::atof(argv[1])<1e3) {
+        std::cout << "mechanism_kernels [max_instances]\n"
+                  << "   Compare the kernels of the density mechanisms that access the CV\n"
+                  << "   state through the node index and directly over runs of consecutive\n"
+                  << "   CVs, for 10^3 up to max_instances (default 10^6) instances.\n";
+        return 1;
+    }
+    double max_instances = argc>1? std::atof(argv[1]): 1e6;
+
+    std::cout << std::setw(8) << "mech"
+              << std::setw(12) << "instances"
+              << std::setw(16) << "index (ns/ins)"
+              << std::setw(16) << "direct (ns/ins)"
+              << std::setw(10) << "speedup" << "\n";
+
+    for (auto name: {"pas", "hh"}) {
+        for (double n=1e3; n<=max_instances; n*=10) {
+            auto size = std::size_t(n);
+            auto num_steps = unsigned(std::max(10., 1e8/n));
+
+            density_state indexed(name, size), direct(name, size);
+            direct.mech->set_index_runs({0, size_type(size)});
+
+            auto t_indexed = run(indexed, num_steps);
+            auto t_direct = run(direct, num_steps);
+
+            // both versions of the kernels compute the same currents
+            for (auto i=0u; i<size; ++i) {
+                if (std::abs(indexed.vec_i[i]-direct.vec_i[i])>1e-12*std::abs(indexed.vec_i[i])) {
+                    std::cerr << "error: the " << name << " kernels computed different currents\n";
+                    return 2;
+                }
+            }
+
+            std::cout << std::setw(8) << name
+                      << std::setw(12) << size
+                      << std::setw(16) << t_indexed
+                      << std::setw(16) << t_direct
+                      << std::setw(10) << t_indexed/t_direct << "\n";
+        }
+    }
+
+    return 0;
+}
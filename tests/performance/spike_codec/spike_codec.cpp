@@ -0,0 +1,93 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <communication/spike_codec.hpp>
+#include <profiling/profiler.hpp>
+#include <spike.hpp>
+
+using namespace nest::mc;
+
+using time_type = float;
+using spike_type = spike<cell_member_type, time_type>;
+using codec_type = communication::spike_codec<time_type>;
+using timer = util::timer_type;
+
+// Spikes generated by ncells cells with contiguous gids firing at rate Hz
+// over an epoch of length epoch ms.
+std::vector<spike_type> make_spikes(cell_gid_type ncells, double rate, double epoch, std::mt19937& gen) {
+    std::uniform_real_distribution<double> u(0, 1);
+    std::uniform_real_distribution<time_type> t(0, epoch);
+    auto p = rate*epoch*1e-3;
+
+    std::vector<spike_type> spikes;
+    for (cell_gid_type gid=0; gid<ncells; ++gid) {
+        if (u(gen)<p) {
+            spikes.push_back({{gid, 0u}, 100+t(gen)});
+        }
+    }
+    return spikes;
+}
+
+int main(int argc, char** argv) {
+    cell_gid_type ncells = argc>1? std::atoi(argv[1]): 100000;
+    if (ncells<1) {
+        std::cout << "spike_codec [ncells]\n"
+                  << "   Measure the size and encode+decode time of the spikes from ncells\n"
+                  << "   cells (default 10^5) in one epoch, for a range of firing rates.\n";
+        return 1;
+    }
+
+    const double epoch = 5;         // ms, half of a typical min delay
+    const unsigned repeats = 20;
+    const double rates[] = {1, 5, 10, 50};  // Hz
+    const time_type quanta[] = {0, 1e-3};   // lossless, 1 µs
+
+    std::cout << "cells " << ncells << ", epoch " << epoch << " ms\n";
+    std::cout << std::setw(10) << "rate (Hz)"
+              << std::setw(10) << "spikes"
+              << std::setw(12) << "quantum"
+              << std::setw(14) << "bytes/spike"
+              << std::setw(10) << "saving"
+              << std::setw(16) << "ns/spike" << "\n";
+
+    std::mt19937 gen(42);
+    for (auto rate: rates) {
+        auto spikes = make_spikes(ncells, rate, epoch, gen);
+        if (spikes.empty()) {
+            continue;
+        }
+
+        for (auto q: quanta) {
+            codec_type codec(q);
+            std::vector<char> buf;
+            std::vector<spike_type> out;
+
+            auto start = timer::tic();
+            for (unsigned i=0; i<repeats; ++i) {
+                buf.clear();
+                out.clear();
+                codec.encode(spikes, buf);
+                codec.decode(buf.data(), buf.data()+buf.size(), out);
+            }
+            auto t = timer::toc(start)/repeats;
+
+            if (out.size()!=spikes.size()) {
+                std::cerr << "error: decoded " << out.size() << " of " << spikes.size() << " spikes\n";
+                return 2;
+            }
+
+            auto bytes = double(buf.size())/spikes.size();
+            std::cout << std::setw(10) << rate
+                      << std::setw(10) << spikes.size()
+                      << std::setw(12) << q
+                      << std::setw(14) << bytes
+                      << std::setw(10) << sizeof(spike_type)/bytes
+                      << std::setw(16) << t/spikes.size()*1e9 << "\n";
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <common_types.hpp>
+#include <communication/communicator.hpp>
+#include <communication/global_policy.hpp>
+#include <profiling/profiler.hpp>
+#include <util/partition.hpp>
+#include <util/span.hpp>
+
+#ifdef WITH_MPI
+#include <communication/mpi_global_policy.hpp>
+#include <communication/mpi_sparse_global_policy.hpp>
+#endif
+
+using namespace nest::mc;
+
+using time_type = float;
+using spike_type = spike<cell_member_type, time_type>;
+using timer = util::timer_type;
+
+struct parameters {
+    cell_gid_type cells_per_rank = 1000;
+    unsigned fan_in = 1000;
+    unsigned neighbours = 4;        // sources are on the nearest ranks
+    double spike_fraction = 0.05;   // proportion of cells that spike per epoch
+    unsigned epochs = 20;
+};
+
+struct result {
+    double time = 0;
+    double bytes_received = 0;
+    std::size_t events = 0;
+};
+
+// Build a communicator for a network where the sources of the connections
+// on each rank are distributed uniformly over the cells of the calling rank
+// and its p.neighbours nearest ranks, then time the spike exchange and event
+// generation.
+template <typename Policy>
+result run(const parameters& p) {
+    int id = Policy::id();
+    int size = Policy::size();
+    cell_gid_type first = id*p.cells_per_rank;
+
+    std::vector<cell_gid_type> divisions = {first, first+p.cells_per_rank};
+    communication::communicator<time_type, Policy> comm(util::partition_view(divisions));
+
+    std::mt19937 gen(id);
+    auto nbr = int(p.neighbours);
+    std::uniform_int_distribution<int> rank_dist(-nbr/2, nbr-nbr/2);
+    std::uniform_int_distribution<cell_gid_type> cell_dist(0, p.cells_per_rank-1);
+    for (auto gid: util::make_span(first, first+p.cells_per_rank)) {
+        for (auto i: util::make_span(0u, p.fan_in)) {
+            auto src_rank = ((id+rank_dist(gen))%size+size)%size;
+            cell_gid_type src = src_rank*p.cells_per_rank+cell_dist(gen);
+            comm.add_connection({{src, 0u}, {gid, i}, 1.f, time_type(1)});
+        }
+    }
+    comm.construct();
+
+    std::uniform_real_distribution<double> u(0, 1);
+    result r;
+    for (auto epoch: util::make_span(0u, p.epochs)) {
+        std::vector<spike_type> local_spikes;
+        for (auto gid: util::make_span(first, first+p.cells_per_rank)) {
+            if (u(gen)<p.spike_fraction) {
+                local_spikes.push_back({{gid, 0u}, time_type(epoch)});
+            }
+        }
+
+        auto start = timer::tic();
+        auto spikes = comm.exchange(local_spikes);
+        auto queues = comm.make_event_queues(spikes);
+        r.time += timer::toc(start);
+
+        r.bytes_received += sizeof(spike_type)*(spikes.size()-local_spikes.size());
+        for (auto& q: queues) {
+            r.events += q.size();
+        }
+    }
+
+    r.time = Policy::max(r.time);
+    r.bytes_received = Policy::sum(r.bytes_received)/size;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    communication::global_policy_guard global_guard(argc, argv);
+
+#ifndef WITH_MPI
+    std::cout << "spike_exchange compares MPI spike exchange policies: build with WITH_MPI\n";
+    return 0;
+#else
+    using dense_policy = communication::mpi_global_policy;
+    using sparse_policy = communication::mpi_sparse_global_policy;
+
+    parameters p;
+    if (argc>1) p.cells_per_rank = std::atoi(argv[1]);
+    if (argc>2) p.fan_in = std::atoi(argv[2]);
+    if (argc>3) p.neighbours = std::atoi(argv[3]);
+    if (p.cells_per_rank<1 || p.fan_in<1) {
+        std::cout << "spike_exchange [cells_per_rank] [fan_in] [neighbours]\n"
+                  << "   Compare the bytes received per rank and time of spike exchange\n"
+                  << "   and event generation with Allgatherv and sparse exchange.\n"
+                  << "   Run with mpirun on several ranks.\n";
+        return 1;
+    }
+
+    auto dense = run<dense_policy>(p);
+    auto sparse = run<sparse_policy>(p);
+
+    if (dense_policy::sum(dense.events)!=dense_policy::sum(sparse.events)) {
+        std::cerr << "error: exchange policies generated different numbers of events\n";
+        return 2;
+    }
+
+    if (dense_policy::id()==0) {
+        std::cout << "ranks " << dense_policy::size()
+                  << ", cells per rank " << p.cells_per_rank
+                  << ", fan in " << p.fan_in
+                  << ", neighbours " << p.neighbours << "\n";
+        std::cout << std::setw(10) << "policy"
+                  << std::setw(20) << "bytes/rank/epoch"
+                  << std::setw(14) << "time (s)" << "\n";
+        std::cout << std::setw(10) << "allgather"
+                  << std::setw(20) << dense.bytes_received/p.epochs
+                  << std::setw(14) << dense.time << "\n";
+        std::cout << std::setw(10) << "sparse"
+                  << std::setw(20) << sparse.bytes_received/p.epochs
+                  << std::setw(14) << sparse.time << "\n";
+    }
+    return 0;
+#endif
+}
@@ -0,0 +1,39 @@
+: A three state Markov channel, c1 <-> c2 <-> o, with constant rates,
+: for testing the sparse solver of kinetic schemes in test_mechanisms.
+: The steady state is c1 = 2/9, c2 = 4/9 and o = 1/3.
+
+NEURON {
+    SUFFIX markov
+    NONSPECIFIC_CURRENT i
+    RANGE gbar
+}
+
+PARAMETER {
+    gbar = 0.001 (S/cm2)
+    e = -65 (mV)
+}
+
+STATE {
+    c1 c2 o
+}
+
+ASSIGNED {
+    v (mV)
+}
+
+BREAKPOINT {
+    SOLVE kin METHOD sparse
+    i = gbar*o*(v - e)
+}
+
+INITIAL {
+    c1 = 1
+    c2 = 0
+    o = 0
+}
+
+KINETIC kin {
+    ~ c1 <-> c2 (2, 1)
+    ~ c2 <-> o (3, 4)
+    CONSERVE c1 + c2 + o = 1
+}
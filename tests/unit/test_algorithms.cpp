@@ -1,4 +1,5 @@
 #include <iterator>
+#include <numeric>
 #include <random>
 #include <vector>
 
@@ -406,6 +407,78 @@ TEST(algorithms, child_count)
 
 }
 
+TEST(algorithms, depth_first_numbering)
+{
+    using nest::mc::algorithms::depth_first_numbering;
+
+    {
+        // tree from child_count test, with branches numbered breadth first
+        //
+        //        0
+        //       /|\.
+        //      1 2 3
+        //     /  |  \.
+        //    4   5   6
+        //   /         \.
+        //  7           8
+        //             / \.
+        //            9   10
+        //
+        std::vector<int> parent_index = { 0, 0, 0, 0, 1, 2, 3, 4, 6, 8, 8 };
+        std::vector<int> expected = { 0, 1, 4, 6, 2, 5, 7, 3, 8, 9, 10 };
+
+        EXPECT_EQ(expected, depth_first_numbering(parent_index));
+    }
+
+    {
+        // already depth first: unchanged
+        std::vector<int> parent_index = { 0, 0, 1, 2, 0, 4, 0, 6, 7, 8, 9, 8, 11, 12 };
+        std::vector<int> expected(parent_index.size());
+        std::iota(expected.begin(), expected.end(), 0);
+
+        EXPECT_EQ(expected, depth_first_numbering(parent_index));
+    }
+
+    {
+        // two trees
+        std::vector<int> parent_index = { 0, 0, 2, 0, 2, 1 };
+        std::vector<int> expected = { 0, 1, 4, 3, 5, 2 };
+
+        EXPECT_EQ(expected, depth_first_numbering(parent_index));
+    }
+
+    EXPECT_TRUE(depth_first_numbering(std::vector<int>{}).empty());
+}
+
+TEST(algorithms, contiguous_runs)
+{
+    using nest::mc::algorithms::contiguous_runs;
+
+    {
+        std::vector<int> index = { 3, 4, 5, 6 };
+        std::vector<int> expected = { 0, 4 };
+
+        EXPECT_EQ(expected, contiguous_runs(index));
+    }
+
+    {
+        std::vector<int> index = { 0, 1, 2, 5, 7, 8, 9, 10, 12 };
+        std::vector<int> expected = { 0, 3, 4, 8, 9 };
+
+        EXPECT_EQ(expected, contiguous_runs(index));
+    }
+
+    {
+        // a repeated index starts a new run
+        std::vector<int> index = { 2, 2, 3 };
+        std::vector<int> expected = { 0, 1, 3 };
+
+        EXPECT_EQ(expected, contiguous_runs(index));
+    }
+
+    EXPECT_EQ(std::vector<int>{0}, contiguous_runs(std::vector<int>{}));
+}
+
 TEST(algorithms, branches)
 {
     using namespace nest::mc;
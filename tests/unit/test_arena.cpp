@@ -0,0 +1,97 @@
+#include "../gtest.h"
+
+#include <cstdint>
+#include <utility>
+
+#include <memory/memory.hpp>
+
+using namespace nest::mc;
+
+using arena_array = memory::arena_vector<double>;
+
+static bool is_aligned(const void* p, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(p)%alignment==0;
+}
+
+// test that vectors are allocated from the arena of the innermost scope,
+// and from the heap outside of any scope
+TEST(arena, scope)
+{
+    memory::arena a;
+    arena_array outside(100, 1.);
+    EXPECT_EQ(0u, a.size());
+
+    {
+        memory::arena_scope scope(a, "x");
+        arena_array x(100, 1.);
+        EXPECT_EQ(1u, a.num_blocks());
+        EXPECT_GE(a.usage().at("x"), 100*sizeof(double));
+        EXPECT_TRUE(is_aligned(x.data(), memory::arena::alignment));
+
+        memory::arena b;
+        {
+            memory::arena_scope inner(b, "y");
+            arena_array y(10, 2.);
+        }
+        EXPECT_EQ(0u, a.usage().count("y"));
+        EXPECT_EQ(1u, b.usage().count("y"));
+
+        scope.set_component("z");
+        arena_array z(10, 3.);
+        EXPECT_EQ(1u, a.usage().count("z"));
+        EXPECT_EQ(a.size(), a.usage().at("x")+a.usage().at("z"));
+    }
+
+    // freeing a vector from the arena does not release its storage
+    auto size = a.size();
+    arena_array after(100, 1.);
+    EXPECT_EQ(size, a.size());
+}
+
+// test that the arena grows by blocks of increasing size, which are sized
+// in huge pages when they are large
+TEST(arena, blocks)
+{
+    memory::arena a;
+    memory::arena_scope scope(a, "x");
+
+    std::vector<arena_array> arrays;
+    for (auto n: {100u, 10000u, 100000u, 1000000u}) {
+        arrays.emplace_back(n, 0.);
+        for (auto& x: arrays) {
+            EXPECT_TRUE(is_aligned(x.data(), memory::arena::alignment));
+        }
+    }
+
+    // blocks at least double in size, so at most about half is unused
+    EXPECT_GE(a.capacity(), a.size());
+    EXPECT_LE(a.capacity(), 2*a.size()+memory::arena::huge_page_size);
+    EXPECT_EQ(0u, a.capacity()%4096);
+    EXPECT_EQ(a.size(), a.usage().at("x"));
+}
+
+// test that vectors allocated from an arena can be released after the arena
+// is move assigned, as in the move assignment of the object that owns both
+TEST(arena, move_assign)
+{
+    struct owner {
+        memory::arena a;
+        arena_array x;
+    };
+
+    owner o;
+    {
+        memory::arena_scope scope(o.a, "x");
+        o.x = arena_array(1000, 1.);
+    }
+
+    owner p;
+    {
+        memory::arena_scope scope(p.a, "x");
+        p.x = arena_array(10, 2.);
+    }
+
+    o = std::move(p);
+    EXPECT_EQ(10u, o.x.size());
+    EXPECT_EQ(2., o.x[0]);
+}
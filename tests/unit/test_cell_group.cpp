@@ -1,5 +1,9 @@
 #include "../gtest.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include <cell_group.hpp>
 #include <common_types.hpp>
 #include <fvm_multicell.hpp>
@@ -35,6 +39,27 @@ TEST(cell_group, test)
     EXPECT_EQ(4u, group.spikes().size());
 }
 
+TEST(cell_group, depth_first_numbering)
+{
+    using namespace nest::mc;
+
+    using cell_group_type = cell_group<fvm_cell>;
+    auto by_segment = cell_group_type{0, util::singleton_view(make_cell())};
+
+    cell_group_options options;
+    options.depth_first_numbering = true;
+    auto depth_first = cell_group_type{0, util::singleton_view(make_cell()), options};
+
+    by_segment.advance(50, 0.01);
+    depth_first.advance(50, 0.01);
+
+    // the numbering of the compartments does not change the spikes
+    ASSERT_EQ(by_segment.spikes().size(), depth_first.spikes().size());
+    for (auto i=0u; i<by_segment.spikes().size(); ++i) {
+        EXPECT_NEAR(by_segment.spikes()[i].time, depth_first.spikes()[i].time, 1e-4);
+    }
+}
+
 TEST(cell_group, sources)
 {
     using namespace nest::mc;
@@ -66,3 +91,182 @@ TEST(cell_group, sources)
         }
     }
 }
+
+TEST(cell_group, step_aligned_events)
+{
+    using namespace nest::mc;
+
+    using cell_group_type = cell_group<fvm_cell>;
+    using time_type = cell_group_type::time_type;
+
+    auto cell = make_cell();
+    cell.add_synapse({1, 0.5}, parameter_list("expsyn"));
+    cell.add_probe({{0, 0}, probeKind::membrane_voltage});
+
+    const time_type dt = 0.025;
+    const time_type tfinal = 20;
+    std::vector<postsynaptic_spike_event<time_type>> events = {
+        {{0u, 0u}, 1.0107f, 0.1f},
+        {{0u, 0u}, 3.3333f, 0.1f},
+        {{0u, 0u}, 7.7001f, 0.1f}
+    };
+
+    // record the time at the start of each integration step
+    auto run = [&](event_delivery_mode mode) {
+        std::vector<time_type> step_times;
+        auto group = cell_group_type{0, util::singleton_view(cell)};
+        group.set_event_delivery(mode);
+        group.add_sampler({0u, 0u},
+            [&](time_type t, double) {
+                step_times.push_back(t);
+                return util::optional<time_type>(t);
+            });
+
+        group.enqueue_events(events);
+        group.advance(tfinal, dt);
+        return step_times;
+    };
+
+    // allow for round off in the accumulated single precision step times
+    auto is_on_grid = [dt](time_type t) {
+        return std::abs(t/dt-std::round(t/dt)) < 1e-2;
+    };
+
+    // exact delivery truncates the steps at the event times
+    auto exact = run(event_delivery_mode::exact);
+    EXPECT_FALSE(std::all_of(exact.begin(), exact.end(), is_on_grid));
+
+    // step aligned delivery keeps the fixed time step
+    auto aligned = run(event_delivery_mode::step_aligned);
+    EXPECT_TRUE(std::all_of(aligned.begin(), aligned.end(), is_on_grid));
+    EXPECT_LT(aligned.size(), exact.size());
+}
+
+TEST(cell_group, dt_changes)
+{
+    using namespace nest::mc;
+
+    using cell_group_type = cell_group<fvm_cell>;
+    using time_type = cell_group_type::time_type;
+
+    auto cell = make_cell();
+    cell.add_synapse({1, 0.5}, parameter_list("expsyn"));
+
+    const time_type dt = 0.01;
+    std::vector<postsynaptic_spike_event<time_type>> events = {
+        {{0u, 0u}, 1.0107f, 0.1f},
+        {{0u, 0u}, 3.3333f, 0.1f},
+        {{0u, 0u}, 7.7001f, 0.1f}
+    };
+
+    // advance in intervals of 0.5 ms, as the model does between exchanges
+    auto run = [&](event_delivery_mode mode) {
+        auto group = cell_group_type{0, util::singleton_view(cell)};
+        group.set_event_delivery(mode);
+        group.enqueue_events(events);
+        for (int i=1; i<=40; ++i) {
+            group.advance(time_type(0.5*i), dt);
+        }
+        EXPECT_GE(group.num_steps(), 2000u);
+        return group.num_dt_changes();
+    };
+
+    // the first step, the step truncated by the event at 3.3333 ms and the
+    // step after it, which leave the steps off the grid until the step
+    // truncated at 3.5 ms and the step after it; the other events are within
+    // min_step(dt) of the start of a step, and are delivered there
+    EXPECT_EQ(5u, run(event_delivery_mode::exact));
+
+    // with step aligned delivery dt never changes after the first step
+    EXPECT_EQ(1u, run(event_delivery_mode::step_aligned));
+}
+
+TEST(cell_group, truncated_steps)
+{
+    using namespace nest::mc;
+
+    using cell_group_type = cell_group<fvm_cell>;
+    using time_type = cell_group_type::time_type;
+
+    auto cell = make_cell();
+    cell.add_synapse({1, 0.5}, parameter_list("expsyn"));
+    cell.add_probe({{0, 0}, probeKind::membrane_voltage});
+
+    // an event 0.95 dt into a step, and an end time 0.95 dt into a step
+    const time_type dt = 0.025;
+    const time_type tevent = 3.95f*dt;
+    const time_type tfinal = 10.95f*dt;
+    std::vector<postsynaptic_spike_event<time_type>> events = {
+        {{0u, 0u}, tevent, 0.1f}
+    };
+
+    std::vector<time_type> step_times;
+    auto group = cell_group_type{0, util::singleton_view(cell)};
+    group.add_sampler({0u, 0u},
+        [&](time_type t, double) {
+            step_times.push_back(t);
+            return util::optional<time_type>(t);
+        });
+    group.enqueue_events(events);
+    group.advance(tfinal, dt);
+
+    // the sampler sees the start time of each step after the first: the
+    // step before the event ends at the event, not at the end of the step
+    ASSERT_GT(step_times.size(), 4u);
+    EXPECT_FLOAT_EQ(3*dt, step_times[2]);
+    EXPECT_EQ(tevent, step_times[3]);
+    EXPECT_FLOAT_EQ(tevent+dt, step_times[4]);
+
+    // the last step ends at tfinal, not after it: the first step of the
+    // next interval starts there
+    step_times.clear();
+    group.advance(2*tfinal, dt);
+    ASSERT_FALSE(step_times.empty());
+    EXPECT_EQ(tfinal, step_times.front());
+
+    // an event 0.05 dt before the end time truncates the last step, and the
+    // remainder, which is shorter than the minimum step, is still integrated
+    const time_type tfinal_late = 2*tfinal+4.95f*dt;
+    const time_type tlate = tfinal_late-0.05f*dt;
+    events = {{{0u, 0u}, tlate, 0.1f}};
+    group.enqueue_events(events);
+    group.advance(tfinal_late, dt);
+
+    step_times.clear();
+    group.advance(2*tfinal_late, dt);
+    ASSERT_FALSE(step_times.empty());
+    EXPECT_EQ(tfinal_late, step_times.front());
+}
+
+TEST(cell_group, memory_usage)
+{
+    using namespace nest::mc;
+
+    using cell_group_type = cell_group<fvm_cell>;
+    using time_type = cell_group_type::time_type;
+
+    auto cell = make_cell();
+    cell.add_synapse({1, 0.5}, parameter_list("expsyn"));
+    cell.add_probe({{0, 0}, probeKind::membrane_voltage});
+
+    auto group = cell_group_type{0, util::singleton_view(cell)};
+    auto before = group.memory_usage();
+
+    // the lowered cell state is included
+    EXPECT_GT(before.matrix, 0u);
+    EXPECT_GT(before.mechanisms, 0u);
+    EXPECT_GT(before.ions, 0u);
+    EXPECT_EQ(0u, before.connections);
+
+    // samplers and pending events are attributed to their components
+    group.add_sampler({0u, 0u}, [](time_type t, double) { return util::optional<time_type>(t+1); });
+    std::vector<postsynaptic_spike_event<time_type>> events(100, {{0u, 0u}, 10.f, 0.1f});
+    group.enqueue_events(events);
+
+    auto after = group.memory_usage();
+    EXPECT_GT(after.samplers, before.samplers);
+    EXPECT_GE(after.event_queues, before.event_queues+100*sizeof(events[0]));
+    EXPECT_EQ(before.matrix, after.matrix);
+    EXPECT_EQ(after.total(),
+        after.state+after.matrix+after.mechanisms+after.ions+after.event_queues+after.samplers);
+}
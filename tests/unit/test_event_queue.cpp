@@ -107,3 +107,78 @@ TEST(event_queue, pop_if_before)
     auto e6 = q.pop_if_before(100.);
     EXPECT_FALSE(e6);
 }
+
+TEST(event_queue, push_after_pop)
+{
+    using namespace nest::mc;
+    using ps_event_queue = event_queue<postsynaptic_spike_event<float>>;
+
+    ps_event_queue q;
+
+    q.push({{1u, 0u}, 3.f, 2.f});
+    q.push({{2u, 0u}, 1.f, 2.f});
+    q.push({{3u, 0u}, 5.f, 2.f});
+
+    auto e1 = q.pop_if_before(2.f);
+    EXPECT_TRUE(e1);
+    EXPECT_EQ(e1->time, 1.f);
+    EXPECT_EQ(q.size(), 2u);
+
+    // events pushed after a pop are merged with those not yet popped
+    postsynaptic_spike_event<float> events[] = {
+        {{4u, 0u}, 4.f, 2.f},
+        {{5u, 0u}, 2.f, 2.f},
+        {{6u, 0u}, 6.f, 2.f}
+    };
+    q.push(std::begin(events), std::end(events));
+    EXPECT_EQ(q.size(), 5u);
+
+    std::vector<float> times;
+    while (auto e = q.pop_if_before(std::numeric_limits<float>::max())) {
+        times.push_back(e->time);
+    }
+
+    std::vector<float> expected = {2.f, 3.f, 4.f, 5.f, 6.f};
+    EXPECT_EQ(expected, times);
+    EXPECT_EQ(q.size(), 0u);
+
+    q.push({{1u, 0u}, 3.f, 2.f});
+    q.clear();
+    EXPECT_EQ(q.size(), 0u);
+    EXPECT_FALSE(q.pop_if_before(100.f));
+}
+
+TEST(event_queue, pop_then_push_later)
+{
+    using namespace nest::mc;
+    using sample_event_queue = event_queue<sample_event<float>>;
+
+    // samplers that are popped when due, and pushed again one step later,
+    // as in cell_group::advance
+    sample_event_queue q;
+    for (unsigned i=0; i<10; ++i) {
+        q.push({i, float(i%3)});
+    }
+
+    std::vector<unsigned> order;
+    for (unsigned step=0; step<4; ++step) {
+        float t = step+0.5f;
+        while (auto e = q.pop_if_before(t)) {
+            EXPECT_LT(e->time, t);
+            EXPECT_GE(e->time, t-1);
+            order.push_back(e->sampler_index);
+            q.push({e->sampler_index, e->time+1});
+        }
+    }
+
+    // each step pops the samplers that are due, in order of time; events
+    // pushed later follow queued events with the same time
+    std::vector<unsigned> expected = {
+        0, 3, 6, 9,
+        1, 4, 7, 0, 3, 6, 9,
+        2, 5, 8, 1, 4, 7, 0, 3, 6, 9,
+        2, 5, 8, 1, 4, 7, 0, 3, 6, 9
+    };
+    EXPECT_EQ(expected, order);
+    EXPECT_EQ(10u, q.size());
+}
@@ -317,3 +317,351 @@ TEST(fvm_multi, mechanism_indexes)
         EXPECT_EQ(0u, fvcell.ion_ca().node_index().size());
     }
 }
+
+// test that the interleaved matrix layout is used for groups of similar cells,
+// and that it gives the same voltages as solving each cell on its own
+TEST(fvm_multi, interleaved_matrix)
+{
+    using namespace nest::mc;
+
+    // identical morphologies, with a different stimulus on each soma
+    const unsigned ncells = 8;
+    std::vector<cell> cells;
+    for (unsigned i=0; i<ncells; ++i) {
+        cells.push_back(make_cell_ball_and_3stick());
+        cells.back().add_stimulus({0, 0.5}, {0., 10., 0.05*(i+1)});
+    }
+
+    std::vector<fvm_cell::target_handle> targets;
+    std::vector<fvm_cell::detector_handle> detectors;
+    std::vector<fvm_cell::probe_handle> probes;
+
+    fvm_cell group;
+    group.initialize(cells, detectors, targets, probes);
+    EXPECT_TRUE(group.matrix_interleaved());
+
+    std::vector<fvm_cell> singles(ncells);
+    for (unsigned i=0; i<ncells; ++i) {
+        singles[i].initialize(util::singleton_view(cells[i]), detectors, targets, probes);
+        EXPECT_FALSE(singles[i].matrix_interleaved());
+    }
+
+    const double dt = 0.025;
+    for (unsigned step=0; step<200; ++step) {
+        group.advance(dt);
+        for (auto& c: singles) {
+            c.advance(dt);
+        }
+    }
+
+    auto ncomp = cells[0].num_compartments();
+    for (unsigned i=0; i<ncells; ++i) {
+        for (unsigned j=0; j<ncomp; ++j) {
+            EXPECT_NEAR(singles[i].voltage()[j], group.voltage()[i*ncomp+j], 1e-10);
+        }
+    }
+}
+
+// test that depth first numbering of compartments gives the same results
+// as numbering segment by segment
+TEST(fvm_multi, depth_first_numbering)
+{
+    using namespace nest::mc;
+
+    // the segments are numbered breadth first:
+    //
+    //          soma
+    //         /    \.
+    //        1      2
+    //       / \.
+    //      3   4
+    //
+    cell c;
+    auto soma = c.add_soma(12.6157/2.0);
+    soma->add_mechanism(hh_parameters());
+
+    c.add_cable(0, segmentKind::dendrite, 0.5, 0.5, 100);
+    c.add_cable(0, segmentKind::dendrite, 0.5, 0.5, 100);
+    c.add_cable(1, segmentKind::dendrite, 0.5, 0.5, 100);
+    c.add_cable(1, segmentKind::dendrite, 0.5, 0.5, 100);
+
+    for (auto& seg: c.segments()) {
+        seg->mechanism("membrane").set("r_L", 100);
+        if (seg->is_dendrite()) {
+            seg->set_compartments(4);
+        }
+    }
+    c.segment(2)->add_mechanism(pas_parameters());
+    c.segment(3)->add_mechanism(pas_parameters());
+
+    c.add_synapse({2, 0.5}, parameter_list("expsyn"));
+    c.add_synapse({3, 0.5}, parameter_list("expsyn"));
+    c.add_synapse({1, 0.5}, parameter_list("exp2syn"));
+    c.add_stimulus({3, 1}, {1., 20., 0.1});
+    c.add_detector({0, 0}, 0);
+    c.add_probe({{2, 0.5}, probeKind::membrane_voltage});
+    c.add_probe({{3, 1.0}, probeKind::membrane_voltage});
+    c.add_probe({{1, 0.5}, probeKind::membrane_current});
+
+    fvm_cell by_segment, depth_first;
+    depth_first.depth_first_numbering(true);
+
+    std::vector<fvm_cell::target_handle> targets[2] = {
+        std::vector<fvm_cell::target_handle>(3), std::vector<fvm_cell::target_handle>(3)};
+    std::vector<fvm_cell::detector_handle> detectors[2] = {
+        std::vector<fvm_cell::detector_handle>(1), std::vector<fvm_cell::detector_handle>(1)};
+    std::vector<fvm_cell::probe_handle> probes[2] = {
+        std::vector<fvm_cell::probe_handle>(3), std::vector<fvm_cell::probe_handle>(3)};
+
+    by_segment.initialize(util::singleton_view(c), detectors[0], targets[0], probes[0]);
+    depth_first.initialize(util::singleton_view(c), detectors[1], targets[1], probes[1]);
+
+    // segment 2 follows segments 3 and 4 in depth first order
+    EXPECT_EQ(by_segment.jacobian().size(), depth_first.jacobian().size());
+    EXPECT_NE(by_segment.probe(probes[0][0]), 0.);
+    EXPECT_NE(probes[0][0].second, probes[1][0].second);
+
+    by_segment.reset();
+    depth_first.reset();
+    for (auto i: util::make_span(0u, 3u)) {
+        by_segment.deliver_event(targets[0][i], 0.1);
+        depth_first.deliver_event(targets[1][i], 0.1);
+    }
+
+    for (unsigned step=0; step<400; ++step) {
+        by_segment.advance(0.025);
+        depth_first.advance(0.025);
+
+        EXPECT_NEAR(by_segment.detector_voltage(detectors[0][0]),
+            depth_first.detector_voltage(detectors[1][0]), 1e-10);
+        for (auto i: util::make_span(0u, 3u)) {
+            EXPECT_NEAR(by_segment.probe(probes[0][i]), depth_first.probe(probes[1][i]), 1e-10);
+        }
+    }
+}
+
+// test that the mixed precision backend, with single precision state and a
+// double precision matrix solve, stays close to the double precision backend
+TEST(fvm_multi, single_precision_state)
+{
+    using namespace nest::mc;
+    using fvm_cell_f32 = fvm::fvm_multicell<multicore::backend_f32>;
+
+    nest::mc::cell cell = make_cell_ball_and_3stick();
+    cell.add_synapse({1, 0.5}, parameter_list("expsyn"));
+
+    std::vector<fvm_cell::target_handle> targets(1);
+    std::vector<fvm_cell::detector_handle> detectors(cell.detectors().size());
+    std::vector<fvm_cell::probe_handle> probes(cell.probes().size());
+    fvm_cell fvcell;
+    fvcell.initialize(util::singleton_view(cell), detectors, targets, probes);
+
+    std::vector<fvm_cell_f32::target_handle> targets_f32(1);
+    std::vector<fvm_cell_f32::detector_handle> detectors_f32(cell.detectors().size());
+    std::vector<fvm_cell_f32::probe_handle> probes_f32(cell.probes().size());
+    fvm_cell_f32 fvcell_f32;
+    fvcell_f32.initialize(util::singleton_view(cell), detectors_f32, targets_f32, probes_f32);
+
+    EXPECT_EQ("cpu_f32", fvm_cell_f32::backend::name());
+    ASSERT_EQ(fvcell.size(), fvcell_f32.size());
+
+    fvcell.deliver_event(targets[0], 0.05);
+    fvcell_f32.deliver_event(targets_f32[0], 0.05f);
+
+    // the stimulus and the synapse drive the soma through an action
+    // potential, where the voltages differ the most
+    const double dt = 0.025;
+    double max_dv = 0;
+    for (unsigned step=0; step<800; ++step) {
+        fvcell.advance(dt);
+        fvcell_f32.advance(dt);
+
+        for (auto i: util::make_span(0u, fvcell.size())) {
+            max_dv = std::max(max_dv, std::abs(fvcell.voltage()[i]-double(fvcell_f32.voltage()[i])));
+        }
+    }
+    EXPECT_EQ(fvcell.time(), fvcell_f32.time());
+    EXPECT_LT(max_dv, 0.1);
+}
+
+// test that the state of the group is allocated from its arena, and that
+// the footprint of each component is reported
+TEST(fvm_multi, arena)
+{
+    using namespace nest::mc;
+
+    std::vector<cell> cells;
+    for (unsigned i=0; i<4; ++i) {
+        cells.push_back(make_cell_ball_and_3stick());
+        cells.back().add_synapse({1, 0.5}, parameter_list("expsyn"));
+    }
+
+    std::vector<fvm_cell::target_handle> targets(4);
+    std::vector<fvm_cell::detector_handle> detectors;
+    std::vector<fvm_cell::probe_handle> probes(4*cells[0].probes().size());
+
+    fvm_cell fvcell;
+    fvcell.initialize(cells, detectors, targets, probes);
+
+    const auto& arena = fvcell.arena();
+    const auto& usage = arena.usage();
+    for (auto component: {"state", "matrix", "mechanisms", "ions"}) {
+        EXPECT_EQ(1u, usage.count(component)) << component;
+    }
+
+    // voltage, current, cv areas, capacitance and face conductance
+    auto n = fvcell.size();
+    EXPECT_GE(usage.at("state"), 5*n*sizeof(fvm_cell::value_type));
+
+    EXPECT_EQ(arena.size(), usage.at("state")+usage.at("matrix")+usage.at("mechanisms")+usage.at("ions"));
+    EXPECT_LE(arena.size(), arena.capacity());
+
+    // the arena moves with the group
+    auto v = fvcell.voltage().data();
+    fvm_cell moved = std::move(fvcell);
+    EXPECT_EQ(v, moved.voltage().data());
+    EXPECT_EQ(4u, moved.arena().usage().size());
+}
+
+TEST(fvm_multi, memory_usage)
+{
+    using namespace nest::mc;
+
+    std::vector<cell> cells;
+    for (unsigned i=0; i<4; ++i) {
+        cells.push_back(make_cell_ball_and_3stick());
+        cells.back().add_synapse({1, 0.5}, parameter_list("expsyn"));
+    }
+
+    std::vector<fvm_cell::target_handle> targets(4);
+    std::vector<fvm_cell::detector_handle> detectors;
+    std::vector<fvm_cell::probe_handle> probes(4*cells[0].probes().size());
+
+    fvm_cell fvcell;
+    fvcell.initialize(cells, detectors, targets, probes);
+
+    // the lookup tables of the mechanisms, if any, are counted by the mechanism
+    std::size_t table_memory = 0;
+    for (const auto& mech: fvcell.mechanisms()) {
+        table_memory += mech->table_memory();
+        EXPECT_GE(mech->memory(), mech->table_memory());
+    }
+
+    // the components allocated from the arena are reported as allocated,
+    // and the tables of the mechanisms are outside the arena
+    auto m = fvcell.memory_usage();
+    const auto& usage = fvcell.arena().usage();
+    EXPECT_GE(m.state, usage.at("state"));
+    EXPECT_EQ(usage.at("matrix"), m.matrix);
+    EXPECT_EQ(usage.at("mechanisms")+table_memory, m.mechanisms);
+    EXPECT_EQ(usage.at("ions"), m.ions);
+
+    // the matrix and every mechanism and ion are no smaller than their arrays
+    EXPECT_GE(m.matrix, fvcell.jacobian().memory());
+    std::size_t mech_memory = 0;
+    for (const auto& mech: fvcell.mechanisms()) {
+        mech_memory += mech->memory();
+    }
+    EXPECT_GE(m.mechanisms, mech_memory);
+
+    // a lowered cell has no events, samplers or connections
+    EXPECT_EQ(0u, m.event_queues);
+    EXPECT_EQ(0u, m.samplers);
+    EXPECT_EQ(0u, m.connections);
+    EXPECT_EQ(m.state+m.matrix+m.mechanisms+m.ions, m.total());
+}
+
+TEST(fvm_multi, overwrite_current)
+{
+    using namespace nest::mc;
+
+    // pas is defined on every CV of the dendrites and on the soma CV, which
+    // is the parent of the dendrites
+    std::vector<cell> cells;
+    for (unsigned i=0; i<2; ++i) {
+        cells.push_back(make_cell_ball_and_3stick());
+        cells.back().add_synapse({1, 0.5}, parameter_list("expsyn"));
+    }
+
+    auto make_cell = [&cells](fvm_cell& fvcell) {
+        std::vector<fvm_cell::target_handle> targets(2);
+        std::vector<fvm_cell::detector_handle> detectors;
+        std::vector<fvm_cell::probe_handle> probes(2*cells[0].probes().size());
+        fvcell.initialize(cells, detectors, targets, probes);
+    };
+
+    fvm_cell fvcell, poisoned;
+    make_cell(fvcell);
+    make_cell(poisoned);
+
+    ASSERT_TRUE(fvcell.overwrite_current());
+    EXPECT_EQ("pas", fvcell.mechanisms().front()->name());
+
+    // the current is not read before it is written in a step
+    for (auto i: util::make_span(0, 10)) {
+        memory::fill(poisoned.current(), 1e6);
+        fvcell.advance(0.025);
+        poisoned.advance(0.025);
+        for (auto j: util::make_span(0u, fvcell.size())) {
+            EXPECT_EQ(fvcell.current()[j], poisoned.current()[j]) << "step " << i << " CV " << j;
+            EXPECT_EQ(fvcell.voltage()[j], poisoned.voltage()[j]) << "step " << i << " CV " << j;
+        }
+    }
+
+    // in a group of a soma with hh and a cell with pas on its dendrites,
+    // neither mechanism is defined on every CV
+    std::vector<cell> mixed;
+    mixed.push_back(make_cell_soma_only());
+    mixed.push_back(make_cell_ball_and_3stick());
+    std::vector<fvm_cell::target_handle> targets;
+    std::vector<fvm_cell::detector_handle> detectors;
+    std::vector<fvm_cell::probe_handle> probes(mixed[0].probes().size()+mixed[1].probes().size());
+    fvm_cell mixed_cell;
+    mixed_cell.initialize(mixed, detectors, targets, probes);
+    EXPECT_FALSE(mixed_cell.overwrite_current());
+}
+
+TEST(fvm_multi, index_runs)
+{
+    using namespace nest::mc;
+
+    // somas with hh, which are on consecutive CVs, and cells with pas
+    // on their dendrites
+    std::vector<cell> cells;
+    for (unsigned i=0; i<16; ++i) {
+        cells.push_back(make_cell_soma_only());
+    }
+    for (unsigned i=0; i<2; ++i) {
+        cells.push_back(make_cell_ball_and_3stick());
+    }
+
+    auto make_cell = [&cells](fvm_cell& fvcell) {
+        std::vector<fvm_cell::target_handle> targets;
+        std::vector<fvm_cell::detector_handle> detectors;
+        std::size_t n_probes = 0;
+        for (const auto& c: cells) {
+            n_probes += c.probes().size();
+        }
+        std::vector<fvm_cell::probe_handle> probes(n_probes);
+        fvcell.initialize(cells, detectors, targets, probes);
+    };
+
+    fvm_cell direct, indexed;
+    make_cell(direct);
+    make_cell(indexed);
+
+    // access the state of every mechanism through its node index
+    for (auto& m: indexed.mechanisms()) {
+        m->set_index_runs({});
+    }
+
+    // direct and indexed access compute the same currents and voltages
+    for (auto i: util::make_span(0, 100)) {
+        direct.advance(0.025);
+        indexed.advance(0.025);
+        for (auto j: util::make_span(0u, direct.size())) {
+            EXPECT_NEAR(indexed.current()[j], direct.current()[j], 1e-12) << "step " << i << " CV " << j;
+            EXPECT_NEAR(indexed.voltage()[j], direct.voltage()[j], 1e-10) << "step " << i << " CV " << j;
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include "../gtest.h"
+
+#include <numeric>
+#include <vector>
+
+#include <cell.hpp>
+#include <common_types.hpp>
+#include <communication/serial_global_policy.hpp>
+#include <load_balance.hpp>
+#include <recipe.hpp>
+
+#include "../test_common_cells.hpp"
+
+using namespace nest::mc;
+
+namespace {
+    // Recipe with cells of two sizes: every fourth cell is a ball and stick
+    // cell with a dendrite of many compartments, the rest are soma only.
+    class mixed_recipe: public recipe {
+    public:
+        mixed_recipe(cell_size_type n): ncells_(n) {}
+
+        cell_size_type num_cells() const override { return ncells_; }
+
+        cell get_cell(cell_gid_type gid) const override {
+            if (gid%4) {
+                return make_cell_soma_only(false);
+            }
+            auto c = make_cell_ball_and_stick(false);
+            c.segment(1)->set_compartments(100);
+            return c;
+        }
+
+        cell_count_info get_cell_count_info(cell_gid_type) const override {
+            return {1u, 0u, 0u};
+        }
+
+        std::vector<cell_connection> connections_on(cell_gid_type) const override {
+            return {};
+        }
+
+    private:
+        cell_size_type ncells_;
+    };
+
+    double sum(const std::vector<double>& v, cell_size_type b, cell_size_type e) {
+        return std::accumulate(v.begin()+b, v.begin()+e, 0.);
+    }
+}
+
+TEST(load_balance, partition_by_cost) {
+    using divs = std::vector<cell_size_type>;
+
+    // equal costs: equal sized parts
+    std::vector<double> costs(12, 1.);
+    EXPECT_EQ(divs({0, 12}), partition_by_cost(costs, 1));
+    EXPECT_EQ(divs({0, 4, 8, 12}), partition_by_cost(costs, 3));
+
+    // one expensive item gets a part of its own
+    costs = {10, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+    EXPECT_EQ(divs({0, 1, 11}), partition_by_cost(costs, 2));
+
+    // no empty parts, even when one item dominates
+    costs = {1, 100, 1, 1};
+    auto d = partition_by_cost(costs, 4);
+    EXPECT_EQ(divs({0, 1, 2, 3, 4}), d);
+
+    // more parts than items: trailing parts are empty
+    costs = {1, 1};
+    EXPECT_EQ(divs({0, 1, 2, 2}), partition_by_cost(costs, 3));
+
+    // no items
+    costs = {};
+    EXPECT_EQ(divs({0, 0, 0}), partition_by_cost(costs, 2));
+}
+
+TEST(load_balance, balance_cells) {
+    mixed_recipe rec(40);
+    auto costs = estimate_cell_costs(rec, 0, rec.num_cells());
+    ASSERT_EQ(40u, costs.size());
+    EXPECT_GT(costs[0], 10*costs[1]);
+
+    const unsigned num_domains = 3;
+    const cell_size_type group_size = 4;
+
+    cell_gid_type next = 0;
+    for (auto domain: util::make_span(0u, num_domains)) {
+        auto lb = balance_cells(costs, num_domains, domain, group_size);
+
+        // domains cover the cells contiguously
+        EXPECT_EQ(next, lb.cell_range.first);
+        next = lb.cell_range.second;
+
+        // groups cover the domain, with no empty groups
+        auto ncells = lb.cell_range.second-lb.cell_range.first;
+        auto ngroups = (ncells+group_size-1)/group_size;
+        ASSERT_EQ(ngroups+1, lb.group_divisions.size());
+        ASSERT_EQ(ngroups, lb.group_costs.size());
+        EXPECT_EQ(lb.cell_range.first, lb.group_divisions.front());
+        EXPECT_EQ(lb.cell_range.second, lb.group_divisions.back());
+        for (auto i: util::make_span(0u, ngroups)) {
+            EXPECT_LT(lb.group_divisions[i], lb.group_divisions[i+1]);
+            EXPECT_DOUBLE_EQ(
+                sum(costs, lb.group_divisions[i], lb.group_divisions[i+1]),
+                lb.group_costs[i]);
+        }
+
+        // the domain costs are within one large cell of an equal share
+        auto domain_cost = sum(costs, lb.cell_range.first, lb.cell_range.second);
+        EXPECT_NEAR(sum(costs, 0, costs.size())/num_domains, domain_cost, costs[0]);
+    }
+    EXPECT_EQ(rec.num_cells(), next);
+}
+
+TEST(load_balance, balance_recipe) {
+    mixed_recipe rec(40);
+    auto costs = estimate_cell_costs(rec, 0, rec.num_cells());
+    const cell_size_type group_size = 4;
+
+    // the costs gathered from the domains are those of the whole recipe
+    auto lb = balance_cells<communication::serial_global_policy>(rec, group_size);
+    auto expected = balance_cells(costs, 1, 0, group_size);
+    EXPECT_EQ(expected.cell_range, lb.cell_range);
+    EXPECT_EQ(expected.group_divisions, lb.group_divisions);
+    EXPECT_EQ(expected.group_costs, lb.group_costs);
+}
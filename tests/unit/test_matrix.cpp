@@ -1,4 +1,5 @@
 #include <numeric>
+#include <random>
 #include <vector>
 
 #include "../gtest.h"
@@ -74,3 +75,254 @@ TEST(matrix, solve_host)
         }
     }
 }
+
+TEST(matrix, assemble_and_solve)
+{
+    using namespace nest::mc;
+    using backend = multicore::backend;
+    using util::make_span;
+
+    // three cells of 1, 5 and 8 compartments, with branches
+    std::vector<size_type> p = {
+        0,
+        1, 1, 2, 3, 2,
+        6, 6, 7, 8, 7, 10, 8, 12};
+    std::vector<size_type> ci = {0, 1, 6, 14};
+    auto n = p.size();
+
+    std::vector<double> cv_capacitance(n), face_conductance(n), voltage(n), current(n);
+    for (auto i: make_span(0u, n)) {
+        cv_capacitance[i] = 0.5+0.1*i;
+        face_conductance[i] = 1.+0.05*i;
+        voltage[i] = -65.+i;
+        current[i] = 0.2*(i%3)-0.1;
+    }
+
+    backend::array cap = cv_capacitance, cond = face_conductance;
+    backend::array v = voltage, v_fused = voltage, i_m = current;
+
+    matrix_type m(p, ci);
+    backend::matrix_assembler assembler(
+        m.d(), m.u(), m.rhs(), m.p(), m.cell_index(), cap, cond, v, i_m);
+    assembler.assemble(0.025);
+    m.solve();
+    std::vector<double> expected(m.rhs().begin(), m.rhs().end());
+
+    // the fused assembler writes the solution over its voltage input
+    matrix_type m_fused(p, ci);
+    backend::matrix_assembler fused(
+        m_fused.d(), m_fused.u(), m_fused.rhs(), m_fused.p(), m_fused.cell_index(),
+        cap, cond, v_fused, i_m);
+    fused.assemble_and_solve(0.025, v_fused);
+
+    for (auto i: make_span(0u, n)) {
+        EXPECT_DOUBLE_EQ(expected[i], v_fused[i]);
+    }
+}
+
+TEST(matrix, assemble_single_precision)
+{
+    using namespace nest::mc;
+    using backend = multicore::backend;
+    using backend_f32 = multicore::backend_f32;
+    using util::make_span;
+
+    // a cell with a branch, with inputs that are exact in single precision
+    std::vector<size_type> p = {0, 0, 1, 2, 1, 4};
+    std::vector<size_type> ci = {0, 6};
+    auto n = p.size();
+
+    std::vector<double> cv_capacitance(n), face_conductance(n), voltage(n), current(n);
+    for (auto i: make_span(0u, n)) {
+        cv_capacitance[i] = 0.5+0.25*i;
+        face_conductance[i] = 1.+0.5*i;
+        voltage[i] = -65.+i;
+        current[i] = 0.125*(i%3);
+    }
+
+    backend::array cap = cv_capacitance, cond = face_conductance;
+    backend::array v = voltage, i_m = current;
+    matrix_type m(p, ci);
+    backend::matrix_assembler assembler(
+        m.d(), m.u(), m.rhs(), m.p(), m.cell_index(), cap, cond, v, i_m);
+
+    backend_f32::array cap_f32(n), cond_f32(n), v_f32(n), i_f32(n);
+    for (auto i: make_span(0u, n)) {
+        cap_f32[i] = cv_capacitance[i];
+        cond_f32[i] = face_conductance[i];
+        v_f32[i] = voltage[i];
+        i_f32[i] = current[i];
+    }
+    matrix<backend_f32> m_f32(p, ci);
+    backend_f32::matrix_assembler assembler_f32(
+        m_f32.d(), m_f32.u(), m_f32.rhs(), m_f32.p(), m_f32.cell_index(),
+        cap_f32, cond_f32, v_f32, i_f32);
+
+    // the single precision backend assembles the system with the double
+    // precision time step, which is not exact in single precision
+    const double dt = 0.025;
+    assembler.assemble(dt);
+    assembler_f32.assemble(dt);
+    for (auto i: make_span(0u, n)) {
+        EXPECT_EQ(assembler.d[i], assembler_f32.d[i]);
+        EXPECT_EQ(assembler.rhs[i], assembler_f32.rhs[i]);
+    }
+}
+
+TEST(matrix, interleaved_layout)
+{
+    using namespace nest::mc;
+
+    // cells of 2, 3 and 1 compartments, in blocks of two cells
+    std::vector<size_type> p = {0, 0, 2, 2, 3, 5};
+    std::vector<size_type> ci = {0, 2, 5, 6};
+    auto layout = multicore::make_interleaved_layout(p, ci, 2);
+    auto npos = layout.npos;
+
+    // the first block has the 3 and 2 compartment cells, the second has the
+    // 1 compartment cell and an empty lane
+    EXPECT_EQ(2u, layout.num_blocks());
+    EXPECT_EQ((std::vector<size_type>{0, 6, 8}), layout.block_divisions);
+    EXPECT_EQ(3u, layout.num_rows(0));
+    EXPECT_EQ(1u, layout.num_rows(1));
+
+    EXPECT_EQ((std::vector<size_type>{2, 0, 3, 1, 4, npos, 5, npos}), layout.cv);
+    EXPECT_EQ((std::vector<size_type>{1, 3, 0, 2, 4, 6}), layout.slot);
+    EXPECT_EQ((std::vector<size_type>{0, 1, 0, 1, 2, 3, 6, 7}), layout.parent);
+
+    // the rows after the first of the first block have their parents in one
+    // row, and the padding slot in the last of them takes its lane in the
+    // parent row as parent
+    EXPECT_EQ((std::vector<size_type>{npos, 0, 2, npos}), layout.row_parent);
+    EXPECT_DOUBLE_EQ(6./8., layout.efficiency());
+}
+
+TEST(matrix, assemble_and_solve_interleaved)
+{
+    using namespace nest::mc;
+    using backend = multicore::backend;
+    using util::make_span;
+
+    // cells of 5 to 13 compartments with different branching
+    std::vector<size_type> p, ci = {0};
+    for (auto c: make_span(0u, 11u)) {
+        auto first = ci.back();
+        auto ncomp = 5+(c*7)%9;
+        p.push_back(first);
+        for (auto i: make_span(1u, ncomp)) {
+            p.push_back(first + (i%(c%3+1)? i-1: i/2));
+        }
+        ci.push_back(first+ncomp);
+    }
+    auto n = p.size();
+
+    std::vector<double> cv_capacitance(n), face_conductance(n), voltage(n), current(n);
+    for (auto i: make_span(0u, n)) {
+        cv_capacitance[i] = 0.5+0.1*(i%7);
+        face_conductance[i] = 1.+0.05*(i%5);
+        voltage[i] = -65.+0.3*i;
+        current[i] = 0.2*(i%3)-0.1;
+    }
+
+    backend::array cap = cv_capacitance, cond = face_conductance;
+    backend::array v = voltage, v_interleaved = voltage, i_m = current;
+
+    matrix_type m(p, ci);
+    backend::matrix_assembler assembler(
+        m.d(), m.u(), m.rhs(), m.p(), m.cell_index(), cap, cond, v, i_m);
+    assembler.assemble_and_solve(0.025, v);
+
+    matrix_type m_interleaved(p, ci);
+    backend::matrix_assembler interleaved(
+        m_interleaved.d(), m_interleaved.u(), m_interleaved.rhs(),
+        m_interleaved.p(), m_interleaved.cell_index(),
+        cap, cond, v_interleaved, i_m);
+    interleaved.interleave(backend::matrix_assembler::make_layout(p, ci));
+    EXPECT_TRUE(interleaved.is_interleaved());
+    interleaved.assemble_and_solve(0.025, v_interleaved);
+
+    for (auto i: make_span(0u, n)) {
+        EXPECT_NEAR(v[i], v_interleaved[i], 1e-12);
+    }
+
+    // the flat assembly is still valid after interleaving, with the time
+    // step terms of the last step
+    assembler.assemble(0.025);
+    interleaved.assemble(0.025);
+    for (auto i: make_span(0u, n)) {
+        EXPECT_EQ(m.d()[i], m_interleaved.d()[i]);
+        EXPECT_NEAR(m.rhs()[i], m_interleaved.rhs()[i], 1e-9);
+    }
+}
+
+TEST(matrix, branch_decomposition)
+{
+    using namespace nest::mc;
+
+    // second cell of the combined parent index:
+    //
+    //          1
+    //         / \.
+    //        2   6
+    //       / \   \.
+    //      3   4   7
+    //          |
+    //          5
+    //
+    std::vector<size_type> p = {0, 1, 1, 2, 2, 4, 1, 6};
+    auto dec = multicore::make_branch_decomposition(p.data(), 1u, 8u, 2u);
+
+    EXPECT_EQ(1u, dec.first);
+    EXPECT_EQ(8u, dec.last);
+    EXPECT_EQ(3u, dec.num_subtrees());
+    EXPECT_EQ((std::vector<size_type>{0, 1, 3, 5}), dec.subtree_divisions);
+    EXPECT_EQ((std::vector<size_type>{3, 4, 5, 6, 7}), dec.subtree_nodes);
+    EXPECT_EQ((std::vector<size_type>{1, 2}), dec.reduced_nodes);
+}
+
+TEST(matrix, assemble_and_solve_decomposed)
+{
+    using namespace nest::mc;
+    using backend = multicore::backend;
+    using util::make_span;
+
+    // a small cell, and a large random tree
+    std::vector<size_type> p = {0, 0, 1}, ci = {0, 3};
+    std::mt19937 gen(7);
+    auto first = ci.back();
+    p.push_back(first);
+    for (auto i: make_span(1u, 3000u)) {
+        auto parent = std::uniform_int_distribution<size_type>(i>20? i-20: 0, i-1)(gen);
+        p.push_back(first+parent);
+    }
+    ci.push_back(p.size());
+    auto n = p.size();
+
+    std::vector<double> cv_capacitance(n), face_conductance(n), voltage(n), current(n);
+    for (auto i: make_span(0u, n)) {
+        cv_capacitance[i] = 0.5+0.1*(i%7);
+        face_conductance[i] = 1.+0.05*(i%5);
+        voltage[i] = -65.+0.01*i;
+        current[i] = 0.2*(i%3)-0.1;
+    }
+
+    backend::array cap = cv_capacitance, cond = face_conductance;
+    backend::array v = voltage, v_decomposed = voltage, i_m = current;
+
+    matrix_type m(p, ci);
+    backend::matrix_assembler assembler(
+        m.d(), m.u(), m.rhs(), m.p(), m.cell_index(), cap, cond, v, i_m);
+    assembler.assemble_and_solve(0.025, v);
+
+    matrix_type m_decomposed(p, ci);
+    backend::matrix_assembler decomposed(
+        m_decomposed.d(), m_decomposed.u(), m_decomposed.rhs(),
+        m_decomposed.p(), m_decomposed.cell_index(),
+        cap, cond, v_decomposed, i_m);
+    EXPECT_EQ(1u, decomposed.decompose_cells(1000));
+    decomposed.assemble_and_solve(0.025, v_decomposed);
+
+    for (auto i: make_span(0u, n)) {
+        EXPECT_NEAR(v[i], v_decomposed[i], 1e-10);
+    }
+}
@@ -0,0 +1,81 @@
+#include "../gtest.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <backends/fvm_multicore.hpp>
+#include <mechanism_catalogue.hpp>
+#include <memory/wrappers.hpp>
+
+using namespace nest::mc;
+
+// the catalogue of the pas mechanism, under the name pas_plugin, built by
+// build_catalogues in tests/unit/CMakeLists.txt
+static const std::string catalogue_dir = CATALOGUEDIR;
+static const std::string catalogue_path = catalogue_dir+"/pas_plugin.so";
+
+TEST(mechanism_catalogue, find) {
+    auto paths = find_catalogues("/nonexistent:"+catalogue_dir+":");
+    ASSERT_EQ(1u, paths.size());
+    EXPECT_EQ(catalogue_path, paths[0]);
+
+    EXPECT_TRUE(find_catalogues("").empty());
+}
+
+TEST(mechanism_catalogue, open) {
+    auto& catalogue = open_catalogue(catalogue_path);
+    EXPECT_EQ(unsigned(NMC_CATALOGUE_VERSION), catalogue.version);
+    ASSERT_EQ(2u, catalogue.size);
+    for (unsigned i=0; i<catalogue.size; ++i) {
+        EXPECT_EQ(std::string("pas_plugin"), catalogue.entries[i].name);
+    }
+
+    EXPECT_THROW(open_catalogue(catalogue_dir+"/dachshund.so"), std::runtime_error);
+}
+
+template <typename Backend>
+void check_plugin_currents() {
+    using value_type = typename Backend::value_type;
+    using size_type = typename Backend::size_type;
+
+    auto node_indices = std::vector<size_type>{0,1,2,3};
+    auto weights = std::vector<value_type>(node_indices.size(), 1.0);
+    auto n = node_indices.size();
+
+    typename Backend::array vec_v(n, -50.);
+    typename Backend::array vec_i_plugin(n, 0.);
+    typename Backend::array vec_i(n, 0.);
+
+    auto plugin = Backend::make_mechanism(
+        "pas_plugin", memory::make_view(vec_v), memory::make_view(vec_i_plugin), weights, node_indices);
+    auto pas = Backend::make_mechanism(
+        "pas", memory::make_view(vec_v), memory::make_view(vec_i), weights, node_indices);
+
+    EXPECT_EQ("pas_plugin", plugin->name());
+
+    for (auto m: {&plugin, &pas}) {
+        (*m)->set_params(0, 0.025);
+        (*m)->nrn_init();
+        (*m)->nrn_current();
+    }
+
+    for (auto i=0u; i<n; ++i) {
+        EXPECT_NE(0, vec_i[i]);
+        EXPECT_EQ(vec_i[i], vec_i_plugin[i]);
+    }
+}
+
+TEST(mechanism_catalogue, load) {
+    auto names = multicore::load_catalogues(catalogue_dir);
+    ASSERT_EQ(1u, names.size());
+    EXPECT_EQ("pas_plugin", names[0]);
+
+    EXPECT_TRUE(multicore::backend::has_mechanism("pas_plugin"));
+    EXPECT_TRUE(multicore::backend_f32::has_mechanism("pas_plugin"));
+
+    check_plugin_currents<multicore::backend>();
+    check_plugin_currents<multicore::backend_f32>();
+
+    EXPECT_THROW(multicore::load_catalogue(catalogue_dir+"/dachshund.so"), std::runtime_error);
+}
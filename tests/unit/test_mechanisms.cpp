@@ -6,6 +6,10 @@
 #include "mech_proto/hh.hpp"
 #include "mech_proto/pas.hpp"
 
+// Mechanisms only used in tests
+#include "mech_proto/hh_table.hpp"
+#include "mech_proto/markov.hpp"
+
 // modcc generated mechanisms
 #include "mechanisms/multicore/expsyn.hpp"
 #include "mechanisms/multicore/exp2syn.hpp"
@@ -13,12 +17,16 @@
 #include "mechanisms/multicore/pas.hpp"
 
 #include <initializer_list>
+#include <map>
+#include <numeric>
+#include <string>
 #include <backends/fvm_multicore.hpp>
 #include <ion.hpp>
 #include <matrix.hpp>
 #include <memory/wrappers.hpp>
 #include <util/rangeutil.hpp>
 #include <util/cycle.hpp>
+#include <util/span.hpp>
 
 TEST(mechanisms, helpers) {
     using namespace nest::mc;
@@ -50,6 +58,198 @@ TEST(mechanisms, helpers) {
     );
 }
 
+TEST(mechanisms, table) {
+    using namespace nest::mc;
+    using backend = multicore::backend;
+    using value_type = backend::value_type;
+    using table_type = mechanisms::hh_table::mechanism_hh_table<backend>;
+    using exact_type = mechanisms::hh::mechanism_hh<backend>;
+
+    auto n = 4u;
+    backend::array vec_i(n, 0.);
+    backend::array vec_v(n);
+    backend::iarray node_index(n);
+    for (auto i=0u; i<n; ++i) {
+        vec_v[i] = -80.+30.*i;
+        node_index[i] = i;
+    }
+
+    // the rates of hh_table are interpolated from a table, which is built
+    // and checked against the exact rates in nrn_init
+    auto hh = mechanisms::make_mechanism<table_type>(
+        vec_v, vec_i, backend::array(n, 1.), backend::iarray(node_index));
+    EXPECT_EQ(0, hh->table_error());
+    EXPECT_EQ(0u, hh->table_memory());
+    hh->nrn_init();
+    EXPECT_GT(hh->table_error(), 0);
+    EXPECT_LT(hh->table_error(), 1e-3);
+    EXPECT_LT(0u, hh->table_memory());
+
+    // building the table leaves the state of every instance to the rates
+    // at its own voltage, which agree with the exact rates of hh
+    auto exact = mechanisms::make_mechanism<exact_type>(
+        vec_v, vec_i, backend::array(n, 1.), backend::iarray(node_index));
+    exact->nrn_init();
+    EXPECT_EQ(0, exact->table_error());
+    EXPECT_EQ(0u, exact->table_memory());
+    for (auto i=0u; i<n; ++i) {
+        value_type tol = 1e-3;
+        EXPECT_NEAR(exact->m[i], hh->m[i], tol);
+        EXPECT_NEAR(exact->h[i], hh->h[i], tol);
+        EXPECT_NEAR(exact->n[i], hh->n[i], tol);
+    }
+
+    // mechanisms without tables are exact
+    auto pas = mechanisms::make_mechanism<mechanisms::pas::mechanism_pas<backend>>(
+        vec_v, vec_i, backend::array(n, 1.), backend::iarray(node_index));
+    pas->nrn_init();
+    EXPECT_EQ(0, pas->table_error());
+}
+
+TEST(mechanisms, kinetic_sparse) {
+    using namespace nest::mc;
+    using backend = multicore::backend;
+    using mechanism_type = mechanisms::markov::mechanism_markov<backend>;
+
+    // the scheme c1 <-> c2 <-> o has the rates (2, 1) and (3, 4), so that
+    // its steady state is c1 = 2/9, c2 = 4/9 and o = 1/3
+    auto n = 4u;
+    backend::array vec_v(n, -65.);
+    backend::array vec_i(n, 0.);
+    backend::iarray node_index(n);
+    for (auto i=0u; i<n; ++i) {
+        node_index[i] = i;
+    }
+
+    auto make_markov = [&]() {
+        return mechanisms::make_mechanism<mechanism_type>(
+            vec_v, vec_i, backend::array(n, 1.), backend::iarray(node_index));
+    };
+    auto states = [](const mechanism_type& m, unsigned i) {
+        return std::vector<double>{m.c1[i], m.c2[i], m.o[i]};
+    };
+
+    // the total of the species is conserved by each step, and the species
+    // converge to the steady state
+    auto markov = make_markov();
+    markov->set_params(0, 0.025);
+    markov->nrn_init();
+    for (auto step=0; step<2000; ++step) {
+        markov->nrn_state();
+        auto s = states(*markov, step%n);
+        EXPECT_NEAR(1., s[0]+s[1]+s[2], 1e-12);
+    }
+    for (auto i=0u; i<n; ++i) {
+        auto s = states(*markov, i);
+        EXPECT_NEAR(2./9., s[0], 1e-12);
+        EXPECT_NEAR(4./9., s[1], 1e-12);
+        EXPECT_NEAR(1./3., s[2], 1e-12);
+    }
+
+    // the backward Euler steps are stable for time steps that are much
+    // longer than the time constants of the scheme
+    auto stiff = make_markov();
+    stiff->set_params(0, 100);
+    stiff->nrn_init();
+    for (auto step=0; step<10; ++step) {
+        stiff->nrn_state();
+        for (auto x: states(*stiff, 0)) {
+            EXPECT_LE(0., x);
+            EXPECT_GE(1., x);
+        }
+    }
+    auto s = states(*stiff, 0);
+    EXPECT_NEAR(1., s[0]+s[1]+s[2], 1e-12);
+    EXPECT_NEAR(1./3., s[2], 1e-6);
+}
+
+// The state of a density mechanism on the CVs node_index of a cell with n
+// CVs, with its own voltage, current and ions.
+struct density_state {
+    using backend = nest::mc::multicore::backend;
+    using size_type = backend::size_type;
+    using value_type = backend::value_type;
+    using ion_type = nest::mc::mechanisms::ion<backend>;
+
+    backend::array vec_v;
+    backend::array vec_i;
+    std::map<nest::mc::mechanisms::ionKind, ion_type> ions;
+    nest::mc::mechanisms::mechanism_ptr<backend> mech;
+
+    density_state(const std::string& name, std::size_t n, const std::vector<size_type>& node_index):
+        vec_v(n), vec_i(n, 0.)
+    {
+        using namespace nest::mc;
+
+        // the voltages avoid the removable singularities of the rates of hh
+        // at -40 and -55 mV
+        for (auto i=0u; i<n; ++i) {
+            vec_v[i] = -80.5+i;
+        }
+        auto weights = std::vector<value_type>(node_index.size(), 1.0);
+        mech = backend::make_mechanism(
+            name, memory::make_view(vec_v), memory::make_view(vec_i), weights, node_index);
+
+        std::vector<size_type> ion_index(node_index.size());
+        std::iota(ion_index.begin(), ion_index.end(), 0);
+        for (auto kind: mechanisms::ion_kinds()) {
+            if (mech->uses_ion(kind)) {
+                ions[kind] = node_index;
+                memory::fill(ions[kind].reversal_potential(), 50.);
+                memory::fill(ions[kind].internal_concentration(), 10.);
+                memory::fill(ions[kind].external_concentration(), 140.);
+                mech->set_ion(kind, ions[kind], ion_index);
+            }
+        }
+    }
+};
+
+TEST(mechanisms, index_runs) {
+    using namespace nest::mc;
+    using size_type = density_state::size_type;
+
+    // two runs of consecutive CVs, of lengths that are not multiples of the
+    // vector width, separated by CVs without the mechanism
+    std::vector<size_type> node_index;
+    for (auto i: util::make_span(3u, 22u)) node_index.push_back(i);
+    for (auto i: util::make_span(30u, 47u)) node_index.push_back(i);
+    std::vector<size_type> runs = {0, 19, 36};
+    auto n = 50u;
+
+    for (auto name: {"pas", "hh"}) {
+        density_state direct(name, n, node_index);
+        density_state indexed(name, n, node_index);
+        EXPECT_TRUE(direct.mech->set_index_runs(runs)) << name;
+
+        for (auto s: {&direct, &indexed}) {
+            s->mech->set_params(0, 0.025);
+            s->mech->nrn_init();
+        }
+
+        // the kernels that access the CV state directly over the runs
+        // compute the same currents as the kernels that use the node index
+        for (auto step=0; step<100; ++step) {
+            for (auto s: {&direct, &indexed}) {
+                memory::fill(s->vec_i, 0.);
+                for (auto& ion: s->ions) {
+                    memory::fill(ion.second.current(), 0.);
+                }
+                s->mech->nrn_current();
+                s->mech->nrn_state();
+            }
+            for (auto i=0u; i<n; ++i) {
+                EXPECT_DOUBLE_EQ(indexed.vec_i[i], direct.vec_i[i]) << name << " step " << step << " CV " << i;
+            }
+            for (auto& ion: direct.ions) {
+                auto& expected = indexed.ions[ion.first];
+                for (auto i=0u; i<ion.second.size(); ++i) {
+                    EXPECT_DOUBLE_EQ(expected.current()[i], ion.second.current()[i]) << name << " step " << step;
+                }
+            }
+        }
+    }
+}
+
 // Setup and update mechanism
 template<typename T>
 void mech_update(T* mech, int num_iters) {
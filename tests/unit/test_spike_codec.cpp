@@ -0,0 +1,178 @@
+#include "../gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <communication/communicator.hpp>
+#include <communication/packed_global_policy.hpp>
+#include <communication/serial_global_policy.hpp>
+#include <communication/spike_codec.hpp>
+#include <spike.hpp>
+
+using namespace nest::mc;
+
+using time_type = float;
+using spike_type = spike<cell_member_type, time_type>;
+using codec_type = communication::spike_codec<time_type>;
+
+namespace {
+    std::vector<spike_type> sort_by_source(std::vector<spike_type> spikes) {
+        std::sort(spikes.begin(), spikes.end(),
+            [](const spike_type& l, const spike_type& r) { return l.source<r.source; });
+        return spikes;
+    }
+
+    std::vector<spike_type> random_spikes(std::size_t n, cell_gid_type max_gid) {
+        std::mt19937 gen;
+        std::uniform_int_distribution<cell_gid_type> gid(0, max_gid);
+        std::uniform_int_distribution<cell_lid_type> index(0, 300);
+        std::uniform_real_distribution<time_type> time(10, 15);
+
+        std::vector<spike_type> spikes;
+        for (std::size_t i=0; i<n; ++i) {
+            spikes.push_back({{gid(gen), index(gen)}, time(gen)});
+        }
+        return spikes;
+    }
+}
+
+TEST(spike_codec, round_trip) {
+    codec_type codec;
+
+    // empty block
+    {
+        std::vector<char> buf;
+        codec.encode({}, buf);
+        EXPECT_EQ(1u, buf.size());
+
+        std::vector<spike_type> out;
+        EXPECT_EQ(buf.data()+buf.size(), codec.decode(buf.data(), buf.data()+buf.size(), out));
+        EXPECT_TRUE(out.empty());
+    }
+
+    // lossless: identical spikes, in source order
+    {
+        auto spikes = random_spikes(1000, 1u<<30);
+        spikes.push_back({{0u, 0u}, 0.f});
+        spikes.push_back({{cell_gid_type(-1), cell_lid_type(-1)}, 1e6f});
+
+        std::vector<char> buf;
+        codec.encode(spikes, buf);
+
+        std::vector<spike_type> out;
+        EXPECT_EQ(buf.data()+buf.size(), codec.decode(buf.data(), buf.data()+buf.size(), out));
+
+        auto expected = sort_by_source(spikes);
+        ASSERT_EQ(expected.size(), out.size());
+        for (std::size_t i=0; i<out.size(); ++i) {
+            EXPECT_EQ(expected[i].source, out[i].source);
+            EXPECT_EQ(expected[i].time, out[i].time);
+        }
+    }
+
+    // lossless blocks store no base time: one spike needs one byte for each
+    // of the count, gid, gid difference and index, and the time
+    {
+        std::vector<char> buf;
+        codec.encode({{{5u, 1u}, 12.5f}}, buf);
+        EXPECT_EQ(4+sizeof(time_type), buf.size());
+
+        std::vector<spike_type> out;
+        codec.decode(buf.data(), buf.data()+buf.size(), out);
+        ASSERT_EQ(1u, out.size());
+        EXPECT_EQ(cell_member_type({5u, 1u}), out[0].source);
+        EXPECT_EQ(12.5f, out[0].time);
+    }
+
+    // consecutive blocks in one buffer
+    {
+        auto a = random_spikes(10, 100);
+        auto b = random_spikes(20, 1000);
+
+        std::vector<char> buf;
+        codec.encode(a, buf);
+        codec.encode(b, buf);
+
+        std::vector<spike_type> out;
+        auto p = codec.decode(buf.data(), buf.data()+buf.size(), out);
+        EXPECT_EQ(a.size(), out.size());
+        p = codec.decode(p, buf.data()+buf.size(), out);
+        EXPECT_EQ(buf.data()+buf.size(), p);
+        EXPECT_EQ(a.size()+b.size(), out.size());
+    }
+}
+
+TEST(spike_codec, quantized_time) {
+    const time_type quantum = 1e-3;
+    codec_type codec(quantum);
+
+    auto spikes = random_spikes(1000, 10000);
+    std::vector<char> buf;
+    codec.encode(spikes, buf);
+
+    std::vector<spike_type> out;
+    codec.decode(buf.data(), buf.data()+buf.size(), out);
+
+    auto expected = sort_by_source(spikes);
+    ASSERT_EQ(expected.size(), out.size());
+    for (std::size_t i=0; i<out.size(); ++i) {
+        EXPECT_EQ(expected[i].source, out[i].source);
+        // allow for rounding error in single precision at t~15 ms
+        EXPECT_NEAR(expected[i].time, out[i].time, quantum/2+1e-5);
+    }
+
+    // gids less than 128 apart, indexes less than 2^14 and times within
+    // 2^14 quanta need at most 5 bytes per spike, against 12 bytes for the
+    // spike struct
+    EXPECT_LE(buf.size(), 5*spikes.size()+16);
+}
+
+TEST(spike_codec, packed_policy) {
+    communication::packed_global_policy<communication::serial_global_policy> policy;
+
+    auto spikes = random_spikes(100, 1000);
+    auto gathered = policy.gather_spikes(spikes);
+
+    EXPECT_EQ(std::vector<unsigned>({0u, 100u}), gathered.partition());
+
+    auto expected = sort_by_source(spikes);
+    auto values = sort_by_source(gathered.values());
+    ASSERT_EQ(expected.size(), values.size());
+    for (std::size_t i=0; i<values.size(); ++i) {
+        EXPECT_EQ(expected[i].source, values[i].source);
+        EXPECT_EQ(expected[i].time, values[i].time);
+    }
+    EXPECT_GT(policy.bytes_sent(), 0u);
+    EXPECT_LT(policy.bytes_sent(), sizeof(spike_type)*spikes.size());
+}
+
+TEST(spike_codec, time_quantum) {
+    using packed_policy = communication::packed_global_policy<communication::serial_global_policy>;
+
+    // the communicator sets the quantum of policies that encode spike times
+    communication::communicator<time_type, packed_policy> packed;
+    EXPECT_TRUE(packed.set_spike_time_quantum(0.025));
+    EXPECT_EQ(0.025, packed.communication_policy().time_quantum());
+
+    communication::communicator<time_type, communication::serial_global_policy> exact;
+    EXPECT_FALSE(exact.set_spike_time_quantum(0.025));
+
+    // quantized times are exchanged in fewer bytes
+    packed_policy lossless, quantized;
+    quantized.set_time_quantum(0.025);
+
+    auto spikes = random_spikes(100, 1000);
+    lossless.gather_spikes(spikes);
+    auto gathered = quantized.gather_spikes(spikes);
+    EXPECT_LT(quantized.bytes_sent(), lossless.bytes_sent());
+
+    auto expected = sort_by_source(spikes);
+    auto values = sort_by_source(gathered.values());
+    ASSERT_EQ(expected.size(), values.size());
+    for (std::size_t i=0; i<values.size(); ++i) {
+        EXPECT_EQ(expected[i].source, values[i].source);
+        EXPECT_NEAR(expected[i].time, values[i].time, 0.0125+1e-5);
+    }
+}
@@ -94,6 +94,15 @@ TEST(synapses, expsyn_basic_state)
     ptr->net_receive(3, 1.04);
     EXPECT_EQ(ptr->g[1], 3.14);
     EXPECT_EQ(ptr->g[3], 1.04);
+
+    // deliver a batch of events, with two events for the same synapse
+    std::vector<size_type> event_index = {0, 3, 3};
+    std::vector<value_type> event_weight = {0.5, 1.0, 2.0};
+    ptr->net_receive_batch(event_index.data(), event_weight.data(), event_index.size());
+    EXPECT_EQ(ptr->g[0], 0.5);
+    EXPECT_EQ(ptr->g[1], 3.14);
+    EXPECT_EQ(ptr->g[2], 0.);
+    EXPECT_NEAR(ptr->g[3], 4.04, 1e-12);
 }
 
 TEST(synapses, exp2syn_basic_state)
@@ -152,4 +161,13 @@ TEST(synapses, exp2syn_basic_state)
 
     EXPECT_NEAR(ptr->A[1], ptr->factor[1]*3.14, 1e-6);
     EXPECT_NEAR(ptr->B[3], ptr->factor[3]*1.04, 1e-6);
+
+    // deliver a batch of events, with two events for the same synapse
+    std::vector<size_type> event_index = {1, 1, 2};
+    std::vector<value_type> event_weight = {0.5, 1.0, 2.0};
+    ptr->net_receive_batch(event_index.data(), event_weight.data(), event_index.size());
+    EXPECT_NEAR(ptr->A[1], ptr->factor[1]*4.64, 1e-6);
+    EXPECT_NEAR(ptr->B[1], ptr->factor[1]*4.64, 1e-6);
+    EXPECT_NEAR(ptr->A[2], ptr->factor[2]*2.0, 1e-6);
+    EXPECT_EQ(ptr->A[0], 0.);
 }
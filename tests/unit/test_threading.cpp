@@ -0,0 +1,101 @@
+#include "../gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <threading/threading.hpp>
+
+using namespace nest::mc;
+
+TEST(threading, parallel_for) {
+    const int n = 10000;
+    std::vector<int> v(n, 0);
+
+    threading::parallel_for::apply(0, n, [&](int i) { v[i] += i; });
+    for (int i=0; i<n; ++i) {
+        EXPECT_EQ(i, v[i]);
+    }
+
+    // empty range
+    threading::parallel_for::apply(5, 5, [&](int i) { v[i] = -1; });
+    EXPECT_EQ(5, v[5]);
+}
+
+TEST(threading, nested_parallel_for) {
+    const int n = 50;
+    std::vector<std::atomic<int>> counts(n);
+    for (auto& c: counts) {
+        c = 0;
+    }
+
+    threading::parallel_for::apply(0, n,
+        [&](int i) {
+            threading::parallel_for::apply(0, n, [&](int j) { ++counts[j]; });
+        });
+
+    for (auto& c: counts) {
+        EXPECT_EQ(n, c);
+    }
+}
+
+TEST(threading, task_group) {
+    std::atomic<int> count(0);
+
+    threading::task_group g;
+    for (int i=0; i<100; ++i) {
+        g.run([&]() { ++count; });
+    }
+    g.wait();
+    EXPECT_EQ(100, count);
+
+    // task groups can be reused after wait
+    g.run_and_wait([&]() { ++count; });
+    EXPECT_EQ(101, count);
+}
+
+TEST(threading, enumerable_thread_specific) {
+    threading::enumerable_thread_specific<long> partial(0);
+
+    const int n = 10000;
+    threading::parallel_for::apply(0, n, [&](int i) { partial.local() += i; });
+
+    EXPECT_EQ(long(n)*(n-1)/2, std::accumulate(partial.begin(), partial.end(), 0l));
+}
+
+TEST(threading, parallel_vector) {
+    threading::parallel_vector<int> v;
+
+    const int n = 1000;
+    threading::parallel_for::apply(0, n, [&](int i) { v.push_back(i); });
+
+    std::vector<int> sorted(v.begin(), v.end());
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_EQ(std::size_t(n), sorted.size());
+    for (int i=0; i<n; ++i) {
+        EXPECT_EQ(i, sorted[i]);
+    }
+}
+
+TEST(threading, sort) {
+    std::mt19937 gen;
+    std::uniform_int_distribution<int> dist(0, 1000);
+
+    // large enough to be sorted in parallel by the multithreaded backends
+    std::vector<int> v(100000);
+    for (auto& x: v) {
+        x = dist(gen);
+    }
+    auto expected = v;
+    std::sort(expected.begin(), expected.end());
+
+    threading::sort(v);
+    EXPECT_EQ(expected, v);
+
+    threading::sort(v.begin(), v.end(), [](int l, int r) { return l>r; });
+    std::reverse(expected.begin(), expected.end());
+    EXPECT_EQ(expected, v);
+}
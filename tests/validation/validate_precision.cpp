@@ -0,0 +1,136 @@
+#include <cmath>
+#include <iostream>
+
+#include <json/json.hpp>
+
+#include <cell.hpp>
+#include <common_types.hpp>
+#include <fvm_multicell.hpp>
+#include <model.hpp>
+#include <recipe.hpp>
+#include <simple_sampler.hpp>
+#include <util/rangeutil.hpp>
+
+#include "../gtest.h"
+
+#include "../test_common_cells.hpp"
+#include "convergence_test.hpp"
+#include "trace_analysis.hpp"
+#include "validation_data.hpp"
+
+/*
+ * Quantify the accuracy of the mixed precision multicore backend, which
+ * stores cell and mechanism state in single precision, by comparing its
+ * traces with those of the double precision backend for the same model,
+ * over a range of time steps.
+ *
+ * The double precision traces are the reference, so these tests do not
+ * need reference data. The time steps are exact in binary, so that the
+ * step times, which the single precision mechanisms see rounded to float,
+ * are the same in both models: with dt = 0.01 ms a stimulus can start one
+ * step earlier in single precision.
+ */
+
+using lowered_cell = nest::mc::fvm::fvm_multicell<nest::mc::multicore::backend>;
+using lowered_cell_f32 = nest::mc::fvm::fvm_multicell<nest::mc::multicore::backend_f32>;
+
+template <typename SamplerInfoSeq>
+void run_precision_test(
+    const char* model_name,
+    const nest::mc::cell& c,
+    SamplerInfoSeq& samplers,
+    double max_linf,
+    float t_end=100.f)
+{
+    using namespace nest::mc;
+
+    nlohmann::json meta = {
+        {"name", "membrane voltage"},
+        {"model", model_name},
+        {"sim", "nestmc"},
+        {"units", "mV"},
+        {"backend", lowered_cell_f32::backend::name()}
+    };
+
+    auto exclude = stimulus_ends(c);
+
+    model<lowered_cell> m(singleton_recipe{c});
+    model<lowered_cell_f32> m_f32(singleton_recipe{c});
+
+    conv_data<float> tbl;
+    for (float dt: {1/16.f, 1/32.f, 1/128.f}) {
+        if (dt<g_trace_io.min_dt()) break;
+
+        std::vector<trace_data> ref;
+        for (auto& se: samplers) {
+            se.sampler.reset();
+            m.attach_sampler(se.probe, se.sampler.template sampler<>());
+        }
+        m.reset();
+        m.run(t_end, dt);
+        for (auto& se: samplers) {
+            ref.push_back(se.sampler.trace);
+        }
+
+        for (auto& se: samplers) {
+            se.sampler.reset();
+            m_f32.attach_sampler(se.probe, se.sampler.template sampler<>());
+        }
+        m_f32.reset();
+        m_f32.run(t_end, dt);
+
+        auto r = ref.begin();
+        for (const auto& se: samplers) {
+            const auto& trace = se.sampler.trace;
+
+            nlohmann::json trace_meta(meta);
+            trace_meta["dt"] = dt;
+            g_trace_io.save_trace(se.label, trace, trace_meta);
+
+            tbl.push_back({se.label, dt, linf_distance(trace, *r, exclude), peak_delta(trace, *r)});
+            ++r;
+        }
+    }
+
+    if (g_trace_io.verbose()) {
+        std::cout << model_name << ": single precision state vs double precision\n";
+        report_conv_table(std::cout, tbl, "dt");
+    }
+
+    // the same spikes, with at most the voltage error max_linf between them
+    for (const auto& e: tbl) {
+        SCOPED_TRACE(e.id);
+        EXPECT_LE(e.linf, max_linf);
+        ASSERT_TRUE(e.peak_delta);
+        EXPECT_LE(std::abs(e.peak_delta->t), e.peak_delta->t_err+e.param);
+    }
+}
+
+TEST(soma, single_precision)
+{
+    using namespace nest::mc;
+
+    cell c = make_cell_soma_only();
+    add_common_voltage_probes(c);
+
+    sampler_info samplers[] = {{"soma.mid", {0u, 0u}, simple_sampler(0.025f)}};
+
+    run_precision_test("soma", c, samplers, 0.1);
+}
+
+TEST(ball_and_3stick, single_precision)
+{
+    using namespace nest::mc;
+
+    cell c = make_cell_ball_and_3stick();
+    add_common_voltage_probes(c);
+
+    float sample_dt = 0.025f;
+    sampler_info samplers[] = {
+        {"soma.mid", {0u, 0u}, simple_sampler(sample_dt)},
+        {"dend1.mid", {0u, 1u}, simple_sampler(sample_dt)},
+        {"dend1.end", {0u, 2u}, simple_sampler(sample_dt)}
+    };
+
+    run_precision_test("ball_and_3stick", c, samplers, 0.1);
+}